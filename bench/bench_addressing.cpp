@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include <address_modes.h>
+
+#include "hosts.h"
+
+//Cost of resolving one operand through CPU::ExecuteAddressing, the virtual Addr_* entry point.
+//
+//Memory is filled with $80 : every operand, pointer and branch offset is valid wherever the PC
+//wanders. Each call reads its operand at the PC and moves it past, as it would in an instruction.
+
+namespace {
+
+    template<AddressMode addrMode>
+    void Addressing(benchmark::State& state) {
+        AdapterHost host;
+        static_pointer_cast<Memory>(host.m_Memory)->Clear(0x80);
+        Start(host, 0x0000);
+
+        //Indexed modes stay on their page : $8080 + $10
+        Registers registers = host.m_Core.GetRegisters();
+        registers.m_X = 0x10;
+        registers.m_Y = 0x10;
+        host.m_Core.SetRegisters(registers);
+
+        Byte cycles = 0;
+        for(auto _ : state) {
+            const address addr = host.m_Core.ExecuteAddressing(addrMode, cycles);
+            benchmark::DoNotOptimize(addr);
+        }
+        benchmark::DoNotOptimize(cycles);
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ACC);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::IMP);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::IMM);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ABS);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ABX);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ABY);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ZPG);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ZPX);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::ZPY);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::IND);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::INX);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::INY);
+BENCHMARK_TEMPLATE(Addressing, AddressMode::REL);
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <io_device.h>
+#include <memory.h>
+#include <bus.h>
+
+using namespace std;
+
+//ReadByte / WriteByte through an io_ptr : the virtual call every device access of the CPU adapter pays.
+//The address walks the whole 64KB, one byte after the other.
+
+namespace {
+
+    IODevice::io_ptr MakeMemory() { return Memory::Make(); }
+
+    //RAM pages : the Bus reads and writes through the page table
+    IODevice::io_ptr MakeRamBus() {
+        shared_ptr<Bus> bus = Bus::Make();
+        bus->MapMemory(0x00, 256, Memory::Make());
+        return bus;
+    }
+
+    //Device pages : the Bus forwards every access to the device, a second virtual call
+    IODevice::io_ptr MakeDeviceBus() {
+        shared_ptr<Bus> bus = Bus::Make();
+        bus->MapDevice(0x00, 256, Memory::Make());
+        return bus;
+    }
+
+    void ReadByte(benchmark::State& state, IODevice::io_ptr (*make)()) {
+        const IODevice::io_ptr device = make();
+        Word addr = 0;
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(device->ReadByte(addr++));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void WriteByte(benchmark::State& state, IODevice::io_ptr (*make)()) {
+        const IODevice::io_ptr device = make();
+        Word addr = 0;
+        for(auto _ : state) {
+            device->WriteByte(addr, static_cast<Byte>(addr));
+            addr++;
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK_CAPTURE(ReadByte, memory, MakeMemory);
+BENCHMARK_CAPTURE(ReadByte, bus_ram, MakeRamBus);
+BENCHMARK_CAPTURE(ReadByte, bus_device, MakeDeviceBus);
+
+BENCHMARK_CAPTURE(WriteByte, memory, MakeMemory);
+BENCHMARK_CAPTURE(WriteByte, bus_ram, MakeRamBus);
+BENCHMARK_CAPTURE(WriteByte, bus_device, MakeDeviceBus);
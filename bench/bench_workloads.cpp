@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opcodes.h>
+#include <utils.h>
+
+#include "hosts.h"
+#include "workloads.h"
+
+//End-to-end throughput of every core on whole programs, reported as counters :
+//  instructions    guest instructions per second : MIPS, once in millions
+//  cycles          guest cycles per second : the speed in MHz the core emulates, once in millions
+//  CPI             guest cycles per instruction, over the iterations run : they stop at another point of the
+//                  program for every core, so it differs slightly between them
+//
+//Before timing, a workload checks that Run(SLICE) on the core retires SLICE instructions and counts the cycles
+//the interpreter does when stepped through them : the counters are then the core's own.
+//
+//Klaus Dormann's 6502_functional_test.bin (64KB image, entry point $0400) isn't part of the tree.
+//When EMU6502_FUNCTIONAL_TEST names it, a run from reset to its success trap is benchmarked too.
+//EMU6502_FUNCTIONAL_TEST_SUCCESS gives the trap address, in hex, of a build other than the published one.
+
+namespace {
+
+    //Instructions per benchmark iteration of the looping workloads
+    constexpr uint64_t SLICE = 100000;
+
+    //Slices compared with stepping the interpreter, before timing : the JIT translates its blocks on the way
+    constexpr int CHECKED_SLICES = 4;
+
+    //Past this, a functional test run is stuck
+    constexpr uint64_t FUNCTIONAL_TEST_MAX_CYCLES = 1000000000;
+    constexpr Word FUNCTIONAL_TEST_ENTRY = 0x0400;
+    constexpr Word FUNCTIONAL_TEST_SUCCESS = 0x3469;
+
+    void Report(benchmark::State& state, const uint64_t instructions, const uint64_t cycles) {
+        state.counters["instructions"] = benchmark::Counter(instructions, benchmark::Counter::kIsRate);
+        state.counters["cycles"] = benchmark::Counter(cycles, benchmark::Counter::kIsRate);
+        state.counters["CPI"] = instructions ? static_cast<double>(cycles) / instructions : 0;
+    }
+
+    //Runs CHECKED_SLICES slices of the workload on Host and steps the interpreter through as many instructions :
+    //both end at the same instruction, the same number of cycles later
+    template<typename Host>
+    bool CountsLikeStepping(const Workload& workload) {
+        const unique_ptr<Host> host = make_unique<Host>();
+        host->Load(workload.m_Origin, workload.m_Image);
+        Start(*host, workload.m_Origin);
+
+        const unique_ptr<InterpreterHost> reference = make_unique<InterpreterHost>();
+        reference->Load(workload.m_Origin, workload.m_Image);
+        Start(*reference, workload.m_Origin);
+
+        uint64_t cycles = 0;
+        uint64_t expected = 0;
+        for(int slice = 0; slice < CHECKED_SLICES; slice++) {
+            cycles += host->m_Core.Run(SLICE);
+            for(uint64_t i = 0; i < SLICE; i++) expected += reference->m_Core.Step();
+        }
+        return cycles == expected && host->m_Core.GetProgramCounter() == reference->m_Core.GetProgramCounter();
+    }
+
+    template<typename Host>
+    void RunWorkload(benchmark::State& state, const Workload* workload) {
+        if(!CountsLikeStepping<Host>(*workload)) {
+            state.SkipWithError("Run() doesn't retire the instructions and cycles stepping does");
+            return;
+        }
+
+        //JitHost is too big for the stack
+        const unique_ptr<Host> host = make_unique<Host>();
+        host->Load(workload->m_Origin, workload->m_Image);
+        Start(*host, workload->m_Origin);
+
+        uint64_t instructions = 0;
+        uint64_t cycles = 0;
+        for(auto _ : state) {
+            cycles += host->m_Core.Run(SLICE);
+            instructions += SLICE;
+        }
+        Report(state, instructions, cycles);
+
+        if(workload == &SIEVE) {
+            const Word primes = MAKE_WORD(host->Peek(0x0201), host->Peek(0x0200));
+            if(primes && primes != PRIME_COUNT) state.SkipWithError(("sieve found " + to_string(primes) + " primes").c_str());
+        }
+    }
+
+    //JMP to itself, or a branch to itself : where the functional test stops, on success or failure
+    template<typename Host>
+    bool IsTrap(const Host& host, const Word pc) {
+        const Opcode& opcode = OPCODES[host.Peek(pc)];
+        if(opcode.m_Instruction == Instructions::JMP && opcode.m_AddrMode == AddressMode::ABS)
+            return MAKE_WORD(host.Peek(pc + 2), host.Peek(pc + 1)) == pc;
+        return opcode.m_AddrMode == AddressMode::REL && host.Peek(pc + 1) == 0xFE;
+    }
+
+    template<typename Host>
+    void FunctionalTest(benchmark::State& state, const vector<Byte>* image, const Word success) {
+        const unique_ptr<Host> host = make_unique<Host>();
+
+        uint64_t instructions = 0;
+        uint64_t cycles = 0;
+        for(auto _ : state) {
+            state.PauseTiming();
+            host->Load(0x0000, *image);
+            Start(*host, FUNCTIONAL_TEST_ENTRY);
+            const uint64_t start = cycles;
+            state.ResumeTiming();
+
+            for(;;) {
+                cycles += host->m_Core.Run(SLICE);
+                instructions += SLICE;
+
+                const Word pc = host->m_Core.GetProgramCounter();
+                if(pc == success) break;
+                if(IsTrap(*host, pc) || cycles - start > FUNCTIONAL_TEST_MAX_CYCLES) {
+                    char error[64];
+                    snprintf(error, sizeof(error), "functional test failed at $%04X", pc);
+                    state.SkipWithError(error);
+                    return;
+                }
+            }
+        }
+        Report(state, instructions, cycles);
+    }
+
+    template<typename Host>
+    void RegisterWorkloads() {
+        for(const Workload* workload : { &SIEVE, &MEMCPY, &OPCODE_MIX }) {
+            const string name = "Workload/" + string(workload->m_Name) + "/" + Host::NAME;
+            benchmark::RegisterBenchmark(name.c_str(), RunWorkload<Host>, workload);
+        }
+    }
+
+    template<typename Host>
+    void RegisterFunctionalTest(const vector<Byte>* image, const Word success) {
+        const string name = string("FunctionalTest/") + Host::NAME;
+        benchmark::RegisterBenchmark(name.c_str(), FunctionalTest<Host>, image, success)->Unit(benchmark::kMillisecond);
+    }
+
+    const bool REGISTERED = [] {
+        RegisterWorkloads<InterpreterHost>();
+        RegisterWorkloads<CycleExactHost>();
+        RegisterWorkloads<AdapterHost>();
+        RegisterWorkloads<JitHost>();
+
+        const char* path = getenv("EMU6502_FUNCTIONAL_TEST");
+        if(!path) return true;
+
+        ifstream file(path, ios::binary);
+        static vector<Byte> image(istreambuf_iterator<char>(file), {});
+        if(image.empty() || image.size() > 0x10000) {
+            fprintf(stderr, "EMU6502_FUNCTIONAL_TEST : can't load a 64KB image from %s\n", path);
+            return false;
+        }
+
+        const char* trap = getenv("EMU6502_FUNCTIONAL_TEST_SUCCESS");
+        const Word success = trap ? static_cast<Word>(strtoul(trap, nullptr, 16)) : FUNCTIONAL_TEST_SUCCESS;
+
+        RegisterFunctionalTest<InterpreterHost>(&image, success);
+        RegisterFunctionalTest<CycleExactHost>(&image, success);
+        RegisterFunctionalTest<AdapterHost>(&image, success);
+        RegisterFunctionalTest<JitHost>(&image, success);
+        return true;
+    }();
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <types.h>
+#include <io_device.h>
+#include <memory.h>
+#include <bus.h>
+#include <cpu.h>
+#include <cpu_core.h>
+#include <jit.h>
+
+using namespace std;
+
+//The cores under benchmark, each with the bus it is meant to run on.
+//
+//  Load()      copies a program (or a memory image) in, from the host side
+//  Peek()      reads memory back, from the host side
+//  Start()     sets the registers to run from `pc`
+//  m_Core      the core, Run() / RunFor() are called on it directly
+
+//CPUCore<Memory> : the interpreter with its bus accesses inlined
+struct InterpreterHost {
+    static constexpr const char* NAME = "interpreter";
+
+    Memory m_Memory;
+    CPUCore<Memory> m_Core { m_Memory };
+
+    inline void Load(const Word addr, span<const Byte> bytes) { m_Memory.WriteBytes(addr, bytes); }
+    inline Byte Peek(const Word addr) const { return m_Memory.ReadByte(addr); }
+};
+
+//CPUCore<Memory, NoTrace, CycleExact> : the interpreter performing every bus access on its cycle
+struct CycleExactHost {
+    static constexpr const char* NAME = "cycle_exact";
+
+    Memory m_Memory;
+    CPUCore<Memory, NoTrace, CycleExact> m_Core { m_Memory };
+
+    inline void Load(const Word addr, span<const Byte> bytes) { m_Memory.WriteBytes(addr, bytes); }
+    inline Byte Peek(const Word addr) const { return m_Memory.ReadByte(addr); }
+};
+
+//CPU : the same core, every access through the IODevice (io_ptr) interface
+struct AdapterHost {
+    static constexpr const char* NAME = "adapter";
+
+    IODevice::io_ptr m_Memory = Memory::Make();
+    CPU m_Core { m_Memory };
+
+    inline void Load(const Word addr, span<const Byte> bytes) { m_Memory->WriteBytes(addr, bytes); }
+    inline Byte Peek(const Word addr) const { return m_Memory->ReadByte(addr); }
+};
+
+//JitCPU on a Bus with the whole address space mapped as RAM
+struct JitHost {
+    static constexpr const char* NAME = "jit";
+
+    shared_ptr<Bus> m_Bus = MakeBus();
+    JitCPU m_Core { *m_Bus };
+
+    static shared_ptr<Bus> MakeBus() {
+        shared_ptr<Bus> bus = Bus::Make();
+        bus->MapMemory(0x00, 256, Memory::Make());
+        return bus;
+    }
+
+    //The blocks compiled from the previous contents are dropped
+    inline void Load(const Word addr, span<const Byte> bytes) {
+        m_Bus->WriteBytes(addr, bytes);
+        m_Core.Invalidate();
+    }
+
+    inline Byte Peek(const Word addr) const { return m_Bus->ReadByte(addr); }
+};
+
+template<typename Host>
+inline void Start(Host& host, const Word pc) {
+    Registers registers {};
+    registers.m_PC = pc;
+    registers.m_SP = 0xFF;
+    registers.m_CpuStatus = static_cast<Byte>(StatusFlag::INTERRUPT) | static_cast<Byte>(StatusFlag::UNUSED);
+    host.m_Core.SetRegisters(registers);
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <types.h>
+
+using namespace std;
+
+//Guest programs of the end-to-end benchmarks. Each one loops forever, so that any number of
+//instructions can be run from its entry point, and keeps the stack balanced.
+struct Workload {
+    string_view m_Name;
+    Word m_Origin;              //Load address, and entry point
+    vector<Byte> m_Image;
+};
+
+//Sieve of Eratosthenes over 8192 byte flags at $2000-$3FFF : 16-bit pointer arithmetic, (zp),Y
+//loads and stores, taken and untaken branches. Each pass stores the number of primes below 8192
+//(PRIME_COUNT) at $0200.
+inline const Workload SIEVE { "sieve", 0x0400, {
+        0xA9, 0x00,         //0400  start:  LDA #$00
+        0x85, 0xFB,         //0402          STA $FB
+        0xA9, 0x20,         //0404          LDA #$20
+        0x85, 0xFC,         //0406          STA $FC
+        0xA2, 0x20,         //0408          LDX #$20
+        0xA9, 0x00,         //040A          LDA #$00
+        0xA8,               //040C          TAY
+        0x91, 0xFB,         //040D  clear:  STA ($FB),Y
+        0xC8,               //040F          INY
+        0xD0, 0xFB,         //0410          BNE clear
+        0xE6, 0xFC,         //0412          INC $FC
+        0xCA,               //0414          DEX
+        0xD0, 0xF6,         //0415          BNE clear
+        0x85, 0xF6,         //0417          STA $F6       count = 0
+        0x85, 0xF7,         //0419          STA $F7
+        0xA9, 0x02,         //041B          LDA #$02      n = 2
+        0x85, 0xF0,         //041D          STA $F0
+        0x84, 0xF1,         //041F          STY $F1
+        0x85, 0xF2,         //0421          STA $F2       p = flags + 2
+        0xA9, 0x20,         //0423          LDA #$20
+        0x85, 0xF3,         //0425          STA $F3
+        0xB1, 0xF2,         //0427  loop:   LDA ($F2),Y   Y = 0
+        0xD0, 0x2D,         //0429          BNE next      composite
+        0xE6, 0xF6,         //042B          INC $F6       count++
+        0xD0, 0x02,         //042D          BNE mult
+        0xE6, 0xF7,         //042F          INC $F7
+        0x18,               //0431  mult:   CLC           q = p + n
+        0xA5, 0xF2,         //0432          LDA $F2
+        0x65, 0xF0,         //0434          ADC $F0
+        0x85, 0xF4,         //0436          STA $F4
+        0xA5, 0xF3,         //0438          LDA $F3
+        0x65, 0xF1,         //043A          ADC $F1
+        0x85, 0xF5,         //043C          STA $F5
+        0xA5, 0xF5,         //043E  mark:   LDA $F5
+        0xC9, 0x40,         //0440          CMP #$40
+        0xB0, 0x14,         //0442          BCS next      past the flags
+        0xA9, 0x01,         //0444          LDA #$01
+        0x91, 0xF4,         //0446          STA ($F4),Y
+        0x18,               //0448          CLC           q += n
+        0xA5, 0xF4,         //0449          LDA $F4
+        0x65, 0xF0,         //044B          ADC $F0
+        0x85, 0xF4,         //044D          STA $F4
+        0xA5, 0xF5,         //044F          LDA $F5
+        0x65, 0xF1,         //0451          ADC $F1
+        0x85, 0xF5,         //0453          STA $F5
+        0x4C, 0x3E, 0x04,   //0455          JMP mark
+        0xE6, 0xF0,         //0458  next:   INC $F0       n++
+        0xD0, 0x02,         //045A          BNE n1
+        0xE6, 0xF1,         //045C          INC $F1
+        0xE6, 0xF2,         //045E  n1:     INC $F2       p++
+        0xD0, 0x02,         //0460          BNE n2
+        0xE6, 0xF3,         //0462          INC $F3
+        0xA5, 0xF3,         //0464  n2:     LDA $F3
+        0xC9, 0x40,         //0466          CMP #$40
+        0xD0, 0xBD,         //0468          BNE loop
+        0xA5, 0xF6,         //046A          LDA $F6       primes found
+        0x8D, 0x00, 0x02,   //046C          STA $0200
+        0xA5, 0xF7,         //046F          LDA $F7
+        0x8D, 0x01, 0x02,   //0471          STA $0201
+        0x4C, 0x00, 0x04,   //0474          JMP start
+} };
+
+inline constexpr Word PRIME_COUNT = 1028;
+
+//Copies the 16 pages at $4000 to $6000, byte by byte through (zp),Y : the tightest loop a 6502 runs.
+inline const Workload MEMCPY { "memcpy", 0x0400, {
+        0xA9, 0x00,         //0400  start:  LDA #$00
+        0x85, 0xFB,         //0402          STA $FB       source $4000
+        0x85, 0xFD,         //0404          STA $FD       destination $6000
+        0xA9, 0x40,         //0406          LDA #$40
+        0x85, 0xFC,         //0408          STA $FC
+        0xA9, 0x60,         //040A          LDA #$60
+        0x85, 0xFE,         //040C          STA $FE
+        0xA2, 0x10,         //040E          LDX #$10      16 pages
+        0xA0, 0x00,         //0410          LDY #$00
+        0xB1, 0xFB,         //0412  copy:   LDA ($FB),Y
+        0x91, 0xFD,         //0414          STA ($FD),Y
+        0xC8,               //0416          INY
+        0xD0, 0xF9,         //0417          BNE copy
+        0xE6, 0xFC,         //0419          INC $FC
+        0xE6, 0xFE,         //041B          INC $FE
+        0xCA,               //041D          DEX
+        0xD0, 0xF2,         //041E          BNE copy
+        0x4C, 0x00, 0x04,   //0420          JMP start
+} };
+
+//An instruction mix in the spirit of Klaus Dormann's functional test, over every value of X :
+//binary and decimal ADC / SBC, shifts and rotates on A and memory, indexed stores,
+//JSR / RTS, pushes and pulls of A and P, compares and BIT with branches on their flags.
+inline const Workload OPCODE_MIX { "opcode_mix", 0x0400, {
+        0xA2, 0x00,         //0400  start:  LDX #$00
+        0x8A,               //0402  loop:   TXA
+        0x18,               //0403          CLC           binary
+        0x65, 0x10,         //0404          ADC $10
+        0x85, 0x10,         //0406          STA $10
+        0x38,               //0408          SEC
+        0xE9, 0x35,         //0409          SBC #$35
+        0x45, 0x11,         //040B          EOR $11
+        0x85, 0x11,         //040D          STA $11
+        0xF8,               //040F          SED           decimal
+        0x18,               //0410          CLC
+        0x8A,               //0411          TXA
+        0x65, 0x10,         //0412          ADC $10
+        0x38,               //0414          SEC
+        0xE9, 0x19,         //0415          SBC #$19
+        0xD8,               //0417          CLD
+        0x9D, 0x00, 0x03,   //0418          STA $0300,X
+        0x0A,               //041B          ASL A         shifts and rotates
+        0x26, 0x12,         //041C          ROL $12
+        0x4A,               //041E          LSR A
+        0x6A,               //041F          ROR A
+        0x5D, 0x00, 0x03,   //0420          EOR $0300,X
+        0x9D, 0x00, 0x03,   //0423          STA $0300,X
+        0x20, 0x3F, 0x04,   //0426          JSR sub
+        0x48,               //0429          PHA           stack
+        0x08,               //042A          PHP
+        0x28,               //042B          PLP
+        0x68,               //042C          PLA
+        0xC9, 0x80,         //042D          CMP #$80      compares and branches
+        0x90, 0x02,         //042F          BCC low
+        0xE6, 0x13,         //0431          INC $13
+        0x24, 0x10,         //0433  low:    BIT $10
+        0x10, 0x02,         //0435          BPL pos
+        0xC6, 0x14,         //0437          DEC $14
+        0xE8,               //0439  pos:    INX
+        0xD0, 0xC6,         //043A          BNE loop
+        0x4C, 0x00, 0x04,   //043C          JMP start
+        0xA0, 0x04,         //043F  sub:    LDY #$04
+        0x26, 0x15,         //0441  rot:    ROL $15
+        0x88,               //0443          DEY
+        0xD0, 0xFB,         //0444          BNE rot
+        0x60,               //0446          RTS
+} };
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <coverage.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "fuzz_guest.h"
+
+using namespace std;
+
+//Coverage-guided fuzzing of a guest program : every input runs a firmware image from the same initial state,
+//with the input in memory or behind an input register, and the guest edges it takes (see EdgeCoverage) feed
+//libFuzzer's extra counters. The host code isn't instrumented : the emulator's own branches tell nothing about
+//the guest, and would slow every execution down.
+//
+//Configured through the environment (addresses in C notation, 0x... for hex) :
+//
+//  EMU6502_FUZZ_IMAGE      the firmware, loaded at EMU6502_FUZZ_BASE (0 by default)
+//  EMU6502_FUZZ_ENTRY      where every run starts, the RESET vector by default
+//  EMU6502_FUZZ_INPUT      mmio:<page> : the input is read from an input register (see InputStream), the default, on page 0xD0
+//                          mem:<address> : the input is copied in memory, EMU6502_FUZZ_LENGTH is the address of a
+//                          little-endian word receiving its length (none by default)
+//  EMU6502_FUZZ_CYCLES     cycle budget of a run, 1000000 by default
+//  EMU6502_FUZZ_EXIT       a run also ends once the PC reaches this address (the parser returned), none by default
+//  EMU6502_FUZZ_JAM        crash (the default) : a run jamming the CPU aborts, for libFuzzer to keep the input
+//                          ignore : it just ends the run
+//
+//Between two runs, the memory is restored from the snapshot taken once the image is loaded : only the pages
+//the previous run wrote are copied back (see Memory::Restore), the registers go back through Reset().
+
+namespace {
+
+    //Input register pair at the start of its page :
+    //  +0  DATA    the next input byte, 0 once they are all read
+    //  +1  STATUS  the number of bytes left, 255 when more
+    class InputStream {
+
+            private :
+
+                const Byte* m_Data = nullptr;
+                size_t m_Size = 0;
+                size_t m_Position = 0;
+
+            public :
+
+                inline void Set(const Byte* data, const size_t size) {
+                    m_Data = data;
+                    m_Size = size;
+                    m_Position = 0;
+                }
+
+                inline Byte Read(const address& addr) {
+                    switch (addr.GetRecord()) {
+                        case 0: return m_Position < m_Size ? m_Data[m_Position++] : 0;
+                        case 1: return static_cast<Byte>(min<size_t>(m_Size - m_Position, 0xFF));
+                        default: return 0;
+                    }
+                }
+    };
+
+    //Memory, with the input registers on one page (when there are)
+    class FuzzBus {
+
+            private :
+
+                Memory& m_Memory;
+                mutable InputStream m_Input;
+                Byte m_InputPage = 0;
+                bool m_HasInput = false;
+
+            public :
+
+                explicit FuzzBus(Memory& memory) : m_Memory(memory) {}
+
+                inline void MapInput(const Byte page) {
+                    m_InputPage = page;
+                    m_HasInput = true;
+                }
+
+                inline InputStream& GetInput() { return m_Input; }
+
+                inline Byte ReadByte(const address& addr) const {
+                    if(m_HasInput && addr.GetPage() == m_InputPage) [[unlikely]] return m_Input.Read(addr);
+                    return m_Memory.ReadByte(addr);
+                }
+
+                inline Word ReadWord(const address& addr) const {
+                    const Byte lo = ReadByte(addr);
+                    const Byte hi = ReadByte(addr.GetValue() + 1);
+                    return MAKE_WORD(hi, lo);
+                }
+
+                //The input page ignores writes
+                inline void WriteByte(const address& addr, const Byte data) {
+                    if(m_HasInput && addr.GetPage() == m_InputPage) [[unlikely]] return;
+                    m_Memory.WriteByte(addr, data);
+                }
+
+                inline void WriteWord(const address& addr, const Word data) {
+                    WriteByte(addr, data & 0xFF);
+                    WriteByte(addr.GetValue() + 1, data >> 8);
+                }
+
+                inline bool IsPollable(const address& addr) const { return !m_HasInput || addr.GetPage() != m_InputPage; }
+    };
+
+    using FuzzCore = CPUCore<FuzzBus, EdgeCoverage>;
+
+    constexpr size_t COVERAGE_SIZE = 1 << 16;
+
+    //libFuzzer reads the counters of this section after every run, on top of its own
+#if defined(__linux__)
+    __attribute__((section("__libfuzzer_extra_counters")))
+#endif
+    Byte s_Coverage[COVERAGE_SIZE];
+
+    struct Harness {
+        Memory m_Memory;
+        Memory::snapshot_ptr m_Initial;
+        FuzzBus m_Bus { m_Memory };
+        FuzzCore m_Core { m_Bus };
+
+        int32_t m_Entry = -1;
+        int32_t m_Exit = -1;
+        int32_t m_InputAddress = -1;        //Memory input
+        int32_t m_LengthAddress = -1;
+        uint64_t m_Cycles = 1000000;
+        bool m_JamIsCrash = true;
+    };
+
+    Harness* s_Harness = nullptr;
+
+    //Unset variables keep the default
+    int64_t Variable(const char* name, const int64_t fallback) {
+        const char* value = getenv(name);
+        if(!value || !*value) return fallback;
+        char* end = nullptr;
+        const long long number = strtoll(value, &end, 0);
+        if(*end) throw invalid_argument(string(name) + " isn't a number : " + value);
+        return number;
+    }
+
+    void Setup(Harness& harness) {
+        const char* image = getenv("EMU6502_FUZZ_IMAGE");
+        if(!image) throw invalid_argument("EMU6502_FUZZ_IMAGE isn't set");
+        ifstream file(image, ios::binary);
+        if(!file) throw runtime_error(string("Can't open ") + image);
+        const vector<Byte> bytes { istreambuf_iterator<char>(file), istreambuf_iterator<char>() };
+
+        const int64_t base = Variable("EMU6502_FUZZ_BASE", 0);
+        if(base < 0 || base + bytes.size() > harness.m_Memory.GetSize()) throw invalid_argument("The image doesn't fit in memory at EMU6502_FUZZ_BASE");
+        harness.m_Memory.WriteBytes(base, bytes);
+
+        harness.m_Entry = Variable("EMU6502_FUZZ_ENTRY", -1);
+        harness.m_Exit = Variable("EMU6502_FUZZ_EXIT", -1);
+        harness.m_Cycles = Variable("EMU6502_FUZZ_CYCLES", harness.m_Cycles);
+
+        const char* jam = getenv("EMU6502_FUZZ_JAM");
+        if(jam && strcmp(jam, "ignore") == 0) harness.m_JamIsCrash = false;
+        else if(jam && strcmp(jam, "crash") != 0) throw invalid_argument("EMU6502_FUZZ_JAM is crash or ignore");
+
+        const string input = getenv("EMU6502_FUZZ_INPUT") ? getenv("EMU6502_FUZZ_INPUT") : "mmio:0xD0";
+        const size_t colon = input.find(':');
+        const string kind = input.substr(0, colon);
+        const long location = colon == string::npos ? -1 : strtol(input.c_str() + colon + 1, nullptr, 0);
+        if(kind == "mmio" && location >= 0 && location <= 0xFF) harness.m_Bus.MapInput(location);
+        else if(kind == "mem" && location >= 0 && location <= 0xFFFF) {
+            harness.m_InputAddress = location;
+            harness.m_LengthAddress = Variable("EMU6502_FUZZ_LENGTH", -1);
+        }
+        else throw invalid_argument("EMU6502_FUZZ_INPUT is mmio:<page> or mem:<address>");
+
+        harness.m_Initial = harness.m_Memory.Snapshot();
+        harness.m_Core.SetTracer(EdgeCoverage(s_Coverage));
+    }
+}
+
+    extern "C" int LLVMFuzzerInitialize(int*, char***) {
+        try {
+            s_Harness = new Harness();
+            Setup(*s_Harness);
+        }
+        catch(const exception& e) {
+            fprintf(stderr, "emu6502_fuzz : %s\n", e.what());
+            exit(EXIT_FAILURE);
+        }
+        return 0;
+    }
+
+    extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+        Harness& harness = *s_Harness;
+        Memory& memory = harness.m_Memory;
+        FuzzCore& core = harness.m_Core;
+
+        memory.Restore(harness.m_Initial);
+
+        if(harness.m_InputAddress < 0) harness.m_Bus.GetInput().Set(data, size);
+        else {
+            size = min<size_t>(size, memory.GetSize() - harness.m_InputAddress);
+            memory.WriteBytes(harness.m_InputAddress, span<const Byte>(data, size));
+            if(harness.m_LengthAddress >= 0) memory.WriteWord(harness.m_LengthAddress, min<size_t>(size, 0xFFFF));
+        }
+
+        core.Reset();
+        if(harness.m_Entry >= 0) {
+            Registers registers = core.GetRegisters();
+            registers.m_PC = harness.m_Entry;
+            core.SetRegisters(registers);
+        }
+        core.GetTracer().Reset();
+        if(harness.m_Exit < 0) core.RunFor(harness.m_Cycles);
+        else {
+            const uint64_t end = core.GetCycles() + harness.m_Cycles;
+            const Word exit = harness.m_Exit;
+            core.RunUntil([end, exit](const auto& cpu) { return cpu.GetProgramCounter() == exit || cpu.GetCycles() >= end; });
+        }
+
+        if(core.IsHalted() && harness.m_JamIsCrash) {
+            fprintf(stderr, "emu6502_fuzz : the CPU jammed on opcode $%02X at $%04X\n", memory.ReadByte(core.GetProgramCounter()), core.GetProgramCounter());
+            abort();
+        }
+        return 0;
+    }
+
+    size_t GetCoveredEdges() {
+        return count_if(begin(s_Coverage), end(s_Coverage), [](const Byte counter) { return counter != 0; });
+    }
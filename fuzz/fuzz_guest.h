@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//libFuzzer entry points of the guest harness (see fuzz_guest.cpp)
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+//Counters of the coverage map that are set. libFuzzer clears the map before every run, the replay driver
+//doesn't : there, they are the edges hit since the process started.
+size_t GetCoveredEdges();
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fuzz_guest.h"
+
+using namespace std;
+
+//Stands in for libFuzzer's main where it isn't available (GCC) : replays inputs through the harness,
+//to reproduce a crash or measure the executions per second.
+//
+//  emu6502_fuzz <file | directory>... [--random <count>] [--size <bytes>]
+//
+//  --random    also runs `count` random inputs of up to --size bytes (64 by default)
+
+int main(int argc, char** argv) {
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    try {
+        vector<filesystem::path> files;
+        uint64_t random = 0;
+        size_t size = 64;
+        for(int i = 1; i < argc; i++) {
+            const string arg = argv[i];
+            if(arg == "--random" || arg == "--size") {
+                if(i + 1 >= argc) throw invalid_argument("Missing value for " + arg);
+                (arg == "--random" ? random : size) = stoull(argv[++i]);
+            }
+            else if(arg[0] == '-') throw invalid_argument("Unknown argument : " + arg);
+            else if(filesystem::is_directory(arg)) {
+                for(const filesystem::directory_entry& entry : filesystem::directory_iterator(arg))
+                    if(entry.is_regular_file()) files.push_back(entry.path());
+            }
+            else files.push_back(arg);
+        }
+
+        const auto start = chrono::steady_clock::now();
+        for(const filesystem::path& path : files) {
+            ifstream file(path, ios::binary);
+            if(!file) throw runtime_error("Can't open " + path.string());
+            const vector<uint8_t> input { istreambuf_iterator<char>(file), istreambuf_iterator<char>() };
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+
+        mt19937_64 generator(0x6502);
+        vector<uint8_t> input;
+        for(uint64_t run = 0; run < random; run++) {
+            input.resize(generator() % (size + 1));
+            for(uint8_t& byte : input) byte = generator();
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const uint64_t runs = files.size() + random;
+        cerr << runs << " runs in " << seconds << " s (" << static_cast<uint64_t>(runs / max(seconds, 1e-9)) << " exec/s), "
+             << GetCoveredEdges() << " edges covered" << endl;
+    }
+    catch(const exception& e) {
+        cerr << "emu6502_fuzz : " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
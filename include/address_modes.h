@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <string_view>
 #include <types.h>
 
 enum class AddressMode : Byte {
@@ -23,4 +25,32 @@ enum class AddressMode : Byte {
         ZPX,    //Zero-page, offset by X
         ZPY     //Zero-page, offset by Y
 
-};
\ No newline at end of file
+};
+
+constexpr size_t ADDRESS_MODE_COUNT = static_cast<size_t>(AddressMode::ZPY) + 1;
+
+//Short names, in declaration order
+constexpr array<string_view, ADDRESS_MODE_COUNT> ADDRESS_MODE_NAMES = {
+    "ILL", "ABS", "ABX", "ABY", "ACC", "IMM", "IMP", "IND", "INX", "INY", "REL", "ZPG", "ZPX", "ZPY"
+};
+
+//Number of operand bytes following the opcode
+constexpr Byte OperandSize(const AddressMode addrMode) {
+    switch (addrMode) {
+        case AddressMode::ABS:
+        case AddressMode::ABX:
+        case AddressMode::ABY:
+        case AddressMode::IND:
+            return 2;
+        case AddressMode::IMM:
+        case AddressMode::INX:
+        case AddressMode::INY:
+        case AddressMode::REL:
+        case AddressMode::ZPG:
+        case AddressMode::ZPX:
+        case AddressMode::ZPY:
+            return 1;
+        default:
+            return 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <types.h>
+#include <flags.h>
+#include <instructions.h>
+#include <utils.h>
+
+using namespace std;
+
+//ALU results and flags, decimal ADC / SBC from lookup tables generated at compile time.
+//
+//An entry holds the result in its low byte, and the N, V, Z and C flags the operation leaves in its
+//high byte, at their place in the status register : a single load gives the whole outcome.
+//Binary ADC / SBC don't need one, the carry and overflow are a couple of ALU operations (see CPUCore::AddWithCarry).
+//Shifts build their entry the same way, but on the fly (see ShiftEntry).
+
+constexpr Byte ALU_FLAGS = static_cast<Byte>(StatusFlag::CARRY) | static_cast<Byte>(StatusFlag::ZERO)
+                         | static_cast<Byte>(StatusFlag::INT_OVERFLOW) | static_cast<Byte>(StatusFlag::NEGATIVE);
+
+constexpr Word AluEntry(const Byte result, const bool carry, const bool zero, const bool overflow, const bool negative) {
+    const Byte flags = (carry ? static_cast<Byte>(StatusFlag::CARRY) : 0) | (zero ? static_cast<Byte>(StatusFlag::ZERO) : 0)
+                     | (overflow ? static_cast<Byte>(StatusFlag::INT_OVERFLOW) : 0) | (negative ? static_cast<Byte>(StatusFlag::NEGATIVE) : 0);
+    return MAKE_WORD(flags, result);
+}
+
+//Decimal ADC as the NMOS 6502 does it, invalid BCD digits included :
+//the result and C are decimal, Z is the one of the binary sum, N and V come from the
+//intermediate sum, after the low digit is adjusted but before the high one is.
+constexpr Word DecimalAdd(const Byte a, const Byte m, const Byte carry) {
+    int low = (a & 0x0F) + (m & 0x0F) + carry;
+    if(low >= 0x0A) low = ((low + 0x06) & 0x0F) + 0x10;
+
+    //Signed intermediate, for N and V
+    const int intermediate = static_cast<signed char>(a & 0xF0) + static_cast<signed char>(m & 0xF0) + low;
+
+    int sum = (a & 0xF0) + (m & 0xF0) + low;
+    if(sum >= 0xA0) sum += 0x60;
+
+    const bool zero = static_cast<Byte>(a + m + carry) == 0;
+    return AluEntry(static_cast<Byte>(sum), sum >= 0x100, zero, intermediate < -128 || intermediate > 127, intermediate & 0x80);
+}
+
+//Decimal SBC on the NMOS 6502 : only the result is decimal, every flag is the one of the binary substraction
+constexpr Word DecimalSub(const Byte a, const Byte m, const Byte carry) {
+    int low = (a & 0x0F) - (m & 0x0F) + carry - 1;
+    if(low < 0) low = ((low - 0x06) & 0x0F) - 0x10;
+
+    int difference = (a & 0xF0) - (m & 0xF0) + low;
+    if(difference < 0) difference -= 0x60;
+
+    const int binary = a - m + carry - 1;
+    const Byte result = static_cast<Byte>(binary);
+    const bool overflow = (a ^ m) & (a ^ result) & 0x80;
+    return AluEntry(static_cast<Byte>(difference), binary >= 0, result == 0, overflow, result & 0x80);
+}
+
+//Decimal ADC / SBC tables, indexed by DecimalIndex(). 256 KB each, generated in alu.cpp
+constexpr size_t DECIMAL_TABLE_SIZE = 2 * 256 * 256;
+
+constexpr size_t DecimalIndex(const Byte carry, const Byte a, const Byte m) { return (static_cast<size_t>(carry) << 16) | (a << 8) | m; }
+
+extern const array<Word, DECIMAL_TABLE_SIZE> ADC_DECIMAL;
+extern const array<Word, DECIMAL_TABLE_SIZE> SBC_DECIMAL;
+
+//ASL, LSR, ROL and ROR, the carry in only matters to the rotations.
+//Computed rather than looked up : a table load on the carry chain is slower than the shift itself.
+template<Instructions instruction>
+constexpr Word ShiftEntry(const Byte value, const Byte carry) {
+    using enum Instructions;
+
+    static_assert(instruction == ASL || instruction == LSR || instruction == ROL || instruction == ROR, "Not a shift");
+
+    Byte result;
+    bool carryOut;
+    if constexpr (instruction == ASL || instruction == ROL) {
+        result = (value << 1) | (instruction == ROL ? carry : 0);
+        carryOut = value & 0x80;
+    }
+    else {
+        result = (value >> 1) | (instruction == ROR ? carry << 7 : 0);
+        carryOut = value & 0x01;
+    }
+    return AluEntry(result, carryOut, result == 0, false, result & 0x80);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <types.h>
+#include <cpu_core.h>
+#include <utils.h>
+
+using namespace std;
+
+template<typename BusPolicy>
+class AotCPU;
+
+//Basic block recompiled ahead of time by emu6502-aot
+template<typename BusPolicy>
+struct AotBlock {
+    Word m_Start;
+    Word m_Instructions;
+    uint64_t (*m_Run)( AotCPU<BusPolicy>& cpu );   //Returns the cycles spent
+};
+
+//Everything emu6502-aot generates for one image
+template<typename BusPolicy>
+struct AotProgram {
+    Word m_Base;                //Where the image is mapped
+    size_t m_Size;
+    uint64_t m_Hash;            //HashImage() of the image
+    const AotBlock<BusPolicy>* m_Blocks;
+    size_t m_Count;
+};
+
+//6502 core running firmware recompiled to C++ by emu6502-aot.
+//
+//The generated blocks call RunOpcode<code>() with the operand already decoded : once compiled, every
+//instruction is the core's own Execute<> with constant operands, inlined on the bus accessors.
+//Whenever the PC is not at the start of a recompiled block (indirect jumps, code in RAM, targets
+//the control flow analysis couldn't resolve), the core falls back to interpreting.
+//
+//The recompiled image must stay mapped read-only at its base address : the blocks don't check
+//for modified code.
+template<typename BusPolicy>
+class AotCPU : public CPUCore<BusPolicy> {
+
+            public :
+
+                using Core = CPUCore<BusPolicy>;
+
+            protected :
+
+                using Core::m_PC;
+                using Core::m_Halted;
+                using Core::m_Cycles;
+                using Core::m_SliceEnd;
+                using Core::m_IdleArmed;
+                using Core::m_IdleSkip;
+
+                //Recompiled blocks indexed by start address
+                vector<const AotBlock<BusPolicy>*> m_Blocks;
+
+            public :
+
+                explicit AotCPU(BusPolicy& bus) : Core(bus), m_Blocks(0x10000, nullptr) {}
+
+                //Registers the blocks of a program.
+                //Returns false (and registers nothing) when the memory doesn't hold the image it was generated from.
+                bool Load(const AotProgram<BusPolicy>& program) {
+                    vector<Byte> image(program.m_Size);
+                    for(size_t i = 0; i < program.m_Size; i++) image[i] = this->Peek(static_cast<Word>(program.m_Base + i));
+                    if(HashImage(image.data(), image.size()) != program.m_Hash) return false;
+
+                    for(size_t i = 0; i < program.m_Count; i++) m_Blocks[program.m_Blocks[i].m_Start] = &program.m_Blocks[i];
+                    return true;
+                }
+
+                void Unload() { fill(m_Blocks.begin(), m_Blocks.end(), nullptr); }
+
+                //Executes a decoded instruction (see CPUCore::Decode for the operand), returns its cycles
+                template<Byte code>
+                inline Byte RunOpcode(const Word operand, const Word next) {
+                    return OPCODES[code].m_Cycles + Core::template DecodedOp<code>(*this, { nullptr, operand, next, OPCODES[code].m_Cycles, code });
+                }
+
+                //Runs at most `instructions` instructions, stops early if the CPU jams.
+                //Interrupts and events are looked at between blocks. Returns the number of cycles spent.
+                uint64_t Run(uint64_t instructions) {
+                    const uint64_t start = m_Cycles;
+                    m_IdleArmed = false;
+                    for(;;) {
+                        if(m_IdleSkip) instructions -= Core::SkipIdle(Core::GetNextDeadline(), instructions);
+                        if(m_Cycles >= m_SliceEnd) Core::Poll();
+                        if(!instructions || m_Halted) break;
+
+                        const AotBlock<BusPolicy>* block = m_Blocks[m_PC];
+                        //Near the instruction budget, or outside of the recompiled code : interpreted
+                        if(!block || block->m_Instructions > instructions) {
+                            m_Cycles += Core::Dispatch();
+                            instructions--;
+                            continue;
+                        }
+                        m_Cycles += block->m_Run(*this);
+                        instructions -= block->m_Instructions;
+                    }
+                    return m_Cycles - start;
+                }
+};
@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+#include <types.h>
+#include <cpu_core.h>
+
+using namespace std;
+
+//Bus wrapper flagging the pages written to, when they hold cached code.
+//Reads are forwarded untouched, so CPUCore<WriteTrackingBus<Bus>> still inlines everything.
+template<typename BusPolicy>
+class WriteTrackingBus {
+
+        template<typename> friend class CachedCPU;
+
+        protected :
+
+            BusPolicy* m_Target;
+
+            //Pages holding at least one cached block
+            array<bool, 256> m_CodePages {};
+
+            //Code pages written to since the last invalidation
+            array<bool, 256> m_DirtyPages {};
+
+            //Any of the above is set
+            bool m_CodeWritten = false;
+
+            inline void Track(const address& addr) {
+                const Byte page = addr.GetPage();
+                if(m_CodePages[page]) {
+                    m_DirtyPages[page] = true;
+                    m_CodeWritten = true;
+                }
+            }
+
+        public :
+
+            explicit WriteTrackingBus(BusPolicy& target) : m_Target(&target) {}
+
+            inline BusPolicy& GetTarget() const { return *m_Target; }
+
+            inline Byte ReadByte(const address& addr) const { return m_Target->ReadByte( addr ); }
+            inline Word ReadWord(const address& addr) const { return m_Target->ReadWord( addr ); }
+            inline bool IsPollable(const address& addr) const { return m_Target->IsPollable( addr ); }
+
+            inline void WriteByte(const address& addr, const Byte data) {
+                Track(addr);
+                m_Target->WriteByte( addr, data );
+            }
+
+            inline void WriteWord(const address& addr, const Word data) {
+                Track(addr);
+                Track(addr.GetValue() + 1);
+                m_Target->WriteWord( addr, data );
+            }
+};
+
+//Keeps the tracking bus alive before the core is constructed on top of it
+template<typename BusPolicy>
+struct TrackedBusHolder {
+    WriteTrackingBus<BusPolicy> m_TrackedBus;
+    explicit TrackedBusHolder(BusPolicy& bus) : m_TrackedBus(bus) {}
+};
+
+//6502 core running from a cache of pre-decoded basic blocks.
+//
+//A block is the run of instructions starting at a given PC, up to (and including) the first
+//control flow instruction. It is decoded once into MicroOps (handler, pre-resolved operand, cycles)
+//and replayed on every later visit without fetching or decoding the bytes again.
+//
+//Writes going through the CPU mark the pages holding cached code as dirty : the blocks on those pages
+//are dropped before the next block runs, and a block stops right after an instruction that modified code.
+//Memory changed behind the CPU's back (host loading a new program) needs an explicit Invalidate().
+template<typename BusPolicy>
+class CachedCPU : private TrackedBusHolder<BusPolicy>, public CPUCore<WriteTrackingBus<BusPolicy>> {
+
+            public :
+
+                using Core = CPUCore<WriteTrackingBus<BusPolicy>>;
+                using MicroOp = typename Core::MicroOp;
+
+                //Longest run of instructions decoded into a single block
+                static constexpr size_t MAX_BLOCK_SIZE = 64;
+
+                struct Block {
+                    vector<MicroOp> m_Ops;
+                    Word m_Start;
+                    Word m_End;         //Address following the last instruction
+
+                    //Translation state, used by JitCPU
+                    uint32_t m_Visits = 0;
+                    void* m_Native = nullptr;
+                    uint32_t m_NativeOps = 0;       //Instructions covered by the native code
+                    bool m_NativeFailed = false;
+                };
+
+            protected :
+
+                using Core::m_PC;
+                using Core::m_Halted;
+                using Core::m_Cycles;
+                using Core::m_SliceEnd;
+                using Core::m_ClockWatched;
+                using Core::m_IdleArmed;
+                using Core::m_IdleSkip;
+
+                //Blocks indexed by start address
+                vector<unique_ptr<Block>> m_Blocks;
+
+                //Start addresses of the blocks covering each page
+                array<vector<Word>, 256> m_PageBlocks;
+
+                inline WriteTrackingBus<BusPolicy>& Tracker() { return this->m_TrackedBus; }
+
+                //Write tracking state, for code that writes to memory without going through the tracker
+                inline const bool* CodePages() { return Tracker().m_CodePages.data(); }
+                inline bool* DirtyPages() { return Tracker().m_DirtyPages.data(); }
+                inline bool* CodeWritten() { return &Tracker().m_CodeWritten; }
+
+                //Looks the block starting at pc up, translates it on the first visit.
+                //Returns nullptr for code that can't be cached.
+                inline Block* Lookup(const Word pc) {
+                    if(Tracker().m_CodeWritten) InvalidateDirtyPages();
+                    Block* block = m_Blocks[pc].get();
+                    return block ? block : Translate(pc);
+                }
+
+                //Interprets the block's MicroOps, at most `instructions` of them.
+                //Returns the number of cycles spent that m_Cycles doesn't count yet, `instructions` is decremented
+                //by the instructions executed.
+                inline uint64_t Interpret(const Block& block, uint64_t& instructions) {
+                    uint64_t cycles = 0;
+                    for(const MicroOp& op : block.m_Ops) {
+                        //The devices watching the clock see the cycle the instruction starts on (see CPUCore::WatchClock)
+                        if(m_ClockWatched) [[unlikely]] {
+                            m_Cycles += cycles;
+                            cycles = 0;
+                        }
+                        cycles += op.m_Cycles + op.m_Handler(*this, op);
+                        //Self-modifying code : the rest of the block may be stale
+                        if(!--instructions || Tracker().m_CodeWritten) break;
+                    }
+                    return cycles;
+                }
+
+                //Code living on memory mapped I/O pages can change without being written, it is never cached
+                inline bool IsCacheable(const Byte page) const {
+                    if constexpr (requires (const BusPolicy& bus) { bus.IsDevicePage(page); })
+                        return !this->m_TrackedBus.GetTarget().IsDevicePage(page);
+                    else
+                        return true;
+                }
+
+                Block* Translate(const Word pc) {
+                    if(!IsCacheable(address(pc).GetPage())) return nullptr;
+
+                    auto block = make_unique<Block>();
+                    block->m_Start = pc;
+
+                    Word current = pc;
+                    while(block->m_Ops.size() < MAX_BLOCK_SIZE) {
+                        const Opcode& opcode = OPCODES[this->Peek(current)];
+                        const Word next = current + 1 + OperandSize(opcode.m_AddrMode);
+                        //Instructions straddling onto an uncacheable page end the block before them
+                        if(!IsCacheable(address(next - 1).GetPage())) break;
+
+                        block->m_Ops.push_back(this->Decode(current));
+                        current = next;
+                        if(IsControlFlow(opcode.m_Instruction)) break;
+                    }
+                    if(block->m_Ops.empty()) return nullptr;
+                    block->m_End = current;
+
+                    //Registers the block on every page it covers
+                    const Byte first = address(pc).GetPage();
+                    const Byte last = address(current - 1).GetPage();
+                    for(Byte page = first; ; page++) {
+                        vector<Word>& starts = m_PageBlocks[page];
+                        if(find(starts.begin(), starts.end(), pc) == starts.end()) starts.push_back(pc);
+                        Tracker().m_CodePages[page] = true;
+                        if(page == last) break;
+                    }
+
+                    m_Blocks[pc] = std::move(block);
+                    return m_Blocks[pc].get();
+                }
+
+                void InvalidateDirtyPages() {
+                    for(size_t page = 0; page < 256; page++) {
+                        if(!Tracker().m_DirtyPages[page]) continue;
+                        InvalidatePage(page);
+                    }
+                    Tracker().m_CodeWritten = false;
+                }
+
+            public :
+
+                explicit CachedCPU(BusPolicy& bus)
+                    : TrackedBusHolder<BusPolicy>(bus), Core(this->m_TrackedBus), m_Blocks(0x10000) {}
+
+                //Drops the blocks covering a page
+                void InvalidatePage(const Byte page) {
+                    for(const Word start : m_PageBlocks[page]) m_Blocks[start].reset();
+                    m_PageBlocks[page].clear();
+                    Tracker().m_CodePages[page] = false;
+                    Tracker().m_DirtyPages[page] = false;
+                }
+
+                //Drops every block
+                void Invalidate() {
+                    for(size_t page = 0; page < 256; page++) InvalidatePage(page);
+                    Tracker().m_CodeWritten = false;
+                }
+
+                //Runs at most `instructions` instructions, stops early if the CPU jams.
+                //Interrupts and events are looked at between blocks. Returns the number of cycles spent.
+                uint64_t Run(uint64_t instructions) {
+                    const uint64_t start = m_Cycles;
+                    m_IdleArmed = false;
+                    for(;;) {
+                        if(m_IdleSkip) instructions -= Core::SkipIdle(Core::GetNextDeadline(), instructions);
+                        if(m_Cycles >= m_SliceEnd) Core::Poll();
+                        if(!instructions || m_Halted) break;
+
+                        const Block* block = Lookup(m_PC);
+                        //Uncacheable code is interpreted
+                        if(!block) {
+                            m_Cycles += Core::Dispatch();
+                            instructions--;
+                            continue;
+                        }
+                        m_Cycles += Interpret(*block, instructions);
+                    }
+                    return m_Cycles - start;
+                }
+};
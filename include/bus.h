@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+#include <memory.h>
+#include <rom.h>
+#include <utils.h>
+
+using namespace std;
+
+    //Address space of the 6502, split into the 256 pages the `page` byte of an address selects.
+    //
+    //RAM and ROM pages hold a raw pointer to their 256 bytes : loads and stores to them are a
+    //table lookup and a memory access. Only pages mapped to a device dispatch to its IODevice
+    //handler. Unmapped pages read as 0 and ignore writes (open bus).
+    //
+    //Bus is final so that a CPUCore<Bus> gets ReadByte / WriteByte inlined.
+
+    class Bus final : public IODevice {
+
+        public :
+
+            struct Page {
+                const Byte* m_Read = nullptr;   //RAM and ROM
+                Byte* m_Write = nullptr;        //RAM only, writes to ROM are ignored
+                IODevice* m_Device = nullptr;   //Memory mapped I/O
+            };
+
+        private :
+
+            array<Page, 256> m_Pages {};
+
+            //Keeps the mapped devices (and memories) alive
+            vector<io_ptr> m_Owned;
+
+        public :
+
+            static shared_ptr<Bus> Make() { return make_shared<Bus>(); }
+
+            //Maps `count` pages starting at `page` onto `data` (count * 256 bytes, owned by the caller)
+            void MapRam(const Byte page, const size_t count, Byte* data);
+            void MapRom(const Byte page, const size_t count, const Byte* data);
+
+            //Maps `count` pages of a Rom, starting at its `offset`, as ROM
+            void MapRom(const Byte page, const size_t count, io_ptr rom, const size_t offset = 0);
+
+            //Maps `count` pages of a Memory, starting at its `offset`, as RAM
+            void MapMemory(const Byte page, const size_t count, io_ptr memory, const size_t offset = 0);
+
+            //Every access to these pages goes through the device, with the full address
+            void MapDevice(const Byte page, const size_t count, io_ptr device);
+
+            void Unmap(const Byte page, const size_t count);
+
+            inline const Page& GetPage(const Byte page) const { return m_Pages[page]; }
+
+            //Replaces the entry of a page as is, what it points to is kept alive by the caller (see DebugCPU)
+            inline void SetPage(const Byte page, const Page& entry) { m_Pages[page] = entry; }
+
+            inline bool IsDevicePage(const Byte page) const { return m_Pages[page].m_Device != nullptr; }
+
+            //Every device mapped, once, in page order
+            vector<IODevice*> GetDevices() const;
+
+            //IODevice Implementation
+
+            inline Byte ReadByte(const address& addr) const override {
+                const Page& page = m_Pages[addr.GetPage()];
+                if(page.m_Read) return page.m_Read[addr.GetRecord()];
+                if(page.m_Device) return page.m_Device->ReadByte(addr);
+                return 0;
+            }
+
+            //Little-endian (LLHH)
+            inline Word ReadWord(const address& addr) const override {
+                const Byte lo = ReadByte(addr);
+                const Byte hi = ReadByte(addr.GetValue() + 1);
+                return MAKE_WORD(hi, lo);
+            }
+
+            inline void WriteByte(const address& addr, const Byte data) override {
+                const Page& page = m_Pages[addr.GetPage()];
+                if(page.m_Write) page.m_Write[addr.GetRecord()] = data;
+                else if(page.m_Device) page.m_Device->WriteByte(addr, data);
+            }
+
+            inline void WriteWord(const address& addr, const Word data) override {
+                WriteByte(addr, data & 0xFF);
+                WriteByte(addr.GetValue() + 1, data >> 8);
+            }
+
+            //RAM, ROM and open bus are, devices decide
+            inline bool IsPollable(const address& addr) const override {
+                const Page& page = m_Pages[addr.GetPage()];
+                return !page.m_Device || page.m_Device->IsPollable(addr);
+            }
+
+            //The states of the mapped devices, in page order. RAM pages are the machine's business.
+            void SaveState(vector<Byte>& out) const override;
+            void LoadState(span<const Byte> in) override;
+
+            //Page by page : a copy per RAM / ROM page, byte by byte through devices
+            void ReadBytes(const address& addr, span<Byte> bytes) const override;
+            void WriteBytes(const address& addr, span<const Byte> bytes) override;
+
+    };
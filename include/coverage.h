@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <types.h>
+#include <opcodes.h>
+#include <trace.h>
+
+using namespace std;
+
+constexpr array<bool, 256> MakeControlFlowTable() {
+    array<bool, 256> table {};
+    for(size_t code = 0; code < 256; code++) table[code] = IsControlFlow(OPCODES[code].m_Instruction);
+    return table;
+}
+
+inline constexpr array<bool, 256> CONTROL_FLOW = MakeControlFlowTable();
+
+//Guest edge coverage, as a trace policy : CPUCore<BusPolicy, EdgeCoverage> counts the control flow edges
+//the program takes into a map of 8-bit saturating counters, for a fuzzer to tell inputs apart.
+//
+//An edge goes from a branch, jump, call, return or BRK to the instruction run right after it : taken and
+//not taken branches are two edges, RTS and RTI land wherever the stack says. Edges are hashed into the map,
+//whose size is a power of 2, and which the caller owns (libFuzzer reads it in place, see fuzz/fuzz_guest.cpp).
+class EdgeCoverage {
+
+        public :
+
+            static constexpr bool ENABLED = true;
+
+        protected :
+
+            //Until a map is given
+            inline static Byte s_Sink[2] {};
+
+            Byte* m_Map = s_Sink;
+            int m_Shift = 31;                   //The hash's top bits index the map
+
+            static constexpr uint32_t NO_EDGE = 0x10000;
+            uint32_t m_From = NO_EDGE;          //The control flow instruction run last
+
+        public :
+
+            EdgeCoverage() = default;
+
+            //map.size() must be a power of 2, from 2 to 2^32
+            explicit EdgeCoverage(span<Byte> map) : m_Map(map.data()), m_Shift(32 - countr_zero(map.size())) {}
+
+            inline void Record(const TraceRecord& record) {
+                if(m_From != NO_EDGE) [[unlikely]] {
+                    const uint32_t edge = (m_From << 16 | record.m_PC) * 0x9E3779B1u;
+                    Byte& counter = m_Map[edge >> m_Shift];
+                    counter += counter != 0xFF;
+                    m_From = NO_EDGE;
+                }
+                if(CONTROL_FLOW[record.m_Opcode]) m_From = record.m_PC;
+            }
+
+            //Forgets the pending edge, between two runs : the map is cleared by its owner
+            inline void Reset() { m_From = NO_EDGE; }
+};
@@ -2,106 +2,63 @@
 #include <types.h>
 #include <flags.h>
 #include <address_modes.h>
+#include <cpu_core.h>
 #include <io_device.h>
 
 
-class CPU : public IODevice{
+//Runtime-polymorphic 6502 : a thin adapter over CPUCore<IODevice>.
+//
+//The bus is any IODevice, and the addressing modes stay available as virtual entry points
+//(ExecuteAddressing / Addr_*). Step() and Run() go through the core's compile-time dispatch.
+class CPU : public IODevice, public CPUCore<IODevice> {
 
             protected :
 
-                // Program Counter:
-                // 16-bit register pointing to the next instruction for execution.
-                // This value is automatically incremented when an instruction is executed,
-                // but may be modified manually for jumps or interupts.
-                Word m_PC; 
-
-                // Stack Pointer:
-                // Holds the lower 8-bits of the next free location on the stack.
-                // The stack is generally mapped to 0x0100 - 0x01FF on the and represents
-                // 256 bytes of memory.
-                // Pushing bytes to the stack will cause the SP to decrement.
-                // Pulling bytes to the stack will increment the SP.
-                Byte m_SP;
-
-                // Accumulator:
-                // 8-bits used in all math and logical operations.
-                // Contents of which can be on either stack, or memory.
-                Byte m_Acc;
-
-                // Registers X, and Y:
-                // 8-bit memory register.
-                Byte m_X,m_Y;
-
-                //Data bus (Memory)
-                io_ptr m_Bus;
-
-
-                // Represents the current processor status as an 8-bit bitfield value.
-                Status m_CpuStatus;
-
-                //Operand value (Implicit)
-                Byte m_OpValue = 0;
+                //Data bus (Memory), the core reads and writes through the raw pointer it holds
+                io_ptr m_Device;
 
                 //IODevice Implementation
 
-                inline Byte ReadByte(const address& addr) const override;
-                inline Word ReadWord(const address& addr) const override;
-                inline void WriteByte(const address& addr, const Byte byte) override;
-                inline void WriteWord(const address& addr, const Word word) override;
-                inline void WriteBytes(const address& addr, const vector<Byte>& bytes)override;
+                inline Byte ReadByte(const address& addr) const override { return m_Bus->ReadByte( addr ); }
+                inline Word ReadWord(const address& addr) const override { return m_Bus->ReadWord( addr ); }
+                inline void WriteByte(const address& addr, const Byte byte) override { m_Bus->WriteByte( addr, byte ); }
+                inline void WriteWord(const address& addr, const Word word) override { m_Bus->WriteWord( addr, word ); }
+                inline void ReadBytes(const address& addr, span<Byte> bytes) const override { m_Bus->ReadBytes( addr, bytes ); }
+                inline void WriteBytes(const address& addr, span<const Byte> bytes) override { m_Bus->WriteBytes( addr, bytes ); }
+                inline bool IsPollable(const address& addr) const override { return m_Bus->IsPollable( addr ); }
 
 
                 inline void Write(const address& addr, const Byte data) { WriteByte( addr, data ); };
                 inline void Write(const address& addr, const Word data) { WriteWord( addr, data ); };
                 inline void Write(const address& addr, const vector<Byte>& data) { WriteBytes( addr, data ); };
-
-                inline void SetImplicit(const Byte value){
-                    m_OpValue = value;
-                }
         
             public:
 
-            //Registers & Status : 
-
-                inline const Word GetProgramCounter() const { return m_PC; }
-
-                inline const Byte GetStackPointer() const { return m_SP; }
+                explicit CPU(io_ptr bus) : CPUCore<IODevice>(*bus), m_Device(bus) {}
 
-                inline const Byte GetAccumulator() const { return m_Acc; }
+            public : //Address modes : https://www.masswerk.at/6502/6502_instruction_set.html#modes
 
-                inline const Byte GetX() const { return m_X; }
+                //Executes the right address mode and adds its page crossing penalty to the cycle count to which we have a pointer (out var)
+                virtual address ExecuteAddressing(const AddressMode addrMode, Byte& cycles);
 
-                inline const Byte GetY() const { return m_Y; }
+            protected :
 
-                inline const Status GetStatus() const { return m_CpuStatus; }
+                using AddressingHandler = address (CPU::*)( Byte& cycles );
 
-                // Masking with a statusFlag to extract the desired flag byte value
-                inline const Byte GetStatusFlag( const StatusFlag statusFlag ) const {
-                    return m_CpuStatus.m_Value & static_cast<Byte>(statusFlag) ? 1 : 0; 
-                }
+                //Dispatch table, indexed by AddressMode
+                static const array<AddressingHandler, ADDRESS_MODE_COUNT> s_AddressModes;
 
-                inline bool HasStatusFlag( const StatusFlag statusFlag ) const {
-                    return m_CpuStatus.m_Value & static_cast<Byte>(statusFlag);
-                }
+                //Undocumented opcodes have no addressing mode
+                address Addr_Ill( Byte& cycles );
 
-                inline void SetStatusFlag( const StatusFlag statusFlag, const bool val = true) {
-                    if(val) m_CpuStatus.m_Value |= static_cast<Byte>(statusFlag);
-                    //Switching all bits to 1 and desired bit to 0, then ANDing it with value to set it to :
-                    // 0 if it's set to 1 and leave it at 0 if already set to it
-                    else m_CpuStatus.m_Value &= ~(static_cast<Byte>(statusFlag)); 
+                //CPUCore::Address, with the page crossing penalty added to cycles
+                template<AddressMode addrMode>
+                inline address Addressing( Byte& cycles ) {
+                    const Target target = Address<addrMode>();
+                    cycles += target.m_PageCrossed;
+                    return target.m_Addr;
                 }
 
-                void Reset(){
-                    m_PC = 0xFFFC;
-                    m_SP = 0x0100;
-                    m_CpuStatus = {0};
-                }
-
-            public : //Address modes : https://www.masswerk.at/6502/6502_instruction_set.html#modes
-
-                //Executes the right address mode and spits the cycle count to which we have a pointer (out var)
-                virtual address ExecuteAddressing(const AddressMode addrMode, Byte& cycles);
-
             protected : 
 
                 //These instructions have register A (the accumulator) as the target. 
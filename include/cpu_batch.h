@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+#include <memory.h>
+#include <cpu_core.h>
+
+using namespace std;
+
+//Many 6502 cores stepping in lockstep, registers stored as structure of arrays.
+//
+//Lanes are processed by groups of GROUP_SIZE. On every step, the lanes of a group executing the same
+//opcode run through a single kernel : operand addresses and memory accesses are resolved lane by lane,
+//the register and flag updates are computed for the whole group at once with SIMD (AVX2 when compiled
+//with it, SSE2 otherwise on x86-64, plain loops elsewhere) and blended back under the lanes' mask.
+//Lanes running another opcode are masked out and get their own kernel in the same step.
+//
+//Every lane has its own 64 KB Memory, or shares one with others (the same ROM across many input vectors).
+//Each lane behaves as a CPUCore<Memory> would, except that m_OpValue is not tracked.
+class CPUBatch {
+
+        public :
+
+            static constexpr size_t GROUP_SIZE = 32;
+
+            using Kernel = void (*)( CPUBatch& batch, const size_t base, const Byte* mask );
+
+        protected :
+
+            size_t m_Lanes;
+
+            //Registers, padded to a multiple of GROUP_SIZE (padding lanes are halted)
+            vector<Word> m_PC;
+            vector<Byte> m_SP;
+            vector<Byte> m_A;
+            vector<Byte> m_X;
+            vector<Byte> m_Y;
+            vector<Byte> m_P;
+
+            //0xFF when the lane jammed on an undocumented opcode
+            vector<Byte> m_Halted;
+
+            vector<uint64_t> m_Cycles;
+
+            //Memory of every lane : its bytes for the reads, the Memory for the writes (dirty pages, see
+            //Memory::Snapshot), and what keeps it alive
+            vector<Byte*> m_Memory;
+            vector<Memory*> m_Rams;
+            vector<IODevice::io_ptr> m_Devices;
+
+            //One kernel per opcode byte
+            static const array<Kernel, 256> s_Kernels;
+
+            void StepGroup(const size_t base);
+
+            template<Byte code>
+            static void Execute( CPUBatch& batch, const size_t base, const Byte* mask );
+
+            template<size_t... code>
+            static constexpr array<Kernel, 256> MakeKernels( index_sequence<code...> ) {
+                return { &CPUBatch::Execute<static_cast<Byte>(code)>... };
+            }
+
+            inline Byte Read(const size_t lane, const Word addr) const { return m_Memory[lane][addr]; }
+            inline void Write(const size_t lane, const Word addr, const Byte data) { (*m_Rams[lane])[addr] = data; }
+            inline void Push(const size_t lane, const Byte value) { Write(lane, 0x0100 | m_SP[lane]--, value); }
+            inline Byte Pull(const size_t lane) { return Read(lane, 0x0100 | ++m_SP[lane]); }
+
+        public :
+
+            //Every lane gets its own 64 KB Memory
+            explicit CPUBatch(const size_t lanes);
+
+            //Every lane runs on the same Memory
+            CPUBatch(const size_t lanes, IODevice::io_ptr shared);
+
+            inline size_t GetLaneCount() const { return m_Lanes; }
+
+            //memory must be a Memory of (at least) 64 KB
+            void SetMemory(const size_t lane, IODevice::io_ptr memory);
+            inline const IODevice::io_ptr& GetMemory(const size_t lane) const { return m_Devices[lane]; }
+
+            //RESET line of a lane, as CPUCore::Reset : PC from the lane memory's RESET vector, SP at $FD, interrupts disabled.
+            //Every lane is reset on construction, lanes given a new memory or program are reset again by the host.
+            void Reset(const size_t lane);
+
+            Registers GetRegisters(const size_t lane) const;
+            void SetRegisters(const size_t lane, const Registers& registers);
+
+            inline bool IsHalted(const size_t lane) const { return m_Halted[lane]; }
+            inline uint64_t GetCycles(const size_t lane) const { return m_Cycles[lane]; }
+
+            //Every lane that isn't halted executes one instruction
+            void Step();
+
+            void Run(uint64_t instructions);
+};
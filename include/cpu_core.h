@@ -0,0 +1,1082 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <types.h>
+#include <alu.h>
+#include <flags.h>
+#include <address_modes.h>
+#include <instructions.h>
+#include <opcodes.h>
+#include <timing.h>
+#include <trace.h>
+#include <utils.h>
+
+//Programmer visible state of the 6502, plain data so that it can be copied between cores.
+struct Registers {
+
+                // Program Counter:
+                // 16-bit register pointing to the next instruction for execution.
+                // This value is automatically incremented when an instruction is executed,
+                // but may be modified manually for jumps or interupts.
+                Word m_PC;
+
+                // Stack Pointer:
+                // Holds the lower 8-bits of the next free location on the stack.
+                // The stack is generally mapped to 0x0100 - 0x01FF on the and represents
+                // 256 bytes of memory.
+                // Pushing bytes to the stack will cause the SP to decrement.
+                // Pulling bytes to the stack will increment the SP.
+                Byte m_SP;
+
+                // Accumulator:
+                // 8-bits used in all math and logical operations.
+                // Contents of which can be on either stack, or memory.
+                Byte m_Acc;
+
+                // Registers X, and Y:
+                // 8-bit memory register.
+                Byte m_X,m_Y;
+
+                // Represents the current processor status as an 8-bit bitfield value.
+                Status m_CpuStatus;
+
+                //Operand value (Implicit)
+                Byte m_OpValue = 0;
+};
+
+//Compile-time specialized 6502 core.
+//
+//BusPolicy is the type the core reads and writes through (ReadByte / ReadWord / WriteByte).
+//Every opcode gets its own handler, instantiated from the OPCODES table, in which the addressing
+//mode and the instruction are template parameters : there is no runtime dispatch left but the
+//opcode fetch itself. When BusPolicy's accessors are non-virtual (or final), they are inlined too.
+//
+//TracePolicy receives a TraceRecord for every instruction run (see trace.h), NoTrace compiles it out.
+//
+//TimingPolicy picks whole-instruction timing (FastTiming) or every bus access on its cycle (CycleExact), see timing.h.
+template<typename BusPolicy, typename TracePolicy = NoTrace, typename TimingPolicy = FastTiming>
+class CPUCore : protected Registers {
+
+            //TakeOver reads the state of the cores of other policies
+            template<typename, typename, typename> friend class CPUCore;
+
+            public :
+
+                using Handler = Byte (*)( CPUCore& cpu );
+
+                //Pre-decoded instruction (see CachedCPU) :
+                //the operand bytes are already fetched, and resolved as far as they can be without the registers.
+                struct MicroOp {
+
+                    Byte (*m_Handler)( CPUCore& cpu, const MicroOp& op );
+
+                    //Effective address (IMM, ABS, ZPG), branch target (REL), base address or pointer (indexed modes)
+                    Word m_Operand;
+
+                    //Address of the following instruction
+                    Word m_Next;
+
+                    //Base cycle count, the handler returns the penalties only
+                    Byte m_Cycles;
+
+                    //Opcode byte the op was decoded from
+                    Byte m_Code;
+                };
+
+                //Effective address of an instruction, and whether indexing it crossed a page
+                struct Target {
+                    address m_Addr;
+                    bool m_PageCrossed;
+                };
+
+                static constexpr Word NMI_VECTOR = 0xFFFA;
+                static constexpr Word RESET_VECTOR = 0xFFFC;
+                static constexpr Word IRQ_VECTOR = 0xFFFE;
+
+                //Cycles it takes to enter an interrupt (or a reset)
+                static constexpr Byte INTERRUPT_CYCLES = 7;
+
+                static constexpr uint64_t NEVER = numeric_limits<uint64_t>::max();
+
+                //Callback of a scheduled event (see Schedule), runs on the CPU's thread between instructions
+                using Event = function<void()>;
+
+            protected :
+
+                //Data bus (Memory)
+                BusPolicy* m_Bus;
+
+                //Takes no room with NoTrace
+                [[no_unique_address]] TracePolicy m_Tracer;
+
+                //Set when an undocumented opcode jammed the CPU, only a Reset() recovers from it
+                bool m_Halted = false;
+
+                //Cycles run since the core was created, the running loops add to it once they're done.
+                //A CycleExact core also counts the accesses of the current instruction on it (see Dispatch).
+                uint64_t m_Cycles = 0;
+
+                //A device reads GetCycles() during its accesses (see WatchClock) : the running loops keep m_Cycles
+                //on the current instruction, not only once they're done
+                bool m_ClockWatched = false;
+
+                //Lazy flags : m_CpuStatus only holds I, D, B and U. N and Z are derived from the last
+                //results when read, C and V are kept unpacked : setting them is a plain store, no
+                //read-modify-write of the status byte. GetStatus() packs them back.
+                Byte m_NResult = 0;     //N is its bit 7
+                Byte m_ZResult = 1;     //Z is set when it is 0
+                Byte m_Carry = 0;       //0 or 1
+                Byte m_Overflow = 0;    //V is its bit 7
+
+                static constexpr Byte LAZY_FLAGS = static_cast<Byte>(StatusFlag::CARRY) | static_cast<Byte>(StatusFlag::ZERO)
+                                                 | static_cast<Byte>(StatusFlag::INT_OVERFLOW) | static_cast<Byte>(StatusFlag::NEGATIVE);
+
+            protected : //Interrupts and events
+
+                //IRQ is level triggered and wired-OR : one bit per source holding the line low
+                uint32_t m_IrqLines = 0;
+                bool m_NmiPending = false;
+                bool m_ResetPending = false;
+
+                struct ScheduledEvent {
+                    uint64_t m_Deadline;
+                    uint64_t m_Order;       //Events due on the same cycle run in scheduling order
+                    Event m_Event;
+
+                    //Min-heap on the deadline
+                    inline bool operator<(const ScheduledEvent& other) const {
+                        return m_Deadline != other.m_Deadline ? m_Deadline > other.m_Deadline : m_Order > other.m_Order;
+                    }
+                };
+
+                vector<ScheduledEvent> m_Events;
+                uint64_t m_EventOrder = 0;
+
+                //The running loops only look at the interrupt lines and the events once m_Cycles reaches it :
+                //the next event deadline, the end of the cycle budget, or 0 when something needs attention
+                //right after the current instruction (interrupt raised, I flag cleared, CPU jammed).
+                uint64_t m_SliceEnd = 0;
+
+                //Cycle-exact, an IRQ or NMI first reads the next opcode twice, and drops it (BRK did as its implied read)
+                inline void Interrupt(const Word vector, const bool brk) {
+                    if constexpr (TimingPolicy::CYCLE_EXACT) {
+                        if(!brk) {
+                            DummyRead(m_PC);
+                            DummyRead(m_PC);
+                        }
+                    }
+                    Push(m_PC >> 8);
+                    Push(m_PC & 0xFF);
+                    Push(GetStatus().m_Value | (brk ? static_cast<Byte>(StatusFlag::BREAK) : 0) | static_cast<Byte>(StatusFlag::UNUSED));
+                    SetStatusFlag(StatusFlag::INTERRUPT);
+                    if constexpr (TimingPolicy::CYCLE_EXACT) {
+                        const Byte lo = Read(vector);
+                        m_PC = MAKE_WORD(Read(vector + 1), lo);
+                    }
+                    else m_PC = ReadWord(vector);
+                }
+
+                //Runs the events due, enters the pending interrupt (RESET, then NMI, then IRQ unless masked)
+                //and sets the next slice end. The running loops call it once m_Cycles reaches m_SliceEnd.
+                void Poll() {
+                    while(!m_Events.empty() && m_Events.front().m_Deadline <= m_Cycles) {
+                        pop_heap(m_Events.begin(), m_Events.end());
+                        const Event event = std::move(m_Events.back().m_Event);
+                        m_Events.pop_back();
+                        event();
+                    }
+
+                    if(m_ResetPending) {
+                        Reset();
+                        m_Cycles += INTERRUPT_CYCLES;
+                    }
+                    //A jammed CPU only answers to RESET. Cycle-exact, Interrupt counted its accesses.
+                    else if(!m_Halted && m_NmiPending) {
+                        m_NmiPending = false;
+                        Interrupt(NMI_VECTOR, false);
+                        if constexpr (!TimingPolicy::CYCLE_EXACT) m_Cycles += INTERRUPT_CYCLES;
+                    }
+                    else if(!m_Halted && m_IrqLines && !HasStatusFlag(StatusFlag::INTERRUPT)) {
+                        Interrupt(IRQ_VECTOR, false);
+                        if constexpr (!TimingPolicy::CYCLE_EXACT) m_Cycles += INTERRUPT_CYCLES;
+                    }
+
+                    m_SliceEnd = m_Events.empty() ? NEVER : m_Events.front().m_Deadline;
+
+                    //Memory may have changed : the next iterations of a loop tell nothing about the previous ones
+                    m_IdleArmed = false;
+                    m_IdleSkip = false;
+                }
+
+                //The running loop stops after the current instruction
+                inline void Attention() { m_SliceEnd = 0; }
+
+            protected : //Idle loops
+
+                //Busy-wait : a short loop (JMP *, BNE *, a load and a branch polling a status register...)
+                //that only reads memory nothing but an event or an interrupt changes. Once two iterations in
+                //a row start with the same registers, every following one does too, until the next deadline :
+                //the running loops skip whole iterations up to it (SkipIdle) instead of interpreting them.
+                //The cycle count comes out the same as if they had been run.
+                //
+                //A candidate body is straight-line code ending with the jump back : no writes, no stack,
+                //no other control flow, operands immediate, zero-page or absolute, and the bytes it reads
+                //(code included) on locations the bus reports as pollable (see IODevice::IsPollable).
+                struct IdleLoop {
+                    Word m_Start = 0;           //Target of the backward jump
+                    Word m_End = 0;             //The jump (branch or JMP) closing the loop
+                    bool m_Idle = false;        //The body qualifies
+                    bool m_Confirmed = false;   //Two iterations in a row started with the same registers
+                    Byte m_Cycles = 0;          //Per iteration, the jump taken
+                    Byte m_Instructions = 0;    //Per iteration
+                };
+
+                //Longest body looked at, in bytes
+                static constexpr Word MAX_IDLE_LOOP_SIZE = 16;
+
+                IdleLoop m_IdleLoop;
+                bool m_IdleArmed = false;       //m_IdleState holds the registers the last iteration started with
+                uint64_t m_IdleState = 0;
+                bool m_IdleSkip = false;        //The CPU spins in m_IdleLoop, at its start
+
+                inline bool IsPollable(const address& addr) const {
+                    if constexpr (requires (const BusPolicy& bus) { bus.IsPollable(addr); })
+                        return m_Bus->IsPollable(addr);
+                    else
+                        return false;
+                }
+
+                //Static half of the detection : does the loop from start to the jump at end qualify
+                IdleLoop AnalyzeIdleLoop(const Word start, const Word end) const {
+                    using enum AddressMode;
+
+                    IdleLoop loop { start, end };
+                    if(end < start || end - start > MAX_IDLE_LOOP_SIZE) return loop;
+
+                    uint32_t pc = start;
+                    uint32_t cycles = 0;
+                    Byte instructions = 0;
+                    while(pc != end) {
+                        if(pc > end || !IsPollable(pc)) return loop;
+
+                        const Opcode& opcode = OPCODES[Peek(pc)];
+                        const Instructions instruction = opcode.m_Instruction;
+                        const AddressMode addrMode = opcode.m_AddrMode;
+
+                        if(IsControlFlow(instruction) || (IsReadModifyWrite(instruction) && addrMode != ACC)) return loop;
+                        switch (instruction) {
+                            case Instructions::STA: case Instructions::STX: case Instructions::STY:
+                            case Instructions::PHA: case Instructions::PHP: case Instructions::PLA: case Instructions::PLP:
+                                return loop;
+                            default:
+                                break;
+                        }
+                        if(addrMode != IMP && addrMode != ACC && addrMode != IMM && addrMode != ZPG && addrMode != ABS) return loop;
+                        for(Word i = 1; i <= OperandSize(addrMode); i++)
+                            if(!IsPollable(pc + i)) return loop;
+                        if(ReadsOperand(instruction, addrMode) && addrMode != IMM) {
+                            const Word operand = addrMode == ZPG ? Peek(pc + 1) : MAKE_WORD(Peek(pc + 2), Peek(pc + 1));
+                            if(!IsPollable(operand)) return loop;
+                        }
+
+                        cycles += opcode.m_Cycles;
+                        instructions++;
+                        pc += 1 + OperandSize(addrMode);
+                    }
+
+                    //The closing jump : a taken branch pays 1 cycle, 2 when landing on another page
+                    if(!IsPollable(end) || !IsPollable(end + 1)) return loop;
+                    const Opcode& jump = OPCODES[Peek(end)];
+                    if(jump.m_AddrMode == REL) cycles += jump.m_Cycles + (address(end + 2).GetPage() != address(start).GetPage() ? 2 : 1);
+                    else if(jump.m_Instruction == Instructions::JMP && jump.m_AddrMode == ABS && IsPollable(end + 2)) cycles += jump.m_Cycles;
+                    else return loop;
+
+                    loop.m_Idle = true;
+                    loop.m_Cycles = cycles;
+                    loop.m_Instructions = instructions + 1;
+                    return loop;
+                }
+
+                //Called by the jumps taken backward (m_PC is the target, end the jump) : spots the CPU spinning.
+                //Ordinary loops only pay for the comparison with the last one looked at.
+                inline void WatchIdleLoop(const Word end) {
+                    //Traced cores see every iteration
+                    if constexpr (TracePolicy::ENABLED) return;
+
+                    if(m_PC == m_IdleLoop.m_Start && end == m_IdleLoop.m_End && !m_IdleLoop.m_Idle) return;
+                    SpotIdleLoop(end);
+                }
+
+                void SpotIdleLoop(const Word end) {
+                    if(m_PC != m_IdleLoop.m_Start || end != m_IdleLoop.m_End) {
+                        m_IdleLoop = AnalyzeIdleLoop(m_PC, end);
+                        m_IdleArmed = false;
+                        if(!m_IdleLoop.m_Idle) return;
+                    }
+
+                    const uint64_t state = m_Acc | m_X << 8 | m_Y << 16 | static_cast<uint64_t>(m_SP) << 24 | static_cast<uint64_t>(GetStatus().m_Value) << 32;
+                    if(m_IdleArmed && state == m_IdleState) {
+                        m_IdleLoop.m_Confirmed = true;
+                        m_IdleSkip = true;
+                        Attention();
+                    }
+                    m_IdleState = state;
+                    m_IdleArmed = true;
+                }
+
+                //Skips the whole iterations of m_IdleLoop that end by `end`, at most `instructions` instructions' worth.
+                //The CPU stays at the start of the loop. Returns the number of instructions skipped.
+                uint64_t SkipIdle(const uint64_t end, const uint64_t instructions) {
+                    m_IdleSkip = false;
+                    if(m_Cycles >= end) return 0;
+                    const uint64_t iterations = min((end - m_Cycles) / m_IdleLoop.m_Cycles, instructions / m_IdleLoop.m_Instructions);
+                    m_Cycles += iterations * m_IdleLoop.m_Cycles;
+                    return iterations * m_IdleLoop.m_Instructions;
+                }
+
+                //One handler per opcode byte
+                static const array<Handler, 256> s_Handlers;
+                static const array<decltype(MicroOp::m_Handler), 256> s_DecodedHandlers;
+
+                //Accesses of the instructions : a CycleExact core counts one cycle each
+                inline Byte Read(const address& addr) {
+                    const Byte value = m_Bus->ReadByte( addr );
+                    if constexpr (TimingPolicy::CYCLE_EXACT) m_Cycles++;
+                    return value;
+                }
+
+                inline void Write(const address& addr, const Byte data) {
+                    m_Bus->WriteByte( addr, data );
+                    if constexpr (TimingPolicy::CYCLE_EXACT) m_Cycles++;
+                }
+
+                //Accesses whose data the 6502 drops : only a CycleExact core performs them
+                inline void DummyRead(const address& addr) {
+                    if constexpr (TimingPolicy::CYCLE_EXACT) Read(addr);
+                }
+
+                inline void DummyWrite(const address& addr, const Byte data) {
+                    if constexpr (TimingPolicy::CYCLE_EXACT) Write(addr, data);
+                }
+
+                //Never counted : decoding and analysis (Peek), the RESET vector and the fast interrupt vectors (ReadWord)
+                inline Byte Peek(const address& addr) const { return m_Bus->ReadByte( addr ); }
+                inline Word ReadWord(const address& addr) const { return m_Bus->ReadWord( addr ); }
+
+                inline void SetImplicit(const Byte value){
+                    m_OpValue = value;
+                }
+
+                //Stack lives in page 1 (0x0100 - 0x01FF), SP points to the next free slot
+                inline void Push(const Byte value) { Write( address{ 0x01, m_SP-- }, value ); }
+                inline Byte Pull() { return Read( address{ 0x01, ++m_SP } ); }
+
+                inline void SetNZ(const Byte value) {
+                    m_NResult = value;
+                    m_ZResult = value;
+                }
+
+            public:
+
+                explicit CPUCore(BusPolicy& bus) : m_Bus(&bus) { Reset(); }
+
+            //Registers & Status :
+
+                inline const Word GetProgramCounter() const { return m_PC; }
+
+                inline const Byte GetStackPointer() const { return m_SP; }
+
+                inline const Byte GetAccumulator() const { return m_Acc; }
+
+                inline const Byte GetX() const { return m_X; }
+
+                inline const Byte GetY() const { return m_Y; }
+
+                //Materializes the lazy flags
+                inline const Status GetStatus() const {
+                    return static_cast<Byte>(m_CpuStatus.m_Value | m_Carry | (m_ZResult ? 0 : static_cast<Byte>(StatusFlag::ZERO))
+                                           | ((m_Overflow >> 1) & static_cast<Byte>(StatusFlag::INT_OVERFLOW)) | (m_NResult & static_cast<Byte>(StatusFlag::NEGATIVE)));
+                }
+
+                inline void SetStatus(const Status status) {
+                    m_CpuStatus = status.m_Value & ~LAZY_FLAGS;
+                    m_Carry = status.m_Value & static_cast<Byte>(StatusFlag::CARRY);
+                    m_ZResult = status.m_Value & static_cast<Byte>(StatusFlag::ZERO) ? 0 : 1;
+                    m_Overflow = status.m_Value << 1;
+                    m_NResult = status.m_Value;
+                }
+
+                // Masking with a statusFlag to extract the desired flag byte value
+                inline const Byte GetStatusFlag( const StatusFlag statusFlag ) const {
+                    return HasStatusFlag(statusFlag) ? 1 : 0;
+                }
+
+                //statusFlag is a constant almost everywhere : the switch folds away
+                inline bool HasStatusFlag( const StatusFlag statusFlag ) const {
+                    switch (statusFlag) {
+                        case StatusFlag::CARRY: return m_Carry;
+                        case StatusFlag::ZERO: return !m_ZResult;
+                        case StatusFlag::INT_OVERFLOW: return m_Overflow & 0x80;
+                        case StatusFlag::NEGATIVE: return m_NResult & 0x80;
+                        default: return m_CpuStatus.m_Value & static_cast<Byte>(statusFlag);
+                    }
+                }
+
+                inline void SetStatusFlag( const StatusFlag statusFlag, const bool val = true) {
+                    switch (statusFlag) {
+                        case StatusFlag::CARRY: m_Carry = val; break;
+                        case StatusFlag::ZERO: m_ZResult = !val; break;
+                        case StatusFlag::INT_OVERFLOW: m_Overflow = val ? 0x80 : 0; break;
+                        case StatusFlag::NEGATIVE: m_NResult = val ? 0x80 : 0; break;
+                        default:
+                            if(val) m_CpuStatus.m_Value |= static_cast<Byte>(statusFlag);
+                            //Switching all bits to 1 and desired bit to 0, then ANDing it with value to set it to :
+                            // 0 if it's set to 1 and leave it at 0 if already set to it
+                            else m_CpuStatus.m_Value &= ~(static_cast<Byte>(statusFlag));
+                    }
+                }
+
+                inline bool IsHalted() const { return m_Halted; }
+
+                inline uint64_t GetCycles() const { return m_Cycles; }
+                inline void SetCycles(const uint64_t cycles) { m_Cycles = cycles; }
+
+                //For the devices timing themselves on GetCycles() from their bus handlers (DeviceScheduler, ThreadedDevice) :
+                //a fast core then reports the cycle the current instruction started on, inside Run() and RunFor() too.
+                //Costs a store per instruction, cycle-exact cores always pay it.
+                inline void WatchClock() { m_ClockWatched = true; }
+
+                inline TracePolicy& GetTracer() { return m_Tracer; }
+                inline void SetTracer(TracePolicy tracer) { m_Tracer = std::move(tracer); }
+
+                //Register snapshot, Status included
+                inline Registers GetRegisters() const {
+                    Registers registers = *this;
+                    registers.m_CpuStatus = GetStatus();
+                    return registers;
+                }
+
+                inline void SetRegisters(const Registers& registers) {
+                    static_cast<Registers&>(*this) = registers;
+                    SetStatus(registers.m_CpuStatus);
+                }
+
+                //Power-on / RESET line : PC from the RESET vector, interrupts disabled.
+                //The IRQ lines and the scheduled events belong to the devices, they are kept.
+                void Reset(){
+                    m_PC = ReadWord(RESET_VECTOR);
+                    m_SP = 0xFD;
+                    m_Acc = m_X = m_Y = 0;
+                    SetStatus(static_cast<Byte>(StatusFlag::INTERRUPT) | static_cast<Byte>(StatusFlag::UNUSED));
+                    m_Halted = false;
+                    m_NmiPending = false;
+                    m_ResetPending = false;
+                    Attention();
+                }
+
+                //Carries on from `core`, a core of other policies on the same bus (see timing.h), between two
+                //instructions : registers, cycle count, interrupt lines and the scheduled events move over.
+                //The events keep what they captured : the ones calling back into `core` must go through the host.
+                template<typename OtherTrace, typename OtherTiming>
+                void TakeOver(CPUCore<BusPolicy, OtherTrace, OtherTiming>& core) {
+                    SetRegisters(core.GetRegisters());
+                    m_Halted = core.m_Halted;
+                    m_Cycles = core.m_Cycles;
+                    m_IrqLines = core.m_IrqLines;
+                    m_NmiPending = core.m_NmiPending;
+                    m_ResetPending = core.m_ResetPending;
+                    m_Events.clear();
+                    for(auto& event : core.m_Events) m_Events.push_back({ event.m_Deadline, event.m_Order, std::move(event.m_Event) });
+                    m_EventOrder = core.m_EventOrder;
+                    core.m_Events.clear();
+                    m_IdleArmed = false;
+                    m_IdleSkip = false;
+                    Attention();
+                }
+
+            public : //Interrupt lines and events
+
+                //Pulls the IRQ line low for `source` (one bit per device), until released
+                inline void AssertIRQ(const uint32_t source = 1) {
+                    m_IrqLines |= source;
+                    Attention();
+                }
+
+                inline void ReleaseIRQ(const uint32_t source = 1) { m_IrqLines &= ~source; }
+
+                inline bool IsIRQAsserted() const { return m_IrqLines; }
+
+                //NMI is edge triggered : one call, one interrupt
+                inline void TriggerNMI() {
+                    m_NmiPending = true;
+                    Attention();
+                }
+
+                inline void TriggerReset() {
+                    m_ResetPending = true;
+                    Attention();
+                }
+
+                //Runs `event` once the cycle counter reaches `deadline`, between two instructions
+                //(or two blocks, for the caching cores)
+                void Schedule(const uint64_t deadline, Event event) {
+                    m_Events.push_back({ deadline, m_EventOrder++, std::move(event) });
+                    push_heap(m_Events.begin(), m_Events.end());
+                    m_SliceEnd = min(m_SliceEnd, deadline);
+                }
+
+                inline uint64_t GetNextDeadline() const { return m_Events.empty() ? NEVER : m_Events.front().m_Deadline; }
+
+            public : //Execution
+
+                //Fetches, decodes (through the OPCODES table) and executes the instruction at m_PC,
+                //after entering the pending interrupt if any. Returns the number of cycles it took.
+                inline Byte Step() {
+                    const uint64_t start = m_Cycles;
+                    if(m_Cycles >= m_SliceEnd) Poll();
+                    m_Cycles += Dispatch();
+                    return m_Cycles - start;
+                }
+
+                //Steps through at most `instructions` instructions, stops early if the CPU jams.
+                //Returns the number of cycles spent.
+                uint64_t Run(uint64_t instructions) {
+                    const uint64_t start = m_Cycles;
+                    //The host may have written to memory
+                    m_IdleArmed = false;
+                    for(;;) {
+                        if(m_Cycles >= m_SliceEnd) Poll();
+                        if(!instructions || m_Halted) break;
+
+                        //Up to the next deadline, without looking at the interrupt lines
+                        uint64_t cycles = m_Cycles;
+                        while(instructions && cycles < m_SliceEnd) {
+                            if(TimingPolicy::CYCLE_EXACT || m_ClockWatched) m_Cycles = cycles;
+                            cycles += Dispatch();
+                            instructions--;
+                        }
+                        m_Cycles = cycles;
+                        if(m_IdleSkip) instructions -= SkipIdle(GetNextDeadline(), instructions);
+                    }
+                    return m_Cycles - start;
+                }
+
+                //Runs for `budget` cycles (the last instruction may overshoot it), stops early if the CPU jams.
+                //Returns the number of cycles spent.
+                uint64_t RunFor(const uint64_t budget) {
+                    const uint64_t start = m_Cycles;
+                    const uint64_t end = start + budget;
+                    m_IdleArmed = false;
+                    for(;;) {
+                        if(m_Cycles >= m_SliceEnd) Poll();
+                        if(m_Cycles >= end || m_Halted) break;
+
+                        //Up to the next deadline or the end of the budget, without looking at the interrupt lines
+                        m_SliceEnd = min(m_SliceEnd, end);
+                        uint64_t cycles = m_Cycles;
+                        while(cycles < m_SliceEnd) {
+                            if(TimingPolicy::CYCLE_EXACT || m_ClockWatched) m_Cycles = cycles;
+                            cycles += Dispatch();
+                        }
+                        m_Cycles = cycles;
+                        if(m_IdleSkip) SkipIdle(min(GetNextDeadline(), end), NEVER);
+                    }
+                    return m_Cycles - start;
+                }
+
+                //Steps until predicate(cpu) holds before an instruction (GetCycles() is up to date), or the CPU jams.
+                //Returns the number of cycles spent.
+                template<typename Predicate>
+                uint64_t RunUntil(Predicate predicate) {
+                    const uint64_t start = m_Cycles;
+                    for(;;) {
+                        if(m_Cycles >= m_SliceEnd) Poll();
+                        if(m_Halted || predicate(static_cast<const CPUCore&>(*this))) break;
+                        m_Cycles += Dispatch();
+                    }
+                    return m_Cycles - start;
+                }
+
+                //Decodes the instruction at pc, reading its operand through the bus
+                MicroOp Decode( const Word pc ) const {
+                    const Byte code = Peek(pc);
+                    const Opcode& opcode = OPCODES[code];
+                    const Byte size = OperandSize(opcode.m_AddrMode);
+                    const Word next = pc + 1 + size;
+
+                    //Implied and Immediate : the operand is the address following the opcode
+                    Word operand = pc + 1;
+                    if(opcode.m_AddrMode == AddressMode::REL) operand = next + static_cast<signed char>(Peek(pc + 1));
+                    else if(opcode.m_AddrMode != AddressMode::IMM && size == 1) operand = Peek(pc + 1);
+                    else if(size == 2) operand = MAKE_WORD(Peek(pc + 2), Peek(pc + 1));
+
+                    return { s_DecodedHandlers[code], operand, next, opcode.m_Cycles, code };
+                }
+
+            protected :
+
+                //Step() without the cycle accounting, for the running loops.
+                //Cycle-exact, m_Cycles runs along the accesses (the loops keep it up to date), and is wound back once
+                //the instruction returns its cycles : the callers account them the same way for both timings.
+                inline Byte Dispatch() {
+                    const Byte code = Read(m_PC);
+                    m_PC++;
+                    const Byte cycles = s_Handlers[code](*this);
+                    if constexpr (TimingPolicy::CYCLE_EXACT) m_Cycles -= cycles;
+                    return cycles;
+                }
+
+            protected : //Address modes : https://www.masswerk.at/6502/6502_instruction_set.html#modes
+
+                //Fetches the operand bytes following the opcode and resolves the effective address
+                //of the operand (the branch target for REL). The opcode's page crossing penalty, if any,
+                //is applied by Op from the OPCODES table. See CPU::Addr_* for the description of every mode.
+                template<AddressMode addrMode>
+                inline Target Address();
+
+                //Resolves the effective address from the already fetched operand (see MicroOp::m_Operand)
+                template<AddressMode addrMode>
+                inline Target Resolve( const Word operand );
+
+            protected : //Instructions : https://www.masswerk.at/6502/6502_instruction_set.html#description
+
+                //Instruction semantics on the effective address,
+                //returns the branching penalties.
+                template<Instructions instruction, AddressMode addrMode>
+                inline Byte Execute( const address& addr );
+
+                //Shared bodies of the instructions above
+                inline void AddWithCarry( const Byte value );
+                inline void DecimalArithmetic( const array<Word, DECIMAL_TABLE_SIZE>& table, const Byte value );
+                template<Instructions instruction>
+                inline Byte Shift( const Byte value );
+                inline void Compare( const Byte reg, const Byte value );
+                inline Byte Branch( const bool condition, const address& target );
+
+                //Read-Modify-Write on either the accumulator (ACC) or memory
+                template<AddressMode addrMode, typename Operation>
+                inline void Modify( const address& addr, Operation operation );
+
+                //Registers before the instruction at pc, the cycles and the address are filled in once it ran
+                inline TraceRecord TraceBefore( const Word pc, const Byte code ) const {
+                    return { pc, 0, code, m_Acc, m_X, m_Y, m_SP, GetStatus().m_Value, 0 };
+                }
+
+                inline void Trace( TraceRecord& record, const address& addr, const Byte cycles ) {
+                    record.m_Addr = addr.GetValue();
+                    record.m_Cycles = cycles;
+                    m_Tracer.Record(record);
+                }
+
+                template<Byte code>
+                static Byte Op( CPUCore& cpu ) {
+                    using enum AddressMode;
+                    constexpr Opcode opcode = OPCODES[code];
+
+                    //Cycle-exact, JSR only fetches the low byte of its target here : the high one comes after the pushes (see Execute)
+                    constexpr bool call = TimingPolicy::CYCLE_EXACT && opcode.m_Instruction == Instructions::JSR;
+
+                    //The opcode is already fetched
+                    [[maybe_unused]] const uint64_t start = cpu.m_Cycles - 1;
+                    [[maybe_unused]] TraceRecord record;
+                    if constexpr (TracePolicy::ENABLED) record = cpu.TraceBefore(cpu.m_PC - 1, code);
+
+                    const Target target = cpu.template Address<call ? ZPG : opcode.m_AddrMode>();
+
+                    //While it carries into the high byte, an indexed mode reads from the address on the base page. Reads that
+                    //pay the page crossing penalty skip it when there is no carry (it was the right address), stores and
+                    //read-modify-writes always pay it.
+                    if constexpr (TimingPolicy::CYCLE_EXACT && (opcode.m_AddrMode == ABX || opcode.m_AddrMode == ABY || opcode.m_AddrMode == INY)) {
+                        if(!opcode.m_PageCross || target.m_PageCrossed)
+                            cpu.Read(static_cast<Word>(target.m_Addr.GetValue() - (target.m_PageCrossed ? 0x100 : 0)));
+                    }
+
+                    Byte cycles = opcode.m_Cycles;
+                    if constexpr (opcode.m_PageCross) cycles += target.m_PageCrossed;
+                    cycles += cpu.template Execute<opcode.m_Instruction, opcode.m_AddrMode>(target.m_Addr);
+
+                    //One access per cycle
+                    if constexpr (TimingPolicy::CYCLE_EXACT) cycles = cpu.m_Cycles - start;
+
+                    if constexpr (TracePolicy::ENABLED) cpu.Trace(record, call ? address(cpu.m_PC) : target.m_Addr, cycles);
+                    return cycles;
+                }
+
+                //Same as Op, on a pre-decoded instruction
+                template<Byte code>
+                static Byte DecodedOp( CPUCore& cpu, const MicroOp& op ) {
+                    constexpr Opcode opcode = OPCODES[code];
+
+                    [[maybe_unused]] TraceRecord record;
+                    if constexpr (TracePolicy::ENABLED) record = cpu.TraceBefore(op.m_Next - 1 - OperandSize(opcode.m_AddrMode), code);
+
+                    cpu.m_PC = op.m_Next;
+
+                    const Target target = cpu.template Resolve<opcode.m_AddrMode>(op.m_Operand);
+
+                    Byte cycles = 0;
+                    if constexpr (opcode.m_PageCross) cycles += target.m_PageCrossed;
+                    cycles += cpu.template Execute<opcode.m_Instruction, opcode.m_AddrMode>(target.m_Addr);
+
+                    //The base cycles are accounted by the block, the record gets them too
+                    if constexpr (TracePolicy::ENABLED) cpu.Trace(record, target.m_Addr, op.m_Cycles + cycles);
+                    return cycles;
+                }
+
+                template<size_t... code>
+                static constexpr array<Handler, 256> MakeHandlers( index_sequence<code...> ) {
+                    return { &CPUCore::Op<static_cast<Byte>(code)>... };
+                }
+
+                template<size_t... code>
+                static constexpr array<decltype(MicroOp::m_Handler), 256> MakeDecodedHandlers( index_sequence<code...> ) {
+                    return { &CPUCore::DecodedOp<static_cast<Byte>(code)>... };
+                }
+};
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+const array<typename CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Handler, 256> CPUCore<BusPolicy, TracePolicy, TimingPolicy>::s_Handlers = CPUCore<BusPolicy, TracePolicy, TimingPolicy>::MakeHandlers(make_index_sequence<256>{});
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+const array<decltype(CPUCore<BusPolicy, TracePolicy, TimingPolicy>::MicroOp::m_Handler), 256> CPUCore<BusPolicy, TracePolicy, TimingPolicy>::s_DecodedHandlers = CPUCore<BusPolicy, TracePolicy, TimingPolicy>::MakeDecodedHandlers(make_index_sequence<256>{});
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+template<AddressMode addrMode>
+inline typename CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Target CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Address() {
+
+    using enum AddressMode;
+
+    Word operand;
+
+    //Accumulator / Implied : nothing to fetch, the next byte is read all the same
+    if constexpr (OperandSize(addrMode) == 0) {
+        operand = m_PC;
+        DummyRead(m_PC);
+    }
+
+    //Immediate : the operand is the byte following the opcode
+    else if constexpr (addrMode == IMM) {
+        operand = m_PC++;
+    }
+
+    else if constexpr (OperandSize(addrMode) == 1) {
+        operand = Read(m_PC);
+        m_PC++;
+        //The offset is signed (two's complement) and relative to the next instruction
+        if constexpr (addrMode == REL) operand = m_PC + static_cast<signed char>(operand);
+    }
+
+    else {
+        const Byte addr_lo = Read(m_PC);
+        m_PC++;
+        const Byte addr_hi = Read(m_PC);
+        m_PC++;
+        operand = MAKE_WORD(addr_hi,addr_lo);
+    }
+
+    return Resolve<addrMode>(operand);
+}
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+template<AddressMode addrMode>
+inline typename CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Target CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Resolve( const Word operand ) {
+
+    using enum AddressMode;
+
+    //Accumulator / Implied
+    if constexpr (addrMode == ACC || addrMode == IMP) {
+        SetImplicit(m_Acc);
+        return { operand, false };
+    }
+
+    //Immediate, Absolute, Zero-Page and Relative : the operand already is the effective address
+    else if constexpr (addrMode == IMM || addrMode == ABS || addrMode == ZPG || addrMode == REL) {
+        return { operand, false };
+    }
+
+    //Absolute,X / Absolute,Y
+    //Crosses a page when the index carries into the high byte
+    else if constexpr (addrMode == ABX || addrMode == ABY) {
+        const address addr = operand + (addrMode == ABX ? m_X : m_Y);
+        return { addr, addr.GetPage() != address(operand).GetPage() };
+    }
+
+    //Zero-Page,X / Zero-Page,Y
+    //The base address is read while the index is added
+    else if constexpr (addrMode == ZPX || addrMode == ZPY) {
+        DummyRead(address{0x00,static_cast<Byte>(operand)});
+        return { address::AddZeroPage(addrMode == ZPX ? m_X : m_Y,static_cast<Byte>(operand)), false };
+    }
+
+    //Indirect (Basic form : lookup)
+    else if constexpr (addrMode == IND) {
+        const address lookup = operand;
+        //The pointer never crosses a page : JMP ($10FF) reads its high byte from $1000
+        const address lookup_hi = {lookup.GetPage(),static_cast<Byte>(lookup.GetRecord() + 1)};
+        const Byte lo = Read(lookup);
+        return { MAKE_WORD(Read(lookup_hi),lo), false };
+    }
+
+    //Pre-Indexed Indirect (Zero-Page,X)
+    else if constexpr (addrMode == INX) {
+        DummyRead(address{0x00,static_cast<Byte>(operand)});
+        const address lookup = address::AddZeroPage(m_X,static_cast<Byte>(operand));
+        //The pointer wraps arround the zero page
+        const address lookup_hi = address::AddZeroPage(1,lookup);
+        const Byte lo = Read(lookup);
+        return { MAKE_WORD(Read(lookup_hi),lo), false };
+    }
+
+    //Post-Indexed Indirect (Zero-Page),Y
+    //Crosses a page when Y carries into the high byte of the pointer
+    else if constexpr (addrMode == INY) {
+        const address pointer = {0x00,static_cast<Byte>(operand)};
+        const address pointer_hi = address::AddZeroPage(1,pointer);
+        const Byte lo = Read(pointer);
+        const address lookup = MAKE_WORD(Read(pointer_hi),lo);
+        const address addr = lookup.GetValue() + m_Y;
+        return { addr, addr.GetPage() != lookup.GetPage() };
+    }
+
+    //Undocumented opcodes have no addressing mode
+    else {
+        return { operand, false };
+    }
+}
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+inline void CPUCore<BusPolicy, TracePolicy, TimingPolicy>::AddWithCarry( const Byte value ) {
+    const Word sum = m_Acc + value + m_Carry;
+    m_Carry = sum > 0xFF;
+    //Overflow when both operands share a sign the result doesn't have
+    m_Overflow = ~(m_Acc ^ value) & (m_Acc ^ sum);
+    m_Acc = sum & 0xFF;
+    SetNZ(m_Acc);
+}
+
+//ADC / SBC in decimal mode : result and flags come from the table entry
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+inline void CPUCore<BusPolicy, TracePolicy, TimingPolicy>::DecimalArithmetic( const array<Word, DECIMAL_TABLE_SIZE>& table, const Byte value ) {
+    const Word entry = table[DecimalIndex(m_Carry, m_Acc, value)];
+    const Byte flags = entry >> 8;
+    m_Acc = entry & 0xFF;
+    m_Carry = flags & static_cast<Byte>(StatusFlag::CARRY);
+    m_ZResult = flags & static_cast<Byte>(StatusFlag::ZERO) ? 0 : 1;
+    m_Overflow = flags << 1;
+    m_NResult = flags;
+}
+
+//ASL, LSR, ROL, ROR : only the carry is taken from the entry, Modify() sets N and Z from the result
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+template<Instructions instruction>
+inline Byte CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Shift( const Byte value ) {
+    const Word entry = ShiftEntry<instruction>(value, m_Carry);
+    m_Carry = (entry >> 8) & static_cast<Byte>(StatusFlag::CARRY);
+    return entry & 0xFF;
+}
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+inline void CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Compare( const Byte reg, const Byte value ) {
+    SetStatusFlag(StatusFlag::CARRY, reg >= value);
+    SetNZ(reg - value);
+}
+
+//Add 1 cycle if branch occurs on same page
+//Add 2 cycles if branch occurs on different page
+//Taken backward, it may close a busy-wait (see WatchIdleLoop)
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+inline Byte CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Branch( const bool condition, const address& target ) {
+    if(!condition) return 0;
+    const Word end = m_PC - 2;
+    const Byte penalty = address(m_PC).GetPage() != target.GetPage() ? 2 : 1;
+    //The next opcode is read while the target is computed, then the target's low byte on the old page while it is fixed
+    DummyRead(m_PC);
+    if(penalty == 2) DummyRead(address{address(m_PC).GetPage(),target.GetRecord()});
+    m_PC = target.GetValue();
+    if(m_PC <= end) WatchIdleLoop(end);
+    return penalty;
+}
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+template<AddressMode addrMode, typename Operation>
+inline void CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Modify( const address& addr, Operation operation ) {
+    if constexpr (addrMode == AddressMode::ACC) {
+        m_Acc = operation(m_Acc);
+        SetNZ(m_Acc);
+    }
+    else {
+        const Byte old = Read(addr);
+        //The old value is written back while the new one is computed
+        DummyWrite(addr, old);
+        const Byte value = operation(old);
+        Write(addr, value);
+        SetNZ(value);
+    }
+}
+
+template<typename BusPolicy, typename TracePolicy, typename TimingPolicy>
+template<Instructions instruction, AddressMode addrMode>
+inline Byte CPUCore<BusPolicy, TracePolicy, TimingPolicy>::Execute( const address& addr ) {
+
+    using enum Instructions;
+
+    //Various :
+    if constexpr (instruction == BRK) {
+        //The byte following BRK is skipped (padding / break mark)
+        m_PC++;
+        Interrupt(IRQ_VECTOR, true);
+    }
+    else if constexpr (instruction == NOP) {}
+    else if constexpr (instruction == RTI) {
+        DummyRead(address{0x01,m_SP});
+        SetStatus((Pull() & ~static_cast<Byte>(StatusFlag::BREAK)) | static_cast<Byte>(StatusFlag::UNUSED));
+        const Byte lo = Pull();
+        const Byte hi = Pull();
+        m_PC = MAKE_WORD(hi, lo);
+        //A held IRQ may be unmasked
+        if(m_IrqLines) Attention();
+    }
+    else if constexpr (instruction == RTS) {
+        DummyRead(address{0x01,m_SP});
+        const Byte lo = Pull();
+        const Byte hi = Pull();
+        //The pulled address is read while it is incremented
+        m_PC = MAKE_WORD(hi, lo);
+        DummyRead(m_PC);
+        m_PC++;
+    }
+
+    else if constexpr (instruction == ADC) {
+        const Byte value = Read(addr);
+        if(HasStatusFlag(StatusFlag::DECIMAL)) DecimalArithmetic(ADC_DECIMAL, value);
+        else AddWithCarry(value);
+    }
+
+    //Comparison :
+    else if constexpr (instruction == AND) SetNZ(m_Acc &= Read(addr));
+    else if constexpr (instruction == EOR) SetNZ(m_Acc ^= Read(addr));
+    else if constexpr (instruction == ORA) SetNZ(m_Acc |= Read(addr));
+    else if constexpr (instruction == BIT) {
+        const Byte value = Read(addr);
+        //Z from A AND M, N and V straight from bits 7 and 6 of M
+        m_ZResult = m_Acc & value;
+        m_NResult = value;
+        m_Overflow = value << 1;
+    }
+
+    else if constexpr (instruction == CMP) Compare(m_Acc, Read(addr));
+    else if constexpr (instruction == CPX) Compare(m_X, Read(addr));
+    else if constexpr (instruction == CPY) Compare(m_Y, Read(addr));
+
+    //Bit operations :
+    else if constexpr (instruction == ASL || instruction == LSR || instruction == ROL || instruction == ROR)
+        Modify<addrMode>(addr, [this](const Byte value) -> Byte { return Shift<instruction>(value); });
+
+    //Branching :
+    else if constexpr (instruction == BCC) return Branch(!HasStatusFlag(StatusFlag::CARRY), addr);
+    else if constexpr (instruction == BCS) return Branch(HasStatusFlag(StatusFlag::CARRY), addr);
+    else if constexpr (instruction == BEQ) return Branch(HasStatusFlag(StatusFlag::ZERO), addr);
+    else if constexpr (instruction == BMI) return Branch(HasStatusFlag(StatusFlag::NEGATIVE), addr);
+    else if constexpr (instruction == BPL) return Branch(!HasStatusFlag(StatusFlag::NEGATIVE), addr);
+    else if constexpr (instruction == BNE) return Branch(!HasStatusFlag(StatusFlag::ZERO), addr);
+    else if constexpr (instruction == BVC) return Branch(!HasStatusFlag(StatusFlag::INT_OVERFLOW), addr);
+    else if constexpr (instruction == BVS) return Branch(HasStatusFlag(StatusFlag::INT_OVERFLOW), addr);
+
+    //Flags manipulation :
+    else if constexpr (instruction == CLC) SetStatusFlag(StatusFlag::CARRY, false);
+    else if constexpr (instruction == SEC) SetStatusFlag(StatusFlag::CARRY);
+    else if constexpr (instruction == CLD) SetStatusFlag(StatusFlag::DECIMAL, false);
+    else if constexpr (instruction == SED) SetStatusFlag(StatusFlag::DECIMAL);
+    else if constexpr (instruction == CLI) {
+        SetStatusFlag(StatusFlag::INTERRUPT, false);
+        if(m_IrqLines) Attention();
+    }
+    else if constexpr (instruction == SEI) SetStatusFlag(StatusFlag::INTERRUPT);
+    else if constexpr (instruction == CLV) SetStatusFlag(StatusFlag::INT_OVERFLOW, false);
+
+    //Memory and indexes manipulation :
+    else if constexpr (instruction == INC) Modify<addrMode>(addr, [](const Byte value) -> Byte { return value + 1; });
+    else if constexpr (instruction == INX) SetNZ(++m_X);
+    else if constexpr (instruction == INY) SetNZ(++m_Y);
+
+    else if constexpr (instruction == DEC) Modify<addrMode>(addr, [](const Byte value) -> Byte { return value - 1; });
+    else if constexpr (instruction == DEX) SetNZ(--m_X);
+    else if constexpr (instruction == DEY) SetNZ(--m_Y);
+
+    //Jumps :
+    else if constexpr (instruction == JMP) {
+        if constexpr (addrMode == AddressMode::ABS) {
+            const Word end = m_PC - 3;
+            m_PC = addr.GetValue();
+            if(m_PC <= end) WatchIdleLoop(end);
+        }
+        else m_PC = addr.GetValue();
+    }
+    else if constexpr (instruction == JSR) {
+        //Pushes the address of the last byte of the JSR instruction
+        if constexpr (TimingPolicy::CYCLE_EXACT) {
+            //addr only holds the low byte of the target (see Op), m_PC is on the high one
+            DummyRead(address{0x01,m_SP});
+            Push(m_PC >> 8);
+            Push(m_PC & 0xFF);
+            m_PC = MAKE_WORD(Read(m_PC), addr.GetRecord());
+        }
+        else {
+            const Word ret = m_PC - 1;
+            Push(ret >> 8);
+            Push(ret & 0xFF);
+            m_PC = addr.GetValue();
+        }
+    }
+
+    //Data transfer :
+    else if constexpr (instruction == LDA) SetNZ(m_Acc = Read(addr));
+    else if constexpr (instruction == LDX) SetNZ(m_X = Read(addr));
+    else if constexpr (instruction == LDY) SetNZ(m_Y = Read(addr));
+
+    else if constexpr (instruction == STA) Write(addr, m_Acc);
+    else if constexpr (instruction == STX) Write(addr, m_X);
+    else if constexpr (instruction == STY) Write(addr, m_Y);
+
+    else if constexpr (instruction == TAX) SetNZ(m_X = m_Acc);
+    else if constexpr (instruction == TAY) SetNZ(m_Y = m_Acc);
+    else if constexpr (instruction == TSX) SetNZ(m_X = m_SP);
+    else if constexpr (instruction == TXA) SetNZ(m_Acc = m_X);
+    else if constexpr (instruction == TXS) m_SP = m_X;
+    else if constexpr (instruction == TYA) SetNZ(m_Acc = m_Y);
+
+    else if constexpr (instruction == PHA) Push(m_Acc);
+    else if constexpr (instruction == PHP) Push(GetStatus().m_Value | static_cast<Byte>(StatusFlag::BREAK) | static_cast<Byte>(StatusFlag::UNUSED));
+    //The pulls read the stack once before SP moves
+    else if constexpr (instruction == PLA) {
+        DummyRead(address{0x01,m_SP});
+        SetNZ(m_Acc = Pull());
+    }
+    else if constexpr (instruction == PLP) {
+        DummyRead(address{0x01,m_SP});
+        SetStatus((Pull() & ~static_cast<Byte>(StatusFlag::BREAK)) | static_cast<Byte>(StatusFlag::UNUSED));
+        if(m_IrqLines) Attention();
+    }
+
+    //Substraction :
+    //Binary substraction is an addition of the one's complement (the carry acts as an inverted borrow)
+    else if constexpr (instruction == SBC) {
+        const Byte value = Read(addr);
+        if(HasStatusFlag(StatusFlag::DECIMAL)) DecimalArithmetic(SBC_DECIMAL, value);
+        else AddWithCarry(~value);
+    }
+
+    //Illegal :
+    else if constexpr (instruction == ILL) {
+        m_PC--; //Stays on the jamming opcode
+        m_Halted = true;
+        Attention();
+    }
+
+    return 0;
+}
@@ -0,0 +1,332 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+#include <bus.h>
+#include <cpu_core.h>
+
+using namespace std;
+
+class DebugCPU;
+
+//Per page trap bits of a DebugCPU
+enum : Byte {
+    TRAP_EXECUTE = 1 << 0,      //A breakpoint lies on the page
+    TRAP_READ = 1 << 1,         //A read watchpoint covers part of the page
+    TRAP_WRITE = 1 << 2         //A write watchpoint covers part of the page
+};
+
+//Stands in for a page of the bus a watchpoint covers : the watched accesses come here, report to the
+//debugger and go on to what the page maps. The other accesses to the page still go straight to its RAM / ROM.
+class TrapPage final : public IODevice {
+
+        private :
+
+            DebugCPU* m_Debugger;
+            Bus::Page m_Page;           //As the page was mapped
+
+        public :
+
+            TrapPage(DebugCPU& debugger, const Bus::Page& page) : m_Debugger(&debugger), m_Page(page) {}
+
+            inline const Bus::Page& GetPage() const { return m_Page; }
+
+            //IODevice Implementation
+
+            inline Byte ReadByte(const address& addr) const override;
+
+            inline Word ReadWord(const address& addr) const override {
+                const Byte lo = ReadByte(addr);
+                const Byte hi = ReadByte(addr.GetValue() + 1);
+                return MAKE_WORD(hi, lo);
+            }
+
+            inline void WriteByte(const address& addr, const Byte data) override;
+
+            inline void WriteWord(const address& addr, const Word data) override {
+                WriteByte(addr, data & 0xFF);
+                WriteByte(addr.GetValue() + 1, data >> 8);
+            }
+
+            //Every watched read must be seen : a loop polling the page isn't skipped (see CPUCore::WatchIdleLoop)
+            inline bool IsPollable(const address& addr) const override { return false; }
+};
+
+//6502 core stopping on breakpoints and watchpoints, on a Bus.
+//
+//Breakpoints stop before the instruction at their address runs, watchpoints right after the instruction
+//that read or wrote their range (operand fetches included : a read watchpoint on code fires when it runs).
+//Both may carry a condition on the registers, only evaluated when they are hit.
+//
+//Watchpoints are set in the bus' page table : the pages they cover are remapped to a TrapPage, for the
+//accesses they watch only, and mapped back once removed. Every other access keeps its direct RAM / ROM
+//pointer. Breakpoints flag their page, which the running loop looks up when the PC changes page ; with no
+//breakpoint set, it doesn't look at all. Without traps, the core runs as fast as a CPUCore<Bus>.
+//Remap the bus and take save states with no watchpoint set, the TrapPages would be taken for devices.
+//
+//Run / RunFor / Step return once a breakpoint or a watchpoint hits, GetStop() tells which one.
+//Running again resumes from there : the instruction a breakpoint stopped on runs without stopping again.
+class DebugCPU : public CPUCore<Bus> {
+
+        friend class TrapPage;
+
+            public :
+
+                using Core = CPUCore<Bus>;
+
+                //Evaluated on the registers when the breakpoint or the watchpoint is hit, empty always holds
+                using Condition = function<bool( const Registers& registers )>;
+
+                enum class StopReason : Byte {
+                    NONE,
+                    BREAKPOINT,
+                    READ,
+                    WRITE
+                };
+
+                struct Stop {
+                    StopReason m_Reason = StopReason::NONE;
+                    uint32_t m_Id = 0;          //Of the breakpoint or the watchpoint
+                    Word m_Address = 0;         //The breakpoint's, or the address accessed
+                    Byte m_Value = 0;           //Byte read or written
+                };
+
+            protected :
+
+                using Core::m_PC;
+                using Core::m_Halted;
+                using Core::m_Cycles;
+                using Core::m_SliceEnd;
+                using Core::m_ClockWatched;
+                using Core::m_IdleArmed;
+                using Core::m_IdleSkip;
+                using Core::m_Bus;
+
+                struct Breakpoint {
+                    uint32_t m_Id;
+                    Word m_Address;
+                    Condition m_Condition;
+                };
+
+                struct Watchpoint {
+                    uint32_t m_Id;
+                    Word m_First;
+                    Word m_Last;
+                    Byte m_Access;              //TRAP_READ and / or TRAP_WRITE
+                    Condition m_Condition;
+                };
+
+                vector<Breakpoint> m_Breakpoints;
+                vector<Watchpoint> m_Watchpoints;
+                uint32_t m_NextId = 1;
+
+                array<Byte, 256> m_Traps {};
+                array<unique_ptr<TrapPage>, 256> m_TrapPages;
+
+                Stop m_Stop;
+                bool m_Running = false;         //Only the CPU's accesses hit the watchpoints, not the host's
+
+                inline bool Holds(const Condition& condition) const {
+                    return !condition || condition(Core::GetRegisters());
+                }
+
+                //The trap bits, from the breakpoint and watchpoint lists, and the pages remapped accordingly
+                void UpdateTraps() {
+                    array<Byte, 256> traps {};
+                    for(const Breakpoint& breakpoint : m_Breakpoints) traps[breakpoint.m_Address >> 8] |= TRAP_EXECUTE;
+                    for(const Watchpoint& watchpoint : m_Watchpoints)
+                        for(size_t page = watchpoint.m_First >> 8; page <= static_cast<size_t>(watchpoint.m_Last >> 8); page++) traps[page] |= watchpoint.m_Access;
+
+                    for(size_t page = 0; page < 256; page++) {
+                        const Byte watched = traps[page] & (TRAP_READ | TRAP_WRITE);
+                        if(watched == (m_Traps[page] & (TRAP_READ | TRAP_WRITE))) continue;
+
+                        if(m_TrapPages[page]) {
+                            m_Bus->SetPage(page, m_TrapPages[page]->GetPage());
+                            m_TrapPages[page].reset();
+                        }
+                        if(!watched) continue;
+
+                        //The watched accesses lose their direct pointer, and fall back to the device
+                        const Bus::Page& mapped = m_Bus->GetPage(page);
+                        m_TrapPages[page] = make_unique<TrapPage>(*this, mapped);
+                        Bus::Page trapped = mapped;
+                        if(watched & TRAP_READ) trapped.m_Read = nullptr;
+                        if(watched & TRAP_WRITE) trapped.m_Write = nullptr;
+                        trapped.m_Device = m_TrapPages[page].get();
+                        m_Bus->SetPage(page, trapped);
+                    }
+                    m_Traps = traps;
+                }
+
+                //Slow path of the running loop, on a page flagged TRAP_EXECUTE
+                bool HitBreakpoint() {
+                    for(const Breakpoint& breakpoint : m_Breakpoints) {
+                        if(breakpoint.m_Address != m_PC || !Holds(breakpoint.m_Condition)) continue;
+                        m_Stop = { StopReason::BREAKPOINT, breakpoint.m_Id, m_PC, 0 };
+                        return true;
+                    }
+                    return false;
+                }
+
+                //Slow path of the bus, from a TrapPage.
+                //The running loop stops after the current instruction, the first hit is kept.
+                void OnAccess(const Byte access, const address& addr, const Byte value) {
+                    if(!m_Running || m_Stop.m_Reason != StopReason::NONE) return;
+                    const Word location = addr.GetValue();
+                    for(const Watchpoint& watchpoint : m_Watchpoints) {
+                        if(!(watchpoint.m_Access & access) || location < watchpoint.m_First || location > watchpoint.m_Last) continue;
+                        if(!Holds(watchpoint.m_Condition)) continue;
+                        m_Stop = { access == TRAP_READ ? StopReason::READ : StopReason::WRITE, watchpoint.m_Id, location, value };
+                        Core::Attention();
+                        return;
+                    }
+                }
+
+                //Never a PC
+                static constexpr uint32_t NO_RESUME = 0x10000;
+
+                //Where the last run stopped on a breakpoint
+                inline uint32_t ResumeAddress() const {
+                    return m_Stop.m_Reason == StopReason::BREAKPOINT ? m_Stop.m_Address : NO_RESUME;
+                }
+
+                //Runs at most `instructions` instructions or up to the `end` cycle, whichever comes first.
+                //The instruction at `resume` runs first without looking at the breakpoints, unless an interrupt comes first.
+                uint64_t Execute(uint64_t instructions, const uint64_t end, const uint32_t resume) {
+                    const uint64_t start = m_Cycles;
+                    bool resumed = false;
+                    m_Stop = {};
+                    m_Running = true;
+                    //The host may have written to memory
+                    m_IdleArmed = false;
+
+                    for(;;) {
+                        //Stopped before the events and the interrupts : the PC stays on what stopped
+                        if(m_Stop.m_Reason != StopReason::NONE) break;
+                        if(m_Cycles >= m_SliceEnd) Core::Poll();
+                        if(!instructions || m_Cycles >= end || m_Halted) break;
+
+                        if(!resumed && m_PC == resume) {
+                            m_Cycles += Core::Dispatch();
+                            instructions--;
+                        }
+                        resumed = true;
+
+                        //Up to the next deadline, the end of the budget or a trap
+                        m_SliceEnd = min(m_SliceEnd, end);
+                        uint64_t cycles = m_Cycles;
+                        if(m_Breakpoints.empty()) {
+                            while(instructions && cycles < m_SliceEnd) {
+                                if(m_ClockWatched) m_Cycles = cycles;
+                                cycles += Core::Dispatch();
+                                instructions--;
+                            }
+                        }
+                        else {
+                            //The trap bits are only looked up when the PC lands on another page
+                            uint32_t page = NO_RESUME;
+                            bool trapped = false;
+                            while(instructions && cycles < m_SliceEnd) {
+                                if((m_PC >> 8) != page) [[unlikely]] {
+                                    page = m_PC >> 8;
+                                    trapped = m_Traps[page] & TRAP_EXECUTE;
+                                }
+                                if(trapped) [[unlikely]] {
+                                    m_Cycles = cycles;
+                                    if(HitBreakpoint()) break;
+                                }
+                                if(m_ClockWatched) m_Cycles = cycles;
+                                cycles += Core::Dispatch();
+                                instructions--;
+                            }
+                        }
+                        m_Cycles = cycles;
+
+                        //Busy-waits only read pages without watchpoints, and start every iteration with the same registers :
+                        //a breakpoint in one holds or not on every iteration alike
+                        if(m_IdleSkip && m_Stop.m_Reason == StopReason::NONE) instructions -= Core::SkipIdle(min(Core::GetNextDeadline(), end), instructions);
+                    }
+                    m_Running = false;
+                    return m_Cycles - start;
+                }
+
+            public :
+
+                explicit DebugCPU(Bus& bus) : Core(bus) {}
+
+                //Maps the trapped pages back
+                ~DebugCPU() { ClearTraps(); }
+
+                //The TrapPages keep a pointer back to the core
+                DebugCPU(const DebugCPU&) = delete;
+                DebugCPU& operator=(const DebugCPU&) = delete;
+
+                //Returns the id RemoveBreakpoint() takes
+                uint32_t AddBreakpoint(const Word addr, Condition condition = {}) {
+                    m_Breakpoints.push_back({ m_NextId, addr, std::move(condition) });
+                    UpdateTraps();
+                    return m_NextId++;
+                }
+
+                //Watches [first, last] for reads and / or writes (TRAP_READ, TRAP_WRITE).
+                //Returns the id RemoveWatchpoint() takes. Throws invalid_argument on an empty range or access.
+                uint32_t AddWatchpoint(const Word first, const Word last, const Byte access, Condition condition = {}) {
+                    if(last < first) throw invalid_argument("Empty watchpoint range");
+                    if(!(access & (TRAP_READ | TRAP_WRITE)) || (access & ~(TRAP_READ | TRAP_WRITE))) throw invalid_argument("Watchpoint access must be TRAP_READ and / or TRAP_WRITE");
+                    m_Watchpoints.push_back({ m_NextId, first, last, access, std::move(condition) });
+                    UpdateTraps();
+                    return m_NextId++;
+                }
+
+                void RemoveBreakpoint(const uint32_t id) {
+                    erase_if(m_Breakpoints, [id](const Breakpoint& breakpoint) { return breakpoint.m_Id == id; });
+                    UpdateTraps();
+                }
+
+                void RemoveWatchpoint(const uint32_t id) {
+                    erase_if(m_Watchpoints, [id](const Watchpoint& watchpoint) { return watchpoint.m_Id == id; });
+                    UpdateTraps();
+                }
+
+                void ClearTraps() {
+                    m_Breakpoints.clear();
+                    m_Watchpoints.clear();
+                    UpdateTraps();
+                }
+
+                //What stopped the last Run / RunFor / Step, StopReason::NONE when it ran to its end
+                inline const Stop& GetStop() const { return m_Stop; }
+
+                inline Byte GetTraps(const Byte page) const { return m_Traps[page]; }
+
+                //Runs at most `instructions` instructions, stops early on a trap or if the CPU jams.
+                //Returns the number of cycles spent.
+                inline uint64_t Run(const uint64_t instructions) { return Execute(instructions, Core::NEVER, ResumeAddress()); }
+
+                //Runs for `budget` cycles (the last instruction may overshoot it), stops early on a trap
+                //or if the CPU jams. Returns the number of cycles spent.
+                inline uint64_t RunFor(const uint64_t budget) { return Execute(Core::NEVER, m_Cycles + budget, ResumeAddress()); }
+
+                //One instruction, after the pending interrupt if any : breakpoints on it don't stop it,
+                //watchpoints it hits are reported. Returns the number of cycles it took.
+                inline Byte Step() { return static_cast<Byte>(Execute(1, Core::NEVER, m_PC)); }
+};
+
+inline Byte TrapPage::ReadByte(const address& addr) const {
+    const Byte data = m_Page.m_Read ? m_Page.m_Read[addr.GetRecord()] : m_Page.m_Device ? m_Page.m_Device->ReadByte(addr) : 0;
+    m_Debugger->OnAccess(TRAP_READ, addr, data);
+    return data;
+}
+
+inline void TrapPage::WriteByte(const address& addr, const Byte data) {
+    m_Debugger->OnAccess(TRAP_WRITE, addr, data);
+    if(m_Page.m_Write) m_Page.m_Write[addr.GetRecord()] = data;
+    else if(m_Page.m_Device) m_Page.m_Device->WriteByte(addr, data);
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <types.h>
+
+using namespace std;
+
+//Coroutine of a device (see DeviceScheduler) : move-only, owns the coroutine frame.
+class DeviceTask {
+
+        public :
+
+            struct promise_type {
+                inline DeviceTask get_return_object() { return DeviceTask(coroutine_handle<promise_type>::from_promise(*this)); }
+
+                //DeviceScheduler::Spawn starts it
+                inline suspend_always initial_suspend() noexcept { return {}; }
+                inline suspend_always final_suspend() noexcept { return {}; }
+                inline void return_void() {}
+
+                //Thrown out of the access or the running loop that resumed the device, which then is done
+                inline void unhandled_exception() { throw; }
+            };
+
+        private :
+
+            coroutine_handle<promise_type> m_Handle;
+
+        public :
+
+            explicit DeviceTask(coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+
+            DeviceTask(DeviceTask&& other) noexcept : m_Handle(exchange(other.m_Handle, {})) {}
+
+            DeviceTask& operator=(DeviceTask&& other) noexcept {
+                if(this != &other) {
+                    if(m_Handle) m_Handle.destroy();
+                    m_Handle = exchange(other.m_Handle, {});
+                }
+                return *this;
+            }
+
+            ~DeviceTask() { if(m_Handle) m_Handle.destroy(); }
+
+            inline coroutine_handle<> GetHandle() const { return m_Handle; }
+            inline bool IsDone() const { return !m_Handle || m_Handle.done(); }
+};
+
+//Runs devices as coroutines, interleaved with the CPU by cycle timestamp, on the CPU's thread.
+//
+//A device runs as a DeviceTask. It co_awaits a number of cycles (Cycles, Until) or a bus event (BusSignal)
+//and does its work in between. Nothing ticks : a device sleeps until its next deadline, which the scheduler
+//keeps as one CPU event (CPUCore::Schedule) at the earliest wake. The running loops stop there, between two
+//instructions, to resume it. A device can also catch up when the CPU touches it : its bus handlers call
+//CatchUp(), which first resumes every device due up to the CPU's current cycle. Cycle-exact cores (see timing.h)
+//report the cycle of the access itself.
+//
+//  DeviceTask Timer::Run() {
+//      for(;;) {
+//          co_await m_Scheduler.Cycles(m_Period);
+//          m_Scheduler.AssertIRQ(TIMER_IRQ);
+//      }
+//  }
+//
+//  scheduler.Attach(core);
+//  scheduler.Spawn(timer->Run());
+//
+//A resumed device sees GetCycles() on its own wake cycle, even when it is resumed later : it runs in the past,
+//as the CPU would have seen it, and the devices run in timestamp order. Coroutine frames aren't part of the
+//save states (see Machine::SaveState) : spawn the devices again after a LoadState().
+class DeviceScheduler {
+
+        public :
+
+            static constexpr uint64_t NEVER = numeric_limits<uint64_t>::max();
+
+            //co_await Cycles(n) / Until(cycle) : the device carries on once the CPU reached the cycle
+            struct Delay {
+                DeviceScheduler& m_Scheduler;
+                uint64_t m_Cycle;
+
+                inline bool await_ready() const noexcept { return m_Cycle <= m_Scheduler.m_Now; }
+                inline void await_suspend(coroutine_handle<> handle) { m_Scheduler.Sleep(m_Cycle, handle); }
+                inline void await_resume() const noexcept {}
+            };
+
+        protected :
+
+            struct Wake {
+                uint64_t m_Cycle;
+                uint64_t m_Order;       //Devices due on the same cycle resume in the order they went to sleep
+                coroutine_handle<> m_Handle;
+
+                //Min-heap on the cycle
+                inline bool operator<(const Wake& other) const {
+                    return m_Cycle != other.m_Cycle ? m_Cycle > other.m_Cycle : m_Order > other.m_Order;
+                }
+            };
+
+            vector<Wake> m_Wakes;
+            uint64_t m_WakeOrder = 0;
+            vector<DeviceTask> m_Tasks;
+
+            //Cycle the devices are at : the wake cycle of the one running, the CPU's once they caught up
+            uint64_t m_Now = 0;
+            bool m_CatchingUp = false;
+
+            //The CPU's clock, event queue and IRQ lines (see Attach)
+            function<uint64_t()> m_Clock;
+            function<void(const uint64_t)> m_Arm;
+            function<void(const uint32_t, const bool)> m_Irq;
+            uint64_t m_Armed = NEVER;       //Deadline of the last CPU event scheduled
+
+            void Sleep(const uint64_t cycle, coroutine_handle<> handle);
+
+            //Schedules a CPU event at the earliest wake, unless one comes first
+            void Arm();
+
+        public :
+
+            DeviceScheduler() = default;
+
+            //The coroutines and the CPU events hold on to it
+            DeviceScheduler(const DeviceScheduler&) = delete;
+            DeviceScheduler& operator=(const DeviceScheduler&) = delete;
+
+            //Runs the devices on `core`'s clock and interrupt lines. Call it again after a CPUCore::TakeOver.
+            template<typename Core>
+            void Attach(Core& core) {
+                core.WatchClock();
+                m_Clock = [&core]() { return core.GetCycles(); };
+                m_Arm = [this, &core](const uint64_t deadline) { core.Schedule(deadline, [this]() { Fire(); }); };
+                m_Irq = [&core](const uint32_t source, const bool asserted) {
+                    if(asserted) core.AssertIRQ(source);
+                    else core.ReleaseIRQ(source);
+                };
+                m_Armed = NEVER;
+                CatchUp();
+            }
+
+            //Takes the device coroutine over, and runs it up to its first co_await
+            void Spawn(DeviceTask task);
+
+            inline Delay Cycles(const uint64_t cycles) { return { *this, m_Now + cycles }; }
+            inline Delay Until(const uint64_t cycle) { return { *this, cycle }; }
+
+            //Resumes the devices due up to the CPU's current cycle, in timestamp order. From a device's bus
+            //handlers, before they answer. A device resumed meanwhile runs within the ongoing catch up.
+            void CatchUp();
+
+            //Resumes a device waiting for a bus event on the current cycle, once the others caught up (see BusSignal)
+            void Resume(coroutine_handle<> handle);
+
+            //The CPU event : the earliest device is due
+            void Fire();
+
+            inline uint64_t GetCycles() const { return m_Now; }
+            inline uint64_t GetNextWake() const { return m_Wakes.empty() ? NEVER : m_Wakes.front().m_Cycle; }
+
+            inline void AssertIRQ(const uint32_t source = 1) { if(m_Irq) m_Irq(source, true); }
+            inline void ReleaseIRQ(const uint32_t source = 1) { if(m_Irq) m_Irq(source, false); }
+};
+
+//Bus event a device coroutine waits for : `co_await signal` suspends it until one of the device's bus handlers calls
+//Notify(value), on a write to a register, a read emptying a buffer... One waiter at a time. Without one, Notify
+//does nothing : what the device must remember goes into its registers.
+template<typename T = Byte>
+class BusSignal {
+
+        private :
+
+            DeviceScheduler& m_Scheduler;
+            coroutine_handle<> m_Waiter;
+            T m_Value {};
+
+        public :
+
+            explicit BusSignal(DeviceScheduler& scheduler) : m_Scheduler(scheduler) {}
+
+            inline bool await_ready() const noexcept { return false; }
+            inline void await_suspend(coroutine_handle<> handle) noexcept { m_Waiter = handle; }
+            inline T await_resume() const { return m_Value; }
+
+            inline bool IsAwaited() const { return static_cast<bool>(m_Waiter); }
+
+            //Runs the waiting device up to its next co_await, inside the bus access
+            inline void Notify(T value = {}) {
+                if(!m_Waiter) return;
+                m_Value = std::move(value);
+                m_Scheduler.Resume(exchange(m_Waiter, {}));
+            }
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <string_view>
 #include <types.h>
 
 //Add 1 cycle if page boundary is crossed
@@ -48,6 +50,7 @@ enum class Instructions : Byte {
     SED,    //Set decimal mode (D = 1)
     CLI,    //Clear Interrupt Disable Bit (I = 0)
     SEI,    //Set Interrupt Disable (I = 1)
+    CLV,    //Clear Overflow Flag (V = 0)
 
     //Memory and indexes manipulation :
     INC,    //Increment Memory by one
@@ -76,6 +79,7 @@ enum class Instructions : Byte {
     TAY,    //Transfer Accumulator to Index Y
     TSX,    //Transfer Stack Pointer to Index X
     TXA,    //Transfer Index X to Accumulator
+    TXS,    //Transfer Index X to Stack Register
     TYA,    //Transfer Index Y to Accumulator
 
     PHA,    //Push Accumulator on Stack
@@ -86,6 +90,20 @@ enum class Instructions : Byte {
     //Substraction :
     SBC,    //Substract Memory from Accumulator with Borrow
 
-  
+    //Illegal :
+    ILL     //Undocumented opcode (jams the CPU)
 
-};
\ No newline at end of file
+};
+
+constexpr size_t INSTRUCTION_COUNT = static_cast<size_t>(Instructions::ILL) + 1;
+
+//Assembly mnemonics, in declaration order
+constexpr array<string_view, INSTRUCTION_COUNT> INSTRUCTION_NAMES = {
+    "BRK", "NOP", "RTI", "RTS", "ADC", "AND", "EOR", "ORA", "BIT", "CMP", "CPX", "CPY",
+    "ASL", "LSR", "ROL", "ROR", "BCC", "BCS", "BEQ", "BMI", "BPL", "BNE", "BVC", "BVS",
+    "CLC", "SEC", "CLD", "SED", "CLI", "SEI", "CLV", "INC", "INX", "INY", "DEC", "DEX", "DEY",
+    "JMP", "JSR", "LDA", "LDX", "LDY", "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA",
+    "PHA", "PHP", "PLA", "PLP", "SBC", "ILL"
+};
+
+static_assert(INSTRUCTION_NAMES.back() == "ILL", "INSTRUCTION_NAMES out of sync with Instructions");
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 #include <types.h>
 
 using namespace std;
@@ -18,7 +19,28 @@ class IODevice {
 
             virtual void WriteWord(const address& addr, const Word data) = 0;
 
-            virtual void WriteBytes(const address& addr, const vector<Byte>& bytes) = 0;
+            //Bulk accesses, byte by byte unless the device has a faster path
+            virtual void ReadBytes(const address& addr, span<Byte> bytes) const {
+                Word current = addr.GetValue();
+                for(Byte& byte : bytes) byte = ReadByte(current++);
+            }
+
+            virtual void WriteBytes(const address& addr, span<const Byte> bytes) {
+                Word current = addr.GetValue();
+                for(const Byte byte : bytes) WriteByte(current++, byte);
+            }
+
+            //Reading addr has no side effect, and its value only changes through writes or through the CPU's
+            //scheduled events and interrupts : a loop polling it can be fast-forwarded to the next deadline
+            //(see CPUCore::WatchIdleLoop). Registers backed by a free-running clock or another thread aren't.
+            virtual bool IsPollable(const address& addr) const { return false; }
+
+            //Save state hooks (see Machine::SaveState) : the device's own state, registers, latches, internal
+            //memory, in any layout (StateWriter / StateReader help). LoadState gets back exactly what
+            //SaveState appended, and throws runtime_error when it can't make sense of it.
+            //Stateless devices, and those whose memory is mapped as RAM, keep the defaults.
+            virtual void SaveState(vector<Byte>& out) const {}
+            virtual void LoadState(span<const Byte> in) {}
 
             virtual void Write(const address& addr, const Byte data) { WriteByte( addr, data ); }
             virtual void Write(const address& addr, const Word data) { WriteWord( addr, data ); }
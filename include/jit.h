@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <types.h>
+#include <bus.h>
+#include <block_cache.h>
+
+using namespace std;
+
+    //Executable region the translated blocks are written to (mmap'ed, never writable and executable at once)
+    class ExecutableMemory {
+
+        private :
+
+            Byte* m_Base = nullptr;
+            size_t m_Size = 0;
+            size_t m_Used = 0;
+
+        public :
+
+            explicit ExecutableMemory(const size_t size = 16 * 1024 * 1024);
+            ~ExecutableMemory();
+
+            ExecutableMemory(const ExecutableMemory&) = delete;
+            ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+            //Copies the code in, returns its entry point or nullptr when the region is full
+            void* Commit(const vector<Byte>& code);
+
+            //Forgets every committed block
+            void Reset() { m_Used = 0; }
+
+            inline bool IsAvailable() const { return m_Base != nullptr; }
+    };
+
+    //Entry point of a translated block, takes the registers (read and written back in place).
+    //Returns the cycles spent in the low 32 bits and the instructions executed in the high 32 bits.
+    using NativeBlock = uint64_t (*)( Registers* registers );
+
+    //Where the translated code flags the writes to cached code (see WriteTrackingBus)
+    struct JitTracking {
+        const bool* m_CodePages;
+        bool* m_DirtyPages;
+        bool* m_CodeWritten;
+    };
+
+    //Decoded instruction, as the translator sees it (see CPUCore::MicroOp)
+    struct JitInstruction {
+        Byte m_Code;
+        Word m_Operand;
+        Word m_Next;
+    };
+
+    //Translates the longest supported prefix of a decoded block into x86-64 code.
+    //Memory operands must be static or indexed addresses on RAM/ROM pages of the bus, memory mapped I/O
+    //and indirect accesses stop the translation. `translated` receives the number of instructions covered.
+    //Returns the code or an empty vector when not even the first instruction is supported (or on other hosts).
+    vector<Byte> TranslateBlock( const vector<JitInstruction>& ops, const Bus& bus, const JitTracking& tracking, uint32_t& translated );
+
+    enum class ExecutionMode : Byte {
+        INTERPRETER,    //Pre-decoded blocks (CachedCPU)
+        JIT             //Hot blocks are translated to native code
+    };
+
+    //6502 core translating hot basic blocks into x86-64 code.
+    //
+    //Blocks come from the CachedCPU block cache : once a block has been visited HOT_THRESHOLD times,
+    //its longest supported prefix is translated and later visits call the native code instead.
+    //The native code works on the very same Registers as the interpreter, and falls back to it for
+    //everything it doesn't handle : code or operands on memory mapped I/O pages, indirect addressing,
+    //BRK / RTI, code that gets modified (the translated block is dropped with the cached one), and busy-waits,
+    //which are skipped rather than run (see CPUCore::WatchIdleLoop).
+    //
+    //The mode can be switched at any time between two Run() calls.
+    //Remapping bus pages requires an Invalidate(), as the native code embeds the page pointers.
+    class JitCPU : public CachedCPU<Bus> {
+
+            public :
+
+                static constexpr uint32_t HOT_THRESHOLD = 16;
+
+            protected :
+
+                ExecutionMode m_Mode = ExecutionMode::JIT;
+                ExecutableMemory m_Code;
+
+                bool Compile(Block& block);
+
+            public :
+
+                explicit JitCPU(Bus& bus, const ExecutionMode mode = ExecutionMode::JIT) : CachedCPU<Bus>(bus), m_Mode(mode) {}
+
+                inline void SetExecutionMode(const ExecutionMode mode) { m_Mode = mode; }
+                inline ExecutionMode GetExecutionMode() const { return m_Mode; }
+
+                //Runs at most `instructions` instructions, stops early if the CPU jams.
+                //Returns the number of cycles spent.
+                uint64_t Run(uint64_t instructions);
+    };
@@ -0,0 +1,178 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+#include <memory.h>
+#include <bus.h>
+#include <cpu_core.h>
+#include <save_state.h>
+
+using namespace std;
+
+//A 6502 and the device graph it runs on, as one unit of work (see MachinePool).
+//
+//Ownership : the machine holds the only reference to its bus it needs, every other device of the
+//graph is kept alive by the bus (Bus::MapDevice) or by Attach(). The core itself reads and writes
+//through a raw pointer, so running never touches a shared_ptr refcount.
+//
+//Threading : a machine and its device graph belong to one thread at a time. MachinePool moves
+//machines between its workers, never runs one on two threads at once, and publishes the state
+//through its queues. Devices shared between machines must be read-only, or synchronized by the device.
+//
+//Timing : a machine with a CycleExact core can take over a fast one's state through SaveState / LoadState,
+//and back, for the stretches a device needs every access on its cycle (see timing.h).
+template<typename BusPolicy = Memory, typename TracePolicy = NoTrace, typename TimingPolicy = FastTiming>
+class Machine : public CPUCore<BusPolicy, TracePolicy, TimingPolicy> {
+
+            public :
+
+                using Core = CPUCore<BusPolicy, TracePolicy, TimingPolicy>;
+
+                //Everything Restore() needs to rewind a Memory backed machine
+                struct State {
+                    Registers m_Registers;
+                    bool m_Halted;
+                    uint64_t m_Cycles;
+                    uint32_t m_IrqLines;
+                    bool m_NmiPending;
+                    bool m_ResetPending;
+                    Memory::snapshot_ptr m_Memory;
+                };
+
+            protected :
+
+                using Core::m_Halted;
+                using Core::m_Cycles;
+                using Core::m_IrqLines;
+                using Core::m_NmiPending;
+                using Core::m_ResetPending;
+                using Core::m_Events;
+                using Core::m_IdleLoop;
+                using Core::m_IdleArmed;
+                using Core::m_IdleSkip;
+
+                shared_ptr<BusPolicy> m_Device;
+
+                //Devices of the graph that the bus doesn't keep alive
+                vector<IODevice::io_ptr> m_Attached;
+
+                uint64_t m_CycleLimit = numeric_limits<uint64_t>::max();
+
+            public :
+
+                static unique_ptr<Machine> Make(shared_ptr<BusPolicy> bus = make_shared<BusPolicy>()) {
+                    return make_unique<Machine>(std::move(bus));
+                }
+
+                explicit Machine(shared_ptr<BusPolicy> bus) : Core(*bus), m_Device(std::move(bus)) {}
+
+                inline BusPolicy& GetBus() { return *m_Device; }
+                inline const shared_ptr<BusPolicy>& GetDevice() const { return m_Device; }
+
+                inline void Attach(IODevice::io_ptr device) { m_Attached.push_back(std::move(device)); }
+
+                //The machine is done once it ran for `cycles` cycles (or jammed)
+                inline void SetCycleLimit(const uint64_t cycles) { m_CycleLimit = cycles; }
+                inline uint64_t GetCycleLimit() const { return m_CycleLimit; }
+
+                //Only the pages written since the last Snapshot() / Restore() are copied back, see Memory::Snapshot
+                State Snapshot() requires is_base_of_v<Memory, BusPolicy> {
+                    return { Core::GetRegisters(), m_Halted, m_Cycles, m_IrqLines, m_NmiPending, m_ResetPending, m_Device->Snapshot() };
+                }
+
+                //Rewinds the core and the memory, interrupt lines included : nothing the discarded run raised or
+                //scheduled carries over. The scheduled events are dropped, as for LoadState() they are the host's to schedule again.
+                void Restore(const State& state) requires is_base_of_v<Memory, BusPolicy> {
+                    m_Device->Restore(state.m_Memory);
+                    Core::SetRegisters(state.m_Registers);
+                    m_Halted = state.m_Halted;
+                    m_Cycles = state.m_Cycles;
+                    m_IrqLines = state.m_IrqLines;
+                    m_NmiPending = state.m_NmiPending;
+                    m_ResetPending = state.m_ResetPending;
+                    m_Events.clear();
+                    m_IdleLoop = {};
+                    m_IdleArmed = false;
+                    m_IdleSkip = false;
+                    Core::Attention();
+                }
+
+                //The whole machine, for a SaveStateWriter : registers, pending interrupts, RAM (a Memory, or the RAM
+                //pages of a Bus in page order) and the IODevice::SaveState of the bus and of the attached devices.
+                //Scheduled events are the host's : they aren't saved, schedule them again after LoadState().
+                MachineState SaveState() const {
+                    MachineState state;
+                    state.m_Registers = Core::GetRegisters();
+                    state.m_Halted = m_Halted;
+                    state.m_Cycles = m_Cycles;
+                    state.m_IrqLines = m_IrqLines;
+                    state.m_NmiPending = m_NmiPending;
+                    state.m_ResetPending = m_ResetPending;
+
+                    if constexpr (is_base_of_v<Memory, BusPolicy>) {
+                        state.m_Memory.assign(m_Device->GetData(), m_Device->GetData() + m_Device->GetSize());
+                    }
+                    else if constexpr (is_same_v<Bus, BusPolicy>) {
+                        for(size_t page = 0; page < 256; page++) {
+                            const Byte* data = m_Device->GetPage(page).m_Write;
+                            if(data) state.m_Memory.insert(state.m_Memory.end(), data, data + Memory::PAGE_SIZE);
+                        }
+                    }
+
+                    state.m_Devices.resize(1 + m_Attached.size());
+                    m_Device->SaveState(state.m_Devices[0]);
+                    for(size_t i = 0; i < m_Attached.size(); i++) m_Attached[i]->SaveState(state.m_Devices[i + 1]);
+                    return state;
+                }
+
+                //Puts the machine back in a state SaveState() took from a machine of the same layout.
+                //Throws invalid_argument when the RAM size or the number of devices differ.
+                void LoadState(const MachineState& state) {
+                    if(state.m_Devices.size() != 1 + m_Attached.size()) throw invalid_argument("Save state of another device graph");
+
+                    if constexpr (is_base_of_v<Memory, BusPolicy>) {
+                        if(state.m_Memory.size() != m_Device->GetSize()) throw invalid_argument("Save state of another memory size");
+                        copy(state.m_Memory.begin(), state.m_Memory.end(), m_Device->GetData());
+                        m_Device->MarkDirty(0, (m_Device->GetSize() + Memory::PAGE_SIZE - 1) / Memory::PAGE_SIZE);
+                    }
+                    else if constexpr (is_same_v<Bus, BusPolicy>) {
+                        size_t pages = 0;
+                        for(size_t page = 0; page < 256; page++) pages += m_Device->GetPage(page).m_Write != nullptr;
+                        if(state.m_Memory.size() != pages * Memory::PAGE_SIZE) throw invalid_argument("Save state of another RAM mapping");
+
+                        auto data = state.m_Memory.begin();
+                        for(size_t page = 0; page < 256; page++) {
+                            Byte* ram = m_Device->GetPage(page).m_Write;
+                            if(!ram) continue;
+                            copy_n(data, Memory::PAGE_SIZE, ram);
+                            data += Memory::PAGE_SIZE;
+                        }
+                    }
+                    else if(!state.m_Memory.empty()) throw invalid_argument("Save state of another memory size");
+
+                    m_Device->LoadState(state.m_Devices[0]);
+                    for(size_t i = 0; i < m_Attached.size(); i++) m_Attached[i]->LoadState(state.m_Devices[i + 1]);
+
+                    Core::SetRegisters(state.m_Registers);
+                    m_Halted = state.m_Halted;
+                    m_Cycles = state.m_Cycles;
+                    m_IrqLines = state.m_IrqLines;
+                    m_NmiPending = state.m_NmiPending;
+                    m_ResetPending = state.m_ResetPending;
+                    Core::Attention();
+                }
+
+                inline bool IsDone() const { return m_Halted || m_Cycles >= m_CycleLimit; }
+
+                //Runs for `quantum` cycles, the last instruction may overshoot it.
+                //Stops early when the machine is done, returns the number of cycles spent.
+                uint64_t RunQuantum(const uint64_t quantum) {
+                    return Core::RunFor(min(quantum, m_CycleLimit - min(m_Cycles, m_CycleLimit)));
+                }
+};
@@ -0,0 +1,230 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <machine.h>
+
+using namespace std;
+
+//Runs many Machines on a fixed set of worker threads.
+//
+//Every worker owns a deque of machines : it takes the machine at the front, runs it for one quantum
+//of cycles, and puts it back at the end unless it is done (round robin). A worker whose deque runs dry
+//steals half of another worker's deque, so the load rebalances as machines halt or reach their cycle
+//limit. Submit() hands the machine over to the pool, Await() / Collect() hand it back once done.
+//A machine whose run throws (a device error, see DeviceScheduler or ThreadedDevice) is done too : it is
+//dropped, and Await() / Collect() throw its exception instead, the other machines carry on.
+template<typename BusPolicy = Memory>
+class MachinePool {
+
+        public :
+
+            using machine_ptr = unique_ptr<Machine<BusPolicy>>;
+            using Ticket = size_t;
+
+            static constexpr uint64_t DEFAULT_QUANTUM = 100000;
+
+        protected :
+
+            struct Job {
+                Ticket m_Ticket;
+                machine_ptr m_Machine;
+            };
+
+            struct Worker {
+                mutex m_Lock;
+                deque<Job> m_Jobs;
+            };
+
+            //Submitted machine, until it is handed back
+            struct Slot {
+                machine_ptr m_Machine;
+                exception_ptr m_Error;      //What its run threw, the machine is dropped
+                bool m_Done = false;
+                bool m_Collected = false;
+            };
+
+            const uint64_t m_Quantum;
+
+            vector<unique_ptr<Worker>> m_Workers;
+            vector<thread> m_Threads;
+
+            //Machines waiting in the deques (not the ones being run)
+            atomic<size_t> m_Queued { 0 };
+            atomic<size_t> m_Sleeping { 0 };
+            atomic<size_t> m_NextWorker { 0 };
+
+            //Guards the slots, workers sleep and clients wait on it
+            mutex m_Lock;
+            condition_variable m_Work;
+            condition_variable m_Done;
+            vector<Slot> m_Slots;
+            //Read by the workers before each quantum, outside of the lock
+            atomic<bool> m_Stopping { false };
+
+            void Push(const size_t worker, Job job) {
+                {
+                    lock_guard<mutex> lock(m_Workers[worker]->m_Lock);
+                    m_Workers[worker]->m_Jobs.push_back(std::move(job));
+                }
+                m_Queued++;
+                //Taking the lock orders the notification after a sleeper's last look at m_Queued
+                if(m_Sleeping.load()) {
+                    lock_guard<mutex> lock(m_Lock);
+                    m_Work.notify_one();
+                }
+            }
+
+            bool Pop(const size_t worker, Job& job) {
+                lock_guard<mutex> lock(m_Workers[worker]->m_Lock);
+                deque<Job>& jobs = m_Workers[worker]->m_Jobs;
+                if(jobs.empty()) return false;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                m_Queued--;
+                return true;
+            }
+
+            //Moves half of the first non empty deque found into the thief's, and takes one of them
+            bool Steal(const size_t thief, Job& job) {
+                const size_t count = m_Workers.size();
+                for(size_t i = 1; i < count; i++) {
+                    Worker& victim = *m_Workers[(thief + i) % count];
+                    Worker& own = *m_Workers[thief];
+                    scoped_lock lock(victim.m_Lock, own.m_Lock);
+                    if(victim.m_Jobs.empty()) continue;
+
+                    const size_t stolen = (victim.m_Jobs.size() + 1) / 2;
+                    for(size_t j = 0; j < stolen; j++) {
+                        own.m_Jobs.push_back(std::move(victim.m_Jobs.back()));
+                        victim.m_Jobs.pop_back();
+                    }
+                    job = std::move(own.m_Jobs.front());
+                    own.m_Jobs.pop_front();
+                    m_Queued--;
+                    return true;
+                }
+                return false;
+            }
+
+            void Finish(Job job, exception_ptr error = nullptr) {
+                lock_guard<mutex> lock(m_Lock);
+                Slot& slot = m_Slots[job.m_Ticket];
+                if(error) slot.m_Error = error;
+                else slot.m_Machine = std::move(job.m_Machine);
+                slot.m_Done = true;
+                m_Done.notify_all();
+            }
+
+            void WorkerLoop(const size_t worker) {
+                for(;;) {
+                    Job job;
+                    if(Pop(worker, job) || Steal(worker, job)) {
+                        //The machine is dropped with the job
+                        if(m_Stopping.load()) return;
+                        try {
+                            job.m_Machine->RunQuantum(m_Quantum);
+                        }
+                        catch(...) {
+                            Finish(std::move(job), current_exception());
+                            continue;
+                        }
+                        if(job.m_Machine->IsDone()) Finish(std::move(job));
+                        else Push(worker, std::move(job));
+                        continue;
+                    }
+
+                    unique_lock<mutex> lock(m_Lock);
+                    m_Sleeping++;
+                    m_Work.wait(lock, [this]() { return m_Stopping.load() || m_Queued.load() > 0; });
+                    m_Sleeping--;
+                    if(m_Stopping) return;
+                }
+            }
+
+        public :
+
+            explicit MachinePool(const size_t threads = thread::hardware_concurrency(), const uint64_t quantum = DEFAULT_QUANTUM)
+                : m_Quantum(max<uint64_t>(quantum, 1)) {
+                const size_t count = max<size_t>(threads, 1);
+                for(size_t i = 0; i < count; i++) m_Workers.push_back(make_unique<Worker>());
+                for(size_t i = 0; i < count; i++) m_Threads.emplace_back(&MachinePool::WorkerLoop, this, i);
+            }
+
+            //No copying
+            MachinePool(const MachinePool&) = delete;
+            MachinePool& operator=(const MachinePool&) = delete;
+
+            //Stops the workers, the machines still running are dropped
+            ~MachinePool() {
+                {
+                    lock_guard<mutex> lock(m_Lock);
+                    m_Stopping = true;
+                }
+                m_Work.notify_all();
+                for(thread& worker : m_Threads) worker.join();
+            }
+
+            inline size_t GetThreadCount() const { return m_Threads.size(); }
+            inline uint64_t GetQuantum() const { return m_Quantum; }
+
+            //The pool owns the machine until it is handed back by Await() or Collect()
+            Ticket Submit(machine_ptr machine) {
+                if(!machine) throw invalid_argument("Submitting no machine");
+                Ticket ticket;
+                {
+                    lock_guard<mutex> lock(m_Lock);
+                    ticket = m_Slots.size();
+                    m_Slots.emplace_back();
+                }
+                Push(m_NextWorker++ % m_Workers.size(), { ticket, std::move(machine) });
+                return ticket;
+            }
+
+            inline bool IsDone(const Ticket ticket) {
+                lock_guard<mutex> lock(m_Lock);
+                return ticket < m_Slots.size() && m_Slots[ticket].m_Done;
+            }
+
+            //Blocks until the machine is done, and hands it back, or throws what its run threw
+            machine_ptr Await(const Ticket ticket) {
+                unique_lock<mutex> lock(m_Lock);
+                if(ticket >= m_Slots.size() || m_Slots[ticket].m_Collected) throw invalid_argument("Unknown or already collected ticket");
+                m_Done.wait(lock, [&]() { return m_Slots[ticket].m_Done; });
+                m_Slots[ticket].m_Collected = true;
+                if(m_Slots[ticket].m_Error) rethrow_exception(m_Slots[ticket].m_Error);
+                return std::move(m_Slots[ticket].m_Machine);
+            }
+
+            //Blocks until every submitted machine is done, and hands back the ones not awaited yet, in submission order.
+            //When some failed, throws what the first one threw instead, and leaves the others to the next Collect().
+            vector<machine_ptr> Collect() {
+                vector<machine_ptr> machines;
+                unique_lock<mutex> lock(m_Lock);
+                //Indexed : m_Slots may grow while waiting
+                const size_t count = m_Slots.size();
+                for(Ticket ticket = 0; ticket < count; ticket++)
+                    if(!m_Slots[ticket].m_Collected) m_Done.wait(lock, [&]() { return m_Slots[ticket].m_Done; });
+
+                for(Ticket ticket = 0; ticket < count; ticket++) {
+                    if(m_Slots[ticket].m_Collected || !m_Slots[ticket].m_Error) continue;
+                    m_Slots[ticket].m_Collected = true;
+                    rethrow_exception(m_Slots[ticket].m_Error);
+                }
+
+                for(Ticket ticket = 0; ticket < count; ticket++) {
+                    if(m_Slots[ticket].m_Collected) continue;
+                    m_Slots[ticket].m_Collected = true;
+                    machines.push_back(std::move(m_Slots[ticket].m_Machine));
+                }
+                return machines;
+            }
+};
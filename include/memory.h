@@ -18,21 +18,47 @@ using namespace std;
 
         using memory = vector<Byte>;
 
+        public :
+
+            using iterator = memory::iterator;
+            using const_iterator = memory::const_iterator;
+
+            //Immutable copy of the contents, shared by every memory restored from it
+            using snapshot_ptr = shared_ptr<const memory>;
+
+            //Dirty tracking granularity, the 6502 page
+            static constexpr size_t PAGE_SIZE = 256;
+
         private :
 
             const size_t m_Size;
             memory m_Data;
 
-        public :
+            //Pages written since the last Snapshot() / Restore() : a flag per page, and the list of the flagged ones
+            vector<Byte> m_Dirty;
+            vector<size_t> m_DirtyPages;
 
-            using iterator = memory::iterator;
-            using const_iterator = memory::const_iterator;
+            //Snapshot the dirty pages differ from
+            snapshot_ptr m_Base;
+
+            inline void Touch(const size_t i) {
+                const size_t page = i / PAGE_SIZE;
+                if(m_Dirty[page]) return;
+                m_Dirty[page] = 1;
+                m_DirtyPages.push_back(page);
+            }
+
+            void ClearDirty();
+
+        public :
 
             static io_ptr Make(const size_t size = MAX_MEMORY_KB);
 
+            explicit Memory(const size_t size = MAX_MEMORY_KB);
+
             //Moving
             Memory(Memory&&) = default;
-            Memory& operator=(const Memory&) = default;
+            Memory& operator=(Memory&&) = default;
 
             //No copying
             Memory(const Memory&) = delete;
@@ -40,12 +66,66 @@ using namespace std;
 
             virtual inline void Clear(const Byte value) {
                 std:fill(m_Data.begin(), m_Data.end(), value);
+                MarkDirty(0, m_Dirty.size());
             }
 
             inline const size_t GetSize() const { return m_Size; }
 
-            inline Byte* GetData() { return m_Data.data(); } //Current location of the vector pointer
+            //Current location of the vector pointer, writes through it aren't tracked (see MarkDirty)
+            inline Byte* GetData() { return m_Data.data(); }
+            inline const Byte* GetData() const { return m_Data.data(); }
+
+            Byte& operator[](size_t i) { Touch(i); return m_Data[i]; }
+
+        public : //Snapshots
+
+            //Copies the contents, or shares the last snapshot when nothing was written since.
+            //Starts tracking the pages written from there.
+            snapshot_ptr Snapshot();
+
+            //Copies back the pages written since the snapshot was taken or last restored,
+            //the whole memory when it comes from elsewhere.
+            void Restore(const snapshot_ptr& snapshot);
+
+            //For the writes that bypass the accessors (GetData(), Bus::MapMemory). CPUBatch reads through
+            //GetData() but writes through operator[], so its lanes are tracked.
+            void MarkDirty(const size_t page, const size_t count);
+
+            inline const vector<size_t>& GetDirtyPages() const { return m_DirtyPages; }
+
+            //IODevice Implementation
+            //final : a CPUCore<Memory> calls these directly and gets them inlined
+
+            //Addresses past the end of a smaller memory read as 0 and ignore writes
+            inline Byte ReadByte(const address& addr) const override final {
+                const size_t i = addr.GetValue();
+                return i < m_Size ? m_Data[i] : 0;
+            }
+
+            //Little-endian (LLHH)
+            inline Word ReadWord(const address& addr) const override final {
+                const Byte lo = ReadByte(addr);
+                const Byte hi = ReadByte(addr.GetValue() + 1);
+                return MAKE_WORD(hi, lo);
+            }
+
+            inline void WriteByte(const address& addr, const Byte data) override final {
+                const size_t i = addr.GetValue();
+                if(i < m_Size) {
+                    m_Data[i] = data;
+                    Touch(i);
+                }
+            }
+
+            inline void WriteWord(const address& addr, const Word data) override final {
+                WriteByte(addr, data & 0xFF);
+                WriteByte(addr.GetValue() + 1, data >> 8);
+            }
+
+            inline bool IsPollable(const address& addr) const override final { return true; }
 
-            Byte& operator[](size_t i) { return m_Data[i]; }
+            //Clamped to the end of the memory
+            void ReadBytes(const address& addr, span<Byte> bytes) const override final;
+            void WriteBytes(const address& addr, span<const Byte> bytes) override final;
 
     };
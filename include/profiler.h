@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <types.h>
+#include <opcodes.h>
+#include <trace.h>
+
+using namespace std;
+
+//Memory accesses of an opcode, besides fetching it
+struct MemoryAccess {
+    Byte m_Reads;           //At the effective address
+    Byte m_Writes;
+    Byte m_StackReads;      //Pulls
+    Byte m_StackWrites;     //Pushes
+};
+
+constexpr array<MemoryAccess, 256> MakeMemoryAccessTable() {
+    using enum Instructions;
+
+    array<MemoryAccess, 256> table {};
+    for(size_t code = 0; code < 256; code++) {
+        const Opcode& opcode = OPCODES[code];
+        const Instructions instruction = opcode.m_Instruction;
+        MemoryAccess& access = table[code];
+
+        access.m_Reads = opcode.m_AddrMode != AddressMode::IMM && ReadsOperand(instruction, opcode.m_AddrMode);
+        access.m_Writes = instruction == STA || instruction == STX || instruction == STY
+                       || (IsReadModifyWrite(instruction) && opcode.m_AddrMode != AddressMode::ACC);
+        access.m_StackReads = instruction == PLA || instruction == PLP ? 1 : instruction == RTS ? 2 : instruction == RTI ? 3 : 0;
+        access.m_StackWrites = instruction == PHA || instruction == PHP ? 1 : instruction == JSR ? 2 : instruction == BRK ? 3 : 0;
+    }
+    return table;
+}
+
+inline constexpr array<MemoryAccess, 256> MEMORY_ACCESSES = MakeMemoryAccessTable();
+
+//Execution profile of a core, as a trace policy : CPUCore<BusPolicy, Profiler> counts, CPUCore<BusPolicy>
+//doesn't pay anything (see NoTrace). The counters are read through GetTracer(), Dump() exports them as JSON.
+//
+//Counted on every instruction the interpreter runs :
+//  - executions, cycles and penalty cycles per opcode (per addressing mode and instruction when dumped)
+//  - executions and cycles per page of the PC : the hot spots
+//  - data reads and writes per page : the effective address of loads, stores and read-modify-writes, the stack
+//    for pushes and pulls. Opcode and operand fetches count as executions, not reads ; the pointer fetches
+//    of the indirect modes and the interrupt vector reads aren't counted.
+//  - page crossing penalties of the indexed modes, branches taken and crossing a page,
+//    zero-page indexing wrapping around (see address::AddZeroPage)
+class Profiler {
+
+        public :
+
+            static constexpr bool ENABLED = true;
+
+            struct OpcodeCounters {
+                uint64_t m_Count = 0;
+                uint64_t m_Cycles = 0;
+                uint64_t m_Penalties = 0;   //Cycles over the opcode's base count
+            };
+
+            struct PageCounters {
+                uint64_t m_Instructions = 0;
+                uint64_t m_Cycles = 0;
+                uint64_t m_Reads = 0;
+                uint64_t m_Writes = 0;
+            };
+
+        protected :
+
+            array<OpcodeCounters, 256> m_Opcodes {};
+            array<PageCounters, 256> m_Pages {};
+
+            uint64_t m_IndexedPageCrossings = 0;
+            uint64_t m_BranchesTaken = 0;
+            uint64_t m_BranchPageCrossings = 0;
+            uint64_t m_ZeroPageWraps = 0;
+
+        public :
+
+            inline void Record(const TraceRecord& record) {
+                const Opcode& opcode = OPCODES[record.m_Opcode];
+                const Byte penalty = record.m_Cycles - opcode.m_Cycles;
+
+                OpcodeCounters& counters = m_Opcodes[record.m_Opcode];
+                counters.m_Count++;
+                counters.m_Cycles += record.m_Cycles;
+                counters.m_Penalties += penalty;
+
+                PageCounters& code = m_Pages[record.m_PC >> 8];
+                code.m_Instructions++;
+                code.m_Cycles += record.m_Cycles;
+
+                const MemoryAccess access = MEMORY_ACCESSES[record.m_Opcode];
+                PageCounters& data = m_Pages[record.m_Addr >> 8];
+                data.m_Reads += access.m_Reads;
+                data.m_Writes += access.m_Writes;
+                m_Pages[0x01].m_Reads += access.m_StackReads;
+                m_Pages[0x01].m_Writes += access.m_StackWrites;
+
+                switch (opcode.m_AddrMode) {
+                    //1 cycle when taken, 2 when landing on another page
+                    case AddressMode::REL:
+                        m_BranchesTaken += penalty != 0;
+                        m_BranchPageCrossings += penalty == 2;
+                        break;
+                    //The base address is the effective one minus the index, modulo the zero-page
+                    case AddressMode::ZPX:
+                    case AddressMode::ZPY: {
+                        const Byte index = opcode.m_AddrMode == AddressMode::ZPX ? record.m_X : record.m_Y;
+                        m_ZeroPageWraps += static_cast<Byte>(record.m_Addr - index) + index > 0xFF;
+                        break;
+                    }
+                    default:
+                        m_IndexedPageCrossings += penalty;
+                        break;
+                }
+            }
+
+            inline const OpcodeCounters& GetOpcode(const Byte code) const { return m_Opcodes[code]; }
+            inline const PageCounters& GetPage(const Byte page) const { return m_Pages[page]; }
+
+            inline uint64_t GetIndexedPageCrossings() const { return m_IndexedPageCrossings; }
+            inline uint64_t GetBranchesTaken() const { return m_BranchesTaken; }
+            inline uint64_t GetBranchPageCrossings() const { return m_BranchPageCrossings; }
+            inline uint64_t GetZeroPageWraps() const { return m_ZeroPageWraps; }
+
+            uint64_t GetInstructionCount() const;
+            uint64_t GetCycleCount() const;
+
+            void Reset();
+
+            //Writes the counters as a JSON object. Opcodes and pages never seen are left out.
+            void Dump(ostream& json) const;
+};
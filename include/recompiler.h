@@ -0,0 +1,70 @@
+#pragma once
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <types.h>
+#include <opcodes.h>
+
+using namespace std;
+
+//Static 6502 to C++ recompiler (see emu6502-aot and AotCPU).
+//
+//Walks the control flow of a ROM image from its entry points, through the OPCODES table, and splits
+//the reachable code into basic blocks : a block starts at an entry point, a jump or branch target or
+//after a control flow instruction, and runs up to the next control flow instruction or block start.
+//Jumps through memory (JMP (ind), RTS, RTI, BRK) end the walk, their targets are resolved at runtime.
+class Recompiler {
+
+        public :
+
+            struct Instruction {
+                Word m_Address;
+                Byte m_Code;
+                Word m_Operand;     //Decoded as CPUCore::Decode does
+                Word m_Next;
+            };
+
+            struct Block {
+                Word m_Start;
+                vector<Instruction> m_Instructions;
+            };
+
+        private :
+
+            const vector<Byte> m_Image;
+            const Word m_Base;
+
+            set<Word> m_EntryPoints;
+            map<Word, Block> m_Blocks;
+
+            inline bool Contains(const size_t addr, const size_t size = 1) const {
+                return addr >= m_Base && addr + size <= m_Base + m_Image.size();
+            }
+
+            inline Byte At(const Word addr) const { return m_Image[addr - m_Base]; }
+
+            //Decodes the instruction at addr, false when it is undocumented or doesn't fit in the image
+            bool Decode(const Word addr, Instruction& instruction) const;
+
+        public :
+
+            //The image is mapped at base, and must fit below 0x10000
+            Recompiler(vector<Byte> image, const Word base);
+
+            void AddEntryPoint(const Word addr);
+
+            //NMI, RESET and IRQ/BRK vectors ($FFFA - $FFFF), when the image covers them
+            void AddVectors();
+
+            inline const set<Word>& GetEntryPoints() const { return m_EntryPoints; }
+
+            //Discovers the reachable code and builds the blocks
+            void Analyze();
+
+            inline const map<Word, Block>& GetBlocks() const { return m_Blocks; }
+
+            //Writes the C++ source of the AotProgram<bus> named `name`
+            void Emit(ostream& os, const string& name, const string& bus = "Bus") const;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+#include <utils.h>
+
+using namespace std;
+
+    //Read-only image, memory-mapped from its file (read into memory on hosts without mmap).
+    //
+    //Bus::MapRom maps its pages as ROM : the CPU reads straight from the file mapping, nothing is copied.
+    //As an IODevice, the address is the offset in the image, and writes are ignored.
+
+    class Rom : public IODevice {
+
+        private :
+
+            const Byte* m_Data = nullptr;
+            size_t m_Size = 0;
+
+            //File mapping, or the copy of the bytes when not mapped
+            void* m_Mapping = nullptr;
+            size_t m_MappingSize = 0;
+            vector<Byte> m_Copy;
+
+        public :
+
+            //Maps the whole file read-only
+            static shared_ptr<Rom> Open(const string& path);
+
+            //Keeps a copy of the bytes
+            static shared_ptr<Rom> Make(span<const Byte> bytes);
+
+            Rom() = default;
+            ~Rom();
+
+            //No copying
+            Rom(const Rom&) = delete;
+            Rom& operator=(const Rom&) = delete;
+
+            inline const Byte* GetData() const { return m_Data; }
+            inline const size_t GetSize() const { return m_Size; }
+            inline span<const Byte> GetBytes() const { return { m_Data, m_Size }; }
+
+            //IODevice Implementation
+
+            inline Byte ReadByte(const address& addr) const override final {
+                const size_t i = addr.GetValue();
+                return i < m_Size ? m_Data[i] : 0;
+            }
+
+            //Little-endian (LLHH)
+            inline Word ReadWord(const address& addr) const override final {
+                const Byte lo = ReadByte(addr);
+                const Byte hi = ReadByte(addr.GetValue() + 1);
+                return MAKE_WORD(hi, lo);
+            }
+
+            void ReadBytes(const address& addr, span<Byte> bytes) const override final;
+
+            inline bool IsPollable(const address& addr) const override final { return true; }
+
+            inline void WriteByte(const address& addr, const Byte data) override final {}
+            inline void WriteWord(const address& addr, const Word data) override final {}
+            inline void WriteBytes(const address& addr, span<const Byte> bytes) override final {}
+    };
+
+    class Bus;
+
+    //Where the parts of a program image go in the address space
+    struct Program {
+
+            //m_Size bytes of the image, from m_Offset, loaded at m_Base
+            struct Segment {
+                size_t m_Offset;
+                size_t m_Size;
+                Word m_Base;
+            };
+
+            shared_ptr<Rom> m_Rom;
+            vector<Segment> m_Segments;
+
+            //Raw binary, loaded at base
+            static Program Binary(const string& path, const Word base);
+
+            //.prg : the load address (little-endian) in the first two bytes, then the program
+            static Program Prg(const string& path);
+
+            //iNES : PRG-ROM at $8000, a single 16 KB bank is mirrored at $C000.
+            //Banked mappers get their first bank at $8000 and their last one at $C000, as most of them power up.
+            static Program Nes(const string& path);
+
+            //Maps the segments onto the bus as ROM, copy-free. The segments must start on a page boundary
+            //and cover whole pages, otherwise they are copied to the bus (which must have RAM there).
+            void Map(Bus& bus) const;
+
+            //Copies the segments into a device (one copy, straight from the file mapping)
+            void Load(IODevice& device) const;
+    };
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <vector>
+#include <types.h>
+#include <cpu_core.h>
+
+using namespace std;
+
+//Little-endian helpers for the devices' IODevice::SaveState / LoadState hooks
+class StateWriter {
+
+        private :
+
+            vector<Byte>& m_Out;
+
+        public :
+
+            explicit StateWriter(vector<Byte>& out) : m_Out(out) {}
+
+            inline void Write(const Byte value) { m_Out.push_back(value); }
+            inline void WriteWord(const Word value) { WriteInt(value, 2); }
+            inline void Write32(const uint32_t value) { WriteInt(value, 4); }
+            inline void Write64(const uint64_t value) { WriteInt(value, 8); }
+            inline void WriteBytes(span<const Byte> bytes) { m_Out.insert(m_Out.end(), bytes.begin(), bytes.end()); }
+
+            inline void WriteInt(uint64_t value, const size_t size) {
+                for(size_t i = 0; i < size; i++, value >>= 8) m_Out.push_back(value & 0xFF);
+            }
+};
+
+//Reads what a StateWriter wrote. Throws runtime_error past the end.
+class StateReader {
+
+        private :
+
+            span<const Byte> m_In;
+            size_t m_Position = 0;
+
+        public :
+
+            explicit StateReader(span<const Byte> in) : m_In(in) {}
+
+            inline Byte Read() { return static_cast<Byte>(ReadInt(1)); }
+            inline Word ReadWord() { return static_cast<Word>(ReadInt(2)); }
+            inline uint32_t Read32() { return static_cast<uint32_t>(ReadInt(4)); }
+            inline uint64_t Read64() { return ReadInt(8); }
+            void ReadBytes(span<Byte> bytes);
+
+            uint64_t ReadInt(const size_t size);
+
+            inline bool IsAtEnd() const { return m_Position == m_In.size(); }
+};
+
+//A whole machine, as a save state holds it (see Machine::SaveState)
+struct MachineState {
+    Registers m_Registers {};           //m_OpValue and the packed Status included
+    bool m_Halted = false;
+    uint64_t m_Cycles = 0;
+    uint32_t m_IrqLines = 0;
+    bool m_NmiPending = false;
+    bool m_ResetPending = false;
+    vector<Byte> m_Memory;              //RAM, page after page
+    vector<vector<Byte>> m_Devices;     //IODevice::SaveState of every device, in the machine's order
+};
+
+//Save state stream format :
+//
+//  SAVE_STATE_MAGIC then SAVE_STATE_VERSION, followed by frames, each holding a state :
+//  - the kind : FRAME_KEYFRAME, a whole state, or FRAME_DELTA, the changes since the previous frame's state
+//  - the payload size (32 bits), the payload, and the low 32 bits of its HashImage()
+//
+//  Payload, little-endian :
+//  - PC, SP, A, X, Y, P, m_OpValue, then halted / NMI / RESET pending as bits 0-2 of a byte,
+//    the IRQ lines (32 bits) and the cycle counter (64 bits)
+//  - the RAM size (32 bits), then the number of pages that follow (16 bits), each as its index (16 bits)
+//    and runs of (bytes unchanged, bytes stored) counts and the stored bytes, until the page is covered.
+//    A keyframe runs against a zeroed RAM and leaves the all-zero pages out, a delta against the previous
+//    state and only holds the pages that changed.
+//  - the number of devices (16 bits), the number of device states that follow (16 bits), each as the
+//    device's index (16 bits), its size (32 bits) and the bytes. Deltas only hold the ones that changed.
+//
+//  A delta needs the same RAM size and device count as the state before it, the writer emits a keyframe otherwise.
+constexpr char SAVE_STATE_MAGIC[7] = { '6', '5', '0', '2', 'S', 'A', 'V' };
+constexpr Byte SAVE_STATE_VERSION = 1;
+
+constexpr Byte FRAME_KEYFRAME = 'K';
+constexpr Byte FRAME_DELTA = 'D';
+
+//Appends states to a stream : an ofstream for checkpoint files, an ostringstream for memory.
+//A keyframe every `keyframeInterval` states, deltas against the previous state in between.
+class SaveStateWriter {
+
+        public :
+
+            static constexpr size_t DEFAULT_KEYFRAME_INTERVAL = 64;
+
+        private :
+
+            ostream& m_Out;
+            const size_t m_KeyframeInterval;
+
+            size_t m_Count = 0;                 //States written
+            size_t m_SinceKeyframe = 0;
+            MachineState m_Previous;
+            vector<Byte> m_Payload;
+
+            void WriteFrame(const Byte kind);
+
+        public :
+
+            //Writes the stream header, throws runtime_error if the stream fails
+            explicit SaveStateWriter(ostream& out, const size_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+            //No copying
+            SaveStateWriter(const SaveStateWriter&) = delete;
+            SaveStateWriter& operator=(const SaveStateWriter&) = delete;
+
+            //Appends the state as a keyframe or a delta, and flushes the stream : a crash loses the frame
+            //being written at most. Throws runtime_error if the stream fails.
+            void Write(const MachineState& state);
+
+            //The next state is written whole
+            inline void RequestKeyframe() { m_SinceKeyframe = m_KeyframeInterval; }
+
+            inline size_t GetCount() const { return m_Count; }
+};
+
+//Reads the states of a stream back, in order.
+class SaveStateReader {
+
+        private :
+
+            istream& m_In;
+            MachineState m_State;
+            size_t m_Count = 0;                 //States read
+            vector<Byte> m_Payload;
+
+        public :
+
+            //Throws runtime_error if the stream doesn't start with a save state header of a known version
+            explicit SaveStateReader(istream& in);
+
+            //Decodes the next frame onto the current state. False at the end of the stream, or at a frame cut
+            //short (the writer crashed while writing it). Throws runtime_error on a corrupted frame, or a delta
+            //with no state before it.
+            bool Next();
+
+            //Reads every remaining frame : the current state is the last one written.
+            //False if the stream holds no state at all.
+            bool ReadLast();
+
+            inline const MachineState& GetState() const { return m_State; }
+            inline size_t GetCount() const { return m_Count; }
+};
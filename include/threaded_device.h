@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+#include <types.h>
+#include <io_device.h>
+
+using namespace std;
+
+//A write the CPU posted to a ThreadedDevice
+struct BusEvent {
+
+    enum Kind : Byte {
+        WRITE_BYTE,
+        WRITE_WORD,
+        WRITE_BYTES,
+        STOP            //Ends the device thread, once the writes before it are done
+    };
+
+    //Bytes a WRITE_BYTES event holds, longer writes take several
+    static constexpr size_t MAX_BYTES = 20;
+
+    uint64_t m_Cycle;       //CPU cycle of the write (see ThreadedDevice::Attach)
+    Word m_Addr;
+    Kind m_Kind;
+    Byte m_Size;
+    array<Byte, MAX_BYTES> m_Data;
+};
+
+//Runs a heavyweight device (frame renderer, audio synthesis, storage...) on a thread of its own.
+//
+//Mapped on the bus in place of the device, it posts the writes to a wait-free ring, one producer (the CPU's
+//thread) and one consumer (the device's), and the CPU carries on at once. The device thread applies them in
+//order through the device's WriteByte / WriteWord / WriteBytes, where the device does its work. The CPU waits
+//for the device only :
+//  - on reads (ReadByte, ReadBytes...) : they need the device's reply, every write before them is applied first
+//  - once the oldest write not applied yet is more than the latency window behind (in CPU cycles)
+//  - when the ring is full
+//Once the ring is drained, the device thread sleeps and leaves the device alone : reads, SaveState and
+//LoadState then call it from the CPU's thread. A device that throws stops taking writes, and the exception
+//is thrown again on the CPU's thread, from the next access.
+class ThreadedDevice : public IODevice {
+
+        public :
+
+            static constexpr uint64_t DEFAULT_LATENCY = 10000;
+            static constexpr size_t DEFAULT_CAPACITY = 1 << 12;
+
+        private :
+
+            io_ptr m_Device;
+            vector<BusEvent> m_Events;
+            const size_t m_Mask;
+            const uint64_t m_Latency;
+
+            //Own cache lines : the producer and the consumer don't invalidate each other's on every write
+            alignas(64) mutable atomic<size_t> m_Head { 0 };    //Next event to apply, written by the device thread
+            mutable atomic<bool> m_ProducerWaiting { false };   //The CPU's thread waits for m_Head to move
+            alignas(64) atomic<size_t> m_Tail { 0 };            //Next slot to post to, written by the CPU's thread
+            atomic<bool> m_ConsumerAsleep { false };            //The device thread waits for m_Tail to move
+            size_t m_FreeUntil = 0;                             //Producer side : posts up to there can't overrun the consumer
+
+            //The device thread's exception, once m_Failed
+            exception_ptr m_Error;
+            atomic<bool> m_Failed { false };
+
+            function<uint64_t()> m_Clock;
+            thread m_Thread;
+
+            //CPU's thread : Submit timestamps the write and keeps the window, Post queues it
+            void Submit(BusEvent& event);
+            void Post(const BusEvent& event);
+            void WaitForHead(const size_t head) const;
+            void CheckError() const;
+
+            //Device thread
+            void DeviceLoop();
+            void Apply(const BusEvent& event);
+
+        public :
+
+            //The capacity is rounded up to a power of 2
+            static shared_ptr<ThreadedDevice> Make(io_ptr device, const uint64_t latency = DEFAULT_LATENCY, const size_t capacity = DEFAULT_CAPACITY) {
+                return make_shared<ThreadedDevice>(std::move(device), latency, capacity);
+            }
+
+            ThreadedDevice(io_ptr device, const uint64_t latency, const size_t capacity);
+
+            //Applies the writes posted, and stops the device thread
+            ~ThreadedDevice();
+
+            //No copying
+            ThreadedDevice(const ThreadedDevice&) = delete;
+            ThreadedDevice& operator=(const ThreadedDevice&) = delete;
+
+            //Timestamps the writes with `core`'s cycle count, for the latency window : the core keeps it current
+            //(see CPUCore::WatchClock). Unattached, only the ring's capacity bounds how far ahead the CPU runs.
+            //Call it again after a CPUCore::TakeOver.
+            template<typename Core>
+            void Attach(Core& core) {
+                Sync();
+                if constexpr (requires { core.WatchClock(); }) core.WatchClock();
+                m_Clock = [&core]() { return core.GetCycles(); };
+            }
+
+            inline const io_ptr& GetDevice() const { return m_Device; }
+            inline uint64_t GetLatency() const { return m_Latency; }
+
+            //Waits for every write posted so far to be applied
+            void Sync() const;
+
+            //IODevice Implementation
+
+            Byte ReadByte(const address& addr) const override;
+            Word ReadWord(const address& addr) const override;
+            void ReadBytes(const address& addr, span<Byte> bytes) const override;
+
+            void WriteByte(const address& addr, const Byte data) override;
+            void WriteWord(const address& addr, const Word data) override;
+            void WriteBytes(const address& addr, span<const Byte> bytes) override;
+
+            //Another thread's registers
+            bool IsPollable(const address& addr) const override { return false; }
+
+            void SaveState(vector<Byte>& out) const override;
+            void LoadState(span<const Byte> in) override;
+};
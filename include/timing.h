@@ -0,0 +1,24 @@
+#pragma once
+
+//Timing policies of CPUCore, its third template parameter.
+//
+//FastTiming runs whole instructions : the bus sees the accesses that carry data, and the cycles an instruction
+//took (the OPCODES table, plus the page crossing and branching penalties) are added once it ran.
+//
+//CycleExact performs every bus access of the NMOS 6502, one per cycle and in order, the dummy ones included :
+//the byte after a one-byte opcode, the stack read before a pull, the read of the unfixed address while an indexed
+//mode (ABX, ABY, INY) carries into the high byte, the old value written back by a read-modify-write, the opcode
+//fetches of a taken branch... GetCycles() called by the bus during an access is the cycle of that access, so a
+//device can time its registers against the CPU. The instructions are the same definitions (CPUCore::Execute),
+//and the cycle counts come out the same : only the accesses in between differ.
+//
+//Both keep the same state, the switch happens between two instructions : CPUCore::TakeOver moves a core over to
+//another one on the same bus, Machine::SaveState / LoadState across machines. The caching cores (CachedCPU, JitCPU,
+//AotCPU) and the debugger are fast only.
+struct FastTiming {
+    static constexpr bool CYCLE_EXACT = false;
+};
+
+struct CycleExact {
+    static constexpr bool CYCLE_EXACT = true;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <types.h>
+
+using namespace std;
+
+//One executed instruction : the registers as they were before it, what it cost and the address it worked on
+struct TraceRecord {
+    Word m_PC;
+    Word m_Addr;        //Effective address (branch or jump target, following byte for IMM / IMP / ACC)
+    Byte m_Opcode;
+    Byte m_Acc;
+    Byte m_X;
+    Byte m_Y;
+    Byte m_SP;
+    Byte m_Status;
+    Byte m_Cycles;      //Cycles the instruction took, penalties included
+};
+
+//Trace policies of CPUCore.
+//
+//The interpreter hands every instruction it runs to Record(). With ENABLED false the record isn't even
+//built : a core traced with NoTrace compiles to the same code as before tracing existed.
+//Interrupt entries and the blocks run natively by JitCPU / AotCPU are not traced.
+struct NoTrace {
+    static constexpr bool ENABLED = false;
+    inline void Record(const TraceRecord& record) {}
+};
+
+//Lock-free ring of records, for one producer (the CPU's thread) and one consumer.
+class TraceRing {
+
+        private :
+
+            vector<TraceRecord> m_Records;
+            const size_t m_Mask;
+
+            //Own cache lines : the producer and the consumer don't invalidate each other's on every record
+            alignas(64) atomic<size_t> m_Head { 0 };    //Next record to pop, written by the consumer
+            alignas(64) atomic<size_t> m_Tail { 0 };    //Next slot to push to, written by the producer
+            size_t m_FreeUntil = 0;                     //Producer side : pushes up to there can't overrun the consumer
+
+        public :
+
+            //The capacity is rounded up to a power of 2
+            explicit TraceRing(const size_t capacity);
+
+            //No copying
+            TraceRing(const TraceRing&) = delete;
+            TraceRing& operator=(const TraceRing&) = delete;
+
+            inline size_t GetCapacity() const { return m_Records.size(); }
+
+            //Producer : false when the ring is full
+            inline bool TryPush(const TraceRecord& record) {
+                const size_t tail = m_Tail.load(memory_order_relaxed);
+                if(tail == m_FreeUntil) {
+                    m_FreeUntil = m_Head.load(memory_order_acquire) + m_Records.size();
+                    if(tail == m_FreeUntil) return false;
+                }
+                m_Records[tail & m_Mask] = record;
+                m_Tail.store(tail + 1, memory_order_release);
+                return true;
+            }
+
+            //Producer : waits for room rather than losing the record, a trace has no gaps
+            inline void Push(const TraceRecord& record) {
+                while(!TryPush(record)) this_thread::yield();
+            }
+
+            //Consumer : moves up to `count` records out, returns how many
+            size_t Pop(TraceRecord* records, const size_t count);
+
+            inline bool IsEmpty() const { return m_Head.load(memory_order_acquire) == m_Tail.load(memory_order_acquire); }
+};
+
+//Trace policy feeding a TraceRing (see TraceWriter::GetTracer). Unbound, it drops the records.
+class RingTracer {
+
+        private :
+
+            TraceRing* m_Ring = nullptr;
+
+        public :
+
+            static constexpr bool ENABLED = true;
+
+            RingTracer() = default;
+            explicit RingTracer(TraceRing& ring) : m_Ring(&ring) {}
+
+            inline void Record(const TraceRecord& record) { if(m_Ring) m_Ring->Push(record); }
+};
+
+//Trace file format :
+//
+//  TRACE_MAGIC then TRACE_VERSION, followed by the records, each delta-encoded against the previous one
+//  (the one before the first is all zeros) :
+//  - a header byte :
+//      bits 0-1    PC : 0 follows the previous instruction, 1 is the previous one's m_Addr (taken branch,
+//                  JMP, JSR), 2 is stored (little-endian word)
+//      bits 2-6    A, X, Y, SP, P changed : the new value is stored
+//      bit 7       the cycles differ from the opcode's base count : they are stored
+//  - the opcode byte
+//  - the fields flagged in the header, in that order : PC, A, X, Y, SP, P, cycles
+//  - the effective address, only as much of it as the addressing mode doesn't give away : nothing for
+//    IMM / IMP / ACC (the byte after the opcode), the signed offset from the next instruction for REL,
+//    the low byte for the zero-page modes, the whole word otherwise.
+//  A typical record takes 3 or 4 bytes instead of 11.
+constexpr char TRACE_MAGIC[7] = { '6', '5', '0', '2', 'T', 'R', 'C' };
+constexpr Byte TRACE_VERSION = 1;
+
+//Streams the records of its ring to a trace file, from a background thread.
+//The CPU only ever copies a record into the ring : the encoding and the file writes happen on the writer thread.
+class TraceWriter {
+
+        public :
+
+            static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+        private :
+
+            TraceRing m_Ring;
+            ofstream m_File;
+            thread m_Thread;
+            atomic<bool> m_Stopping { false };
+            uint64_t m_Written = 0;
+
+            void WriterLoop();
+
+        public :
+
+            //Throws runtime_error if the file can't be created
+            explicit TraceWriter(const string& path, const size_t capacity = DEFAULT_CAPACITY);
+
+            //Drains the ring and closes the file
+            ~TraceWriter();
+
+            //No copying
+            TraceWriter(const TraceWriter&) = delete;
+            TraceWriter& operator=(const TraceWriter&) = delete;
+
+            //Trace policy to give to the core (see CPUCore::SetTracer)
+            inline RingTracer GetTracer() { return RingTracer(m_Ring); }
+
+            //Waits for every record pushed so far to be written, and stops the writer.
+            //Nothing may be pushed afterwards.
+            void Close();
+
+            //Records written, once closed
+            inline uint64_t GetRecordCount() const { return m_Written; }
+};
+
+//Reads a trace file back
+class TraceReader {
+
+        private :
+
+            ifstream m_File;
+            vector<Byte> m_Buffer;
+            size_t m_Position = 0;
+            TraceRecord m_Previous {};
+
+            bool Fill(const size_t count);
+
+        public :
+
+            //Throws runtime_error if the file can't be read or isn't a trace
+            explicit TraceReader(const string& path);
+
+            //False at the end of the trace. Throws runtime_error on a truncated record.
+            bool Next(TraceRecord& record);
+};
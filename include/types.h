@@ -19,6 +19,10 @@ union address {
         address() = default;
         address(int val) : value(val) {};
         address(Byte page, Byte record) : record(record), page(page) {};
+
+        inline Word GetValue() const { return value; }
+        inline Byte GetPage() const { return page; }
+        inline Byte GetRecord() const { return record; }
     
     friend std::ostream& operator<<( std:: ostream& os, const address& addr ) {
         os << hex
@@ -26,18 +30,23 @@ union address {
                 << setfill('0')
                 << setw(4)
                 << addr.value;
+        return os;
     }
 
-    static address AddZeroPage(Byte value, const Byte record, Byte& cycles){
-        Byte new_record = record + value;
-        if(new_record > 255) {
-            new_record -= 255; //Wrapping up
-            cycles++;
-        }
+    //Zero-page indexing never leaves the zero-page : the record simply wraps around
+    static address AddZeroPage(Byte value, const Byte record){
+        const Byte new_record = record + value; //Wrapping up
         return address {0,new_record};
     }
 
-    static address AddZeroPage(Byte value,const address& addr, Byte& cycles){
-        return AddZeroPage(value,addr.record,cycles);
+    static address AddZeroPage(Byte value,const address& addr){
+        return AddZeroPage(value,addr.record);
+    }
+
+    //Full 16-bit indexing, costs one more cycle when the result lands on another page
+    static address AddIndex(Byte value, const address& addr, Byte& cycles){
+        const address new_addr = addr.value + value;
+        if(new_addr.page != addr.page) cycles++;
+        return new_addr;
     }
 };
\ No newline at end of file
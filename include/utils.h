@@ -1,8 +1,20 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <types.h>
 
 #define MAKE_WORD(high, low) ((high << 8) | low)
 
 
 
 
-#define MAX_MEMORY_KB 1024 * 64
\ No newline at end of file
+#define MAX_MEMORY_KB 1024 * 64
+
+//FNV-1a : AotCPU makes sure the memory holds the image a program was recompiled from, save states check their frames
+constexpr uint64_t HashImage(const Byte* data, const size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+    for(size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,28 @@
+#include "alu.h"
+
+namespace {
+
+    template<Word (*operation)(Byte, Byte, Byte)>
+    constexpr array<Word, DECIMAL_TABLE_SIZE> MakeDecimalTable() {
+        array<Word, DECIMAL_TABLE_SIZE> table {};
+        for(size_t carry = 0; carry < 2; carry++)
+            for(size_t a = 0; a < 256; a++)
+                for(size_t m = 0; m < 256; m++)
+                    table[DecimalIndex(carry, a, m)] = operation(a, m, carry);
+        return table;
+    }
+
+    //Known NMOS results
+    static_assert(DecimalAdd(0x99, 0x01, 0) == AluEntry(0x00, true, false, false, true));
+    static_assert(DecimalAdd(0x79, 0x00, 1) == AluEntry(0x80, false, false, true, true));
+    static_assert(DecimalAdd(0x24, 0x56, 0) == AluEntry(0x80, false, false, true, true));
+    static_assert(DecimalAdd(0x93, 0x82, 0) == AluEntry(0x75, true, false, true, false));
+    static_assert(DecimalSub(0x00, 0x01, 1) == AluEntry(0x99, false, false, false, true));
+    static_assert(DecimalSub(0x46, 0x12, 1) == AluEntry(0x34, true, false, false, false));
+    static_assert(DecimalSub(0x21, 0x34, 1) == AluEntry(0x87, false, false, false, true));
+}
+
+//Constant-initialized : the tables land in read-only data, nothing runs at startup.
+//Generating them here rather than in the header keeps the cost out of every other translation unit.
+constinit const array<Word, DECIMAL_TABLE_SIZE> ADC_DECIMAL = MakeDecimalTable<DecimalAdd>();
+constinit const array<Word, DECIMAL_TABLE_SIZE> SBC_DECIMAL = MakeDecimalTable<DecimalSub>();
@@ -0,0 +1,109 @@
+#include "bus.h"
+#include "save_state.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+    static constexpr size_t PAGE_SIZE = 256;
+
+    static void CheckRange(const Byte page, const size_t count) {
+        if(page + count > 256) throw out_of_range("Mapping past the end of the address space");
+    }
+
+    void Bus::MapRam(const Byte page, const size_t count, Byte* data) {
+        CheckRange(page, count);
+        for(size_t i = 0; i < count; i++)
+            m_Pages[page + i] = { data + i * PAGE_SIZE, data + i * PAGE_SIZE, nullptr };
+    }
+
+    void Bus::MapRom(const Byte page, const size_t count, const Byte* data) {
+        CheckRange(page, count);
+        for(size_t i = 0; i < count; i++)
+            m_Pages[page + i] = { data + i * PAGE_SIZE, nullptr, nullptr };
+    }
+
+    void Bus::MapRom(const Byte page, const size_t count, io_ptr rom, const size_t offset) {
+        const Rom& image = dynamic_cast<const Rom&>(*rom);
+        if(offset + count * PAGE_SIZE > image.GetSize()) throw out_of_range("Mapping past the end of the image");
+        MapRom(page, count, image.GetData() + offset);
+        m_Owned.push_back(rom);
+    }
+
+    void Bus::MapMemory(const Byte page, const size_t count, io_ptr memory, const size_t offset) {
+        Memory& ram = dynamic_cast<Memory&>(*memory);
+        if(offset + count * PAGE_SIZE > ram.GetSize()) throw out_of_range("Mapping past the end of the memory");
+        MapRam(page, count, ram.GetData() + offset);
+        m_Owned.push_back(memory);
+    }
+
+    void Bus::MapDevice(const Byte page, const size_t count, io_ptr device) {
+        CheckRange(page, count);
+        for(size_t i = 0; i < count; i++)
+            m_Pages[page + i] = { nullptr, nullptr, device.get() };
+        m_Owned.push_back(device);
+    }
+
+    void Bus::Unmap(const Byte page, const size_t count) {
+        CheckRange(page, count);
+        for(size_t i = 0; i < count; i++)
+            m_Pages[page + i] = {};
+    }
+
+    void Bus::ReadBytes(const address& addr, span<Byte> bytes) const {
+        Word current = addr.GetValue();
+        size_t done = 0;
+        while(done < bytes.size()) {
+            const address at = current;
+            const Page& page = m_Pages[at.GetPage()];
+            const size_t count = std::min(bytes.size() - done, PAGE_SIZE - at.GetRecord());
+            if(page.m_Read) std::copy_n(page.m_Read + at.GetRecord(), count, bytes.begin() + done);
+            else if(page.m_Device) page.m_Device->ReadBytes(at, bytes.subspan(done, count));
+            else std::fill_n(bytes.begin() + done, count, 0);
+            current += count;
+            done += count;
+        }
+    }
+
+    void Bus::WriteBytes(const address& addr, span<const Byte> bytes) {
+        Word current = addr.GetValue();
+        size_t done = 0;
+        while(done < bytes.size()) {
+            const address at = current;
+            const Page& page = m_Pages[at.GetPage()];
+            const size_t count = std::min(bytes.size() - done, PAGE_SIZE - at.GetRecord());
+            if(page.m_Write) std::copy_n(bytes.begin() + done, count, page.m_Write + at.GetRecord());
+            else if(page.m_Device) page.m_Device->WriteBytes(at, bytes.subspan(done, count));
+            current += count;
+            done += count;
+        }
+    }
+
+    vector<IODevice*> Bus::GetDevices() const {
+        vector<IODevice*> devices;
+        for(const Page& page : m_Pages) {
+            if(page.m_Device && find(devices.begin(), devices.end(), page.m_Device) == devices.end())
+                devices.push_back(page.m_Device);
+        }
+        return devices;
+    }
+
+    void Bus::SaveState(vector<Byte>& out) const {
+        StateWriter writer(out);
+        vector<Byte> state;
+        for(const IODevice* device : GetDevices()) {
+            state.clear();
+            device->SaveState(state);
+            writer.Write32(state.size());
+            writer.WriteBytes(state);
+        }
+    }
+
+    void Bus::LoadState(span<const Byte> in) {
+        StateReader reader(in);
+        for(IODevice* device : GetDevices()) {
+            vector<Byte> state(reader.Read32());
+            reader.ReadBytes(state);
+            device->LoadState(state);
+        }
+        if(!reader.IsAtEnd()) throw runtime_error("Bus state of another device mapping");
+    }
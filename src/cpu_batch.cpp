@@ -0,0 +1,487 @@
+#include "cpu_batch.h"
+#include "alu.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    //GROUP_SIZE bytes processed at once : one AVX2 register, two SSE2 registers, or a plain array
+    struct ByteLanes {
+
+#if defined(__AVX2__)
+
+        __m256i m_Value;
+
+        static ByteLanes Load(const Byte* data) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)) }; }
+        void Store(Byte* data) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), m_Value); }
+        static ByteLanes Splat(const Byte value) { return { _mm256_set1_epi8(static_cast<char>(value)) }; }
+
+        friend ByteLanes operator+(const ByteLanes& a, const ByteLanes& b) { return { _mm256_add_epi8(a.m_Value, b.m_Value) }; }
+        friend ByteLanes operator-(const ByteLanes& a, const ByteLanes& b) { return { _mm256_sub_epi8(a.m_Value, b.m_Value) }; }
+        friend ByteLanes operator&(const ByteLanes& a, const ByteLanes& b) { return { _mm256_and_si256(a.m_Value, b.m_Value) }; }
+        friend ByteLanes operator|(const ByteLanes& a, const ByteLanes& b) { return { _mm256_or_si256(a.m_Value, b.m_Value) }; }
+        friend ByteLanes operator^(const ByteLanes& a, const ByteLanes& b) { return { _mm256_xor_si256(a.m_Value, b.m_Value) }; }
+
+        //~a & b
+        static ByteLanes AndNot(const ByteLanes& a, const ByteLanes& b) { return { _mm256_andnot_si256(a.m_Value, b.m_Value) }; }
+
+        //Masks : 0xFF where true
+        static ByteLanes Equal(const ByteLanes& a, const ByteLanes& b) { return { _mm256_cmpeq_epi8(a.m_Value, b.m_Value) }; }
+        static ByteLanes Negative(const ByteLanes& a) { return { _mm256_cmpgt_epi8(_mm256_setzero_si256(), a.m_Value) }; }
+        static ByteLanes SubSaturate(const ByteLanes& a, const ByteLanes& b) { return { _mm256_subs_epu8(a.m_Value, b.m_Value) }; }
+
+        static ByteLanes Select(const ByteLanes& mask, const ByteLanes& a, const ByteLanes& b) { return { _mm256_blendv_epi8(b.m_Value, a.m_Value, mask.m_Value) }; }
+
+        //No 8-bit shifts : 16-bit shifts with the bits crossing bytes masked out
+        static ByteLanes ShiftRight1(const ByteLanes& a) { return ByteLanes { _mm256_srli_epi16(a.m_Value, 1) } & Splat(0x7F); }
+
+        bool Any() const { return !_mm256_testz_si256(m_Value, m_Value); }
+
+#elif defined(__SSE2__)
+
+        __m128i m_Low, m_High;
+
+        template<typename Operation>
+        static ByteLanes Apply(const ByteLanes& a, const ByteLanes& b, Operation operation) {
+            return { operation(a.m_Low, b.m_Low), operation(a.m_High, b.m_High) };
+        }
+
+        static ByteLanes Load(const Byte* data) {
+            return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)) };
+        }
+        void Store(Byte* data) const {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data), m_Low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), m_High);
+        }
+        static ByteLanes Splat(const Byte value) { return { _mm_set1_epi8(static_cast<char>(value)), _mm_set1_epi8(static_cast<char>(value)) }; }
+
+        friend ByteLanes operator+(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_add_epi8(x, y); }); }
+        friend ByteLanes operator-(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_sub_epi8(x, y); }); }
+        friend ByteLanes operator&(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_and_si128(x, y); }); }
+        friend ByteLanes operator|(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_or_si128(x, y); }); }
+        friend ByteLanes operator^(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_xor_si128(x, y); }); }
+
+        static ByteLanes AndNot(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_andnot_si128(x, y); }); }
+
+        static ByteLanes Equal(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_cmpeq_epi8(x, y); }); }
+        static ByteLanes Negative(const ByteLanes& a) { return Apply(Splat(0), a, [](__m128i x, __m128i y) { return _mm_cmpgt_epi8(x, y); }); }
+        static ByteLanes SubSaturate(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](__m128i x, __m128i y) { return _mm_subs_epu8(x, y); }); }
+
+        static ByteLanes Select(const ByteLanes& mask, const ByteLanes& a, const ByteLanes& b) { return (mask & a) | AndNot(mask, b); }
+
+        static ByteLanes ShiftRight1(const ByteLanes& a) { return ByteLanes { _mm_srli_epi16(a.m_Low, 1), _mm_srli_epi16(a.m_High, 1) } & Splat(0x7F); }
+
+        //On masks only (0x00 / 0xFF lanes)
+        bool Any() const { return _mm_movemask_epi8(_mm_or_si128(m_Low, m_High)) != 0; }
+
+#else
+
+        array<Byte, CPUBatch::GROUP_SIZE> m_Value;
+
+        template<typename Operation>
+        static ByteLanes Apply(const ByteLanes& a, const ByteLanes& b, Operation operation) {
+            ByteLanes result;
+            for(size_t i = 0; i < CPUBatch::GROUP_SIZE; i++) result.m_Value[i] = operation(a.m_Value[i], b.m_Value[i]);
+            return result;
+        }
+
+        static ByteLanes Load(const Byte* data) { ByteLanes lanes; copy_n(data, CPUBatch::GROUP_SIZE, lanes.m_Value.begin()); return lanes; }
+        void Store(Byte* data) const { copy_n(m_Value.begin(), CPUBatch::GROUP_SIZE, data); }
+        static ByteLanes Splat(const Byte value) { ByteLanes lanes; lanes.m_Value.fill(value); return lanes; }
+
+        friend ByteLanes operator+(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x + y; }); }
+        friend ByteLanes operator-(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x - y; }); }
+        friend ByteLanes operator&(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x & y; }); }
+        friend ByteLanes operator|(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x | y; }); }
+        friend ByteLanes operator^(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x ^ y; }); }
+
+        static ByteLanes AndNot(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return ~x & y; }); }
+
+        static ByteLanes Equal(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x == y ? 0xFF : 0; }); }
+        static ByteLanes Negative(const ByteLanes& a) { return Apply(a, a, [](Byte x, Byte) -> Byte { return x & 0x80 ? 0xFF : 0; }); }
+        static ByteLanes SubSaturate(const ByteLanes& a, const ByteLanes& b) { return Apply(a, b, [](Byte x, Byte y) -> Byte { return x > y ? x - y : 0; }); }
+
+        static ByteLanes Select(const ByteLanes& mask, const ByteLanes& a, const ByteLanes& b) { return (mask & a) | AndNot(mask, b); }
+
+        static ByteLanes ShiftRight1(const ByteLanes& a) { return Apply(a, a, [](Byte x, Byte) -> Byte { return x >> 1; }); }
+
+        bool Any() const { for(const Byte value : m_Value) if(value) return true; return false; }
+
+#endif
+
+        static ByteLanes ShiftLeft1(const ByteLanes& a) { return a + a; }
+
+        //a < b, unsigned
+        static ByteLanes Less(const ByteLanes& a, const ByteLanes& b) { return AndNot(Equal(SubSaturate(b, a), Splat(0)), Splat(0xFF)); }
+
+        //Masks with a bit set
+        static ByteLanes HasBit(const ByteLanes& a, const Byte bit) { return Equal(a & Splat(bit), Splat(bit)); }
+    };
+
+    inline ByteLanes SetFlag(const ByteLanes& status, const StatusFlag flag, const ByteLanes& mask) {
+        const ByteLanes bit = ByteLanes::Splat(static_cast<Byte>(flag));
+        return ByteLanes::AndNot(bit, status) | (mask & bit);
+    }
+
+    inline ByteLanes SetNZ(const ByteLanes& status, const ByteLanes& value) {
+        const ByteLanes flags = SetFlag(status, StatusFlag::ZERO, ByteLanes::Equal(value, ByteLanes::Splat(0)));
+        return SetFlag(flags, StatusFlag::NEGATIVE, ByteLanes::Negative(value));
+    }
+}
+
+    const array<CPUBatch::Kernel, 256> CPUBatch::s_Kernels = CPUBatch::MakeKernels(make_index_sequence<256>{});
+
+    static size_t Padded(const size_t lanes) {
+        return (lanes + CPUBatch::GROUP_SIZE - 1) / CPUBatch::GROUP_SIZE * CPUBatch::GROUP_SIZE;
+    }
+
+    CPUBatch::CPUBatch(const size_t lanes, IODevice::io_ptr shared)
+        : m_Lanes(lanes), m_PC(Padded(lanes), 0), m_SP(Padded(lanes), 0), m_A(Padded(lanes), 0), m_X(Padded(lanes), 0),
+          m_Y(Padded(lanes), 0), m_P(Padded(lanes), 0), m_Halted(Padded(lanes), 0xFF), m_Cycles(Padded(lanes), 0),
+          m_Memory(Padded(lanes), nullptr), m_Rams(Padded(lanes), nullptr), m_Devices(Padded(lanes)) {
+
+        for(size_t lane = 0; lane < lanes; lane++) {
+            SetMemory(lane, shared ? shared : Memory::Make());
+            Reset(lane);
+        }
+    }
+
+    CPUBatch::CPUBatch(const size_t lanes) : CPUBatch(lanes, nullptr) {}
+
+    void CPUBatch::SetMemory(const size_t lane, IODevice::io_ptr memory) {
+        Memory& ram = dynamic_cast<Memory&>(*memory);
+        if(ram.GetSize() < MAX_MEMORY_KB) throw out_of_range("Lane memory must cover the whole address space");
+        m_Memory[lane] = ram.GetData();
+        m_Rams[lane] = &ram;
+        m_Devices[lane] = std::move(memory);
+    }
+
+    void CPUBatch::Reset(const size_t lane) {
+        m_PC[lane] = MAKE_WORD(Read(lane, 0xFFFD), Read(lane, 0xFFFC));
+        m_SP[lane] = 0xFD;
+        m_A[lane] = m_X[lane] = m_Y[lane] = 0;
+        m_P[lane] = static_cast<Byte>(StatusFlag::INTERRUPT) | static_cast<Byte>(StatusFlag::UNUSED);
+        m_Halted[lane] = 0;
+    }
+
+    Registers CPUBatch::GetRegisters(const size_t lane) const {
+        Registers registers {};
+        registers.m_PC = m_PC[lane];
+        registers.m_SP = m_SP[lane];
+        registers.m_Acc = m_A[lane];
+        registers.m_X = m_X[lane];
+        registers.m_Y = m_Y[lane];
+        registers.m_CpuStatus = m_P[lane];
+        return registers;
+    }
+
+    void CPUBatch::SetRegisters(const size_t lane, const Registers& registers) {
+        m_PC[lane] = registers.m_PC;
+        m_SP[lane] = registers.m_SP;
+        m_A[lane] = registers.m_Acc;
+        m_X[lane] = registers.m_X;
+        m_Y[lane] = registers.m_Y;
+        m_P[lane] = registers.m_CpuStatus.m_Value;
+        m_Halted[lane] = 0;
+    }
+
+    void CPUBatch::Step() {
+        for(size_t base = 0; base < m_PC.size(); base += GROUP_SIZE) StepGroup(base);
+    }
+
+    void CPUBatch::Run(uint64_t instructions) {
+        while(instructions--) Step();
+    }
+
+    void CPUBatch::StepGroup(const size_t base) {
+        alignas(32) Byte opcodes[GROUP_SIZE];
+        for(size_t i = 0; i < GROUP_SIZE; i++)
+            opcodes[i] = m_Halted[base + i] ? 0 : Read(base + i, m_PC[base + i]);
+
+        ByteLanes pending = ByteLanes::AndNot(ByteLanes::Load(&m_Halted[base]), ByteLanes::Splat(0xFF));
+        const ByteLanes codes = ByteLanes::Load(opcodes);
+
+        alignas(32) Byte mask[GROUP_SIZE];
+        while(pending.Any()) {
+            //Every lane waiting on the same opcode as the first pending one runs now
+            pending.Store(mask);
+            size_t first = 0;
+            while(!mask[first]) first++;
+
+            const ByteLanes selected = ByteLanes::Equal(codes, ByteLanes::Splat(opcodes[first])) & pending;
+            selected.Store(mask);
+            s_Kernels[opcodes[first]](*this, base, mask);
+            pending = ByteLanes::AndNot(selected, pending);
+        }
+    }
+
+    template<Byte code>
+    void CPUBatch::Execute( CPUBatch& batch, const size_t base, const Byte* mask ) {
+
+        using enum Instructions;
+
+        constexpr Opcode opcode = OPCODES[code];
+        constexpr Instructions instruction = opcode.m_Instruction;
+        constexpr AddressMode addrMode = opcode.m_AddrMode;
+
+        alignas(32) Byte value[GROUP_SIZE] = {};
+        Word addr[GROUP_SIZE] = {};
+
+        alignas(32) Byte penalty[GROUP_SIZE] = {};
+
+        //Addressing, lane by lane : see CPUCore::Address and CPUCore::Resolve
+        if constexpr (OperandSize(addrMode) > 0) {
+            for(size_t i = 0; i < GROUP_SIZE; i++) {
+                if(!mask[i]) continue;
+                const size_t lane = base + i;
+                const Word pc = batch.m_PC[lane] + 1;
+                const Word next = pc + OperandSize(addrMode);
+
+                using enum AddressMode;
+                if constexpr (addrMode == IMM) addr[i] = pc;
+                else if constexpr (addrMode == ZPG) addr[i] = batch.Read(lane, pc);
+                else if constexpr (addrMode == ZPX) addr[i] = static_cast<Byte>(batch.Read(lane, pc) + batch.m_X[lane]);
+                else if constexpr (addrMode == ZPY) addr[i] = static_cast<Byte>(batch.Read(lane, pc) + batch.m_Y[lane]);
+                else if constexpr (addrMode == REL) addr[i] = next + static_cast<signed char>(batch.Read(lane, pc));
+                else if constexpr (OperandSize(addrMode) == 2) {
+                    const Word operand = MAKE_WORD(batch.Read(lane, pc + 1), batch.Read(lane, pc));
+                    if constexpr (addrMode == ABS) addr[i] = operand;
+                    else if constexpr (addrMode == IND) {
+                        //The pointer never crosses a page
+                        const Word hi = (operand & 0xFF00) | static_cast<Byte>(operand + 1);
+                        addr[i] = MAKE_WORD(batch.Read(lane, hi), batch.Read(lane, operand));
+                    }
+                    else {
+                        addr[i] = operand + (addrMode == ABX ? batch.m_X[lane] : batch.m_Y[lane]);
+                        penalty[i] = opcode.m_PageCross && (addr[i] >> 8) != (operand >> 8);
+                    }
+                }
+                else if constexpr (addrMode == AddressMode::INX) {
+                    const Byte pointer = batch.Read(lane, pc) + batch.m_X[lane];
+                    addr[i] = MAKE_WORD(batch.Read(lane, static_cast<Byte>(pointer + 1)), batch.Read(lane, pointer));
+                }
+                else if constexpr (addrMode == AddressMode::INY) {
+                    const Byte pointer = batch.Read(lane, pc);
+                    const Word lookup = MAKE_WORD(batch.Read(lane, static_cast<Byte>(pointer + 1)), batch.Read(lane, pointer));
+                    addr[i] = lookup + batch.m_Y[lane];
+                    penalty[i] = opcode.m_PageCross && (addr[i] >> 8) != (lookup >> 8);
+                }
+
+                if constexpr (ReadsOperand(instruction, addrMode)) value[i] = batch.Read(lane, addr[i]);
+            }
+        }
+
+        //PC and cycles : branch free, the compiler vectorizes these
+        constexpr Byte size = 1 + OperandSize(addrMode);
+        for(size_t i = 0; i < GROUP_SIZE; i++) batch.m_PC[base + i] += mask[i] & size;
+        for(size_t i = 0; i < GROUP_SIZE; i++) batch.m_Cycles[base + i] += mask[i] & (opcode.m_Cycles + penalty[i]);
+
+        //Register and flag updates, on the whole group
+        const ByteLanes selected = ByteLanes::Load(mask);
+        const ByteLanes operand = ByteLanes::Load(value);
+        ByteLanes status = ByteLanes::Load(&batch.m_P[base]);
+        const ByteLanes initialStatus = status;
+
+        auto update = [&](vector<Byte>& registers, const ByteLanes& result) {
+            ByteLanes::Select(selected, result, ByteLanes::Load(&registers[base])).Store(&registers[base]);
+        };
+
+        auto load = [&](vector<Byte>& registers) { return ByteLanes::Load(&registers[base]); };
+
+        auto compare = [&](const ByteLanes& reg) {
+            status = SetFlag(status, StatusFlag::CARRY, ByteLanes::AndNot(ByteLanes::Less(reg, operand), ByteLanes::Splat(0xFF)));
+            status = SetNZ(status, reg - operand);
+        };
+
+        auto addWithCarry = [&](const ByteLanes& value) {
+            const ByteLanes acc = load(batch.m_A);
+            const ByteLanes partial = acc + value;
+            const ByteLanes sum = partial + (status & ByteLanes::Splat(0x01));
+            const ByteLanes carry = ByteLanes::Less(partial, acc) | ByteLanes::Less(sum, partial);
+            //Overflow when both operands share a sign the result doesn't have
+            const ByteLanes overflow = ByteLanes::Negative(ByteLanes::AndNot(acc ^ value, acc ^ sum));
+            status = SetFlag(status, StatusFlag::CARRY, carry);
+            status = SetFlag(status, StatusFlag::INT_OVERFLOW, overflow);
+            status = SetNZ(status, sum);
+            update(batch.m_A, sum);
+        };
+
+        //Read-Modify-Write on the accumulator or the operand, returns the result
+        auto modify = [&](const ByteLanes& input) {
+            const ByteLanes carryIn = status & ByteLanes::Splat(0x01);
+            ByteLanes result;
+            if constexpr (instruction == ASL || instruction == ROL) {
+                status = SetFlag(status, StatusFlag::CARRY, ByteLanes::Negative(input));
+                result = ByteLanes::ShiftLeft1(input);
+                if constexpr (instruction == ROL) result = result | carryIn;
+            }
+            else if constexpr (instruction == LSR || instruction == ROR) {
+                status = SetFlag(status, StatusFlag::CARRY, ByteLanes::HasBit(input, 0x01));
+                result = ByteLanes::ShiftRight1(input);
+                if constexpr (instruction == ROR) result = result | (ByteLanes::HasBit(carryIn, 0x01) & ByteLanes::Splat(0x80));
+            }
+            else if constexpr (instruction == INC) result = input + ByteLanes::Splat(1);
+            else result = input - ByteLanes::Splat(1);
+            status = SetNZ(status, result);
+            return result;
+        };
+
+        if constexpr (instruction == LDA || instruction == LDX || instruction == LDY) {
+            update(instruction == LDA ? batch.m_A : instruction == LDX ? batch.m_X : batch.m_Y, operand);
+            status = SetNZ(status, operand);
+        }
+        else if constexpr (instruction == AND || instruction == ORA || instruction == EOR) {
+            const ByteLanes acc = load(batch.m_A);
+            const ByteLanes result = instruction == AND ? acc & operand : instruction == ORA ? acc | operand : acc ^ operand;
+            update(batch.m_A, result);
+            status = SetNZ(status, result);
+        }
+        else if constexpr (instruction == ADC || instruction == SBC) {
+            constexpr Byte DECIMAL = static_cast<Byte>(StatusFlag::DECIMAL);
+
+            Byte decimal = 0;
+            for(size_t i = 0; i < GROUP_SIZE; i++) decimal |= mask[i] & batch.m_P[base + i];
+
+            Byte acc[GROUP_SIZE];
+            if(decimal & DECIMAL) load(batch.m_A).Store(acc);
+
+            //Binary substraction is an addition of the one's complement
+            addWithCarry(instruction == ADC ? operand : operand ^ ByteLanes::Splat(0xFF));
+
+            //Decimal mode lanes : lane by lane, from the tables (see CPUCore::DecimalArithmetic)
+            if(decimal & DECIMAL) {
+                const array<Word, DECIMAL_TABLE_SIZE>& table = instruction == ADC ? ADC_DECIMAL : SBC_DECIMAL;
+                Byte flags[GROUP_SIZE];
+                status.Store(flags);
+                for(size_t i = 0; i < GROUP_SIZE; i++) {
+                    const Byte p = batch.m_P[base + i];
+                    if(!mask[i] || !(p & DECIMAL)) continue;
+                    const Word entry = table[DecimalIndex(p & static_cast<Byte>(StatusFlag::CARRY), acc[i], value[i])];
+                    batch.m_A[base + i] = entry & 0xFF;
+                    flags[i] = (flags[i] & ~ALU_FLAGS) | (entry >> 8);
+                }
+                status = ByteLanes::Load(flags);
+            }
+        }
+        else if constexpr (instruction == CMP) compare(load(batch.m_A));
+        else if constexpr (instruction == CPX) compare(load(batch.m_X));
+        else if constexpr (instruction == CPY) compare(load(batch.m_Y));
+        else if constexpr (instruction == BIT) {
+            status = SetFlag(status, StatusFlag::ZERO, ByteLanes::Equal(load(batch.m_A) & operand, ByteLanes::Splat(0)));
+            status = SetFlag(status, StatusFlag::INT_OVERFLOW, ByteLanes::HasBit(operand, 0x40));
+            status = SetFlag(status, StatusFlag::NEGATIVE, ByteLanes::Negative(operand));
+        }
+        else if constexpr (IsReadModifyWrite(instruction)) {
+            if constexpr (addrMode == AddressMode::ACC) update(batch.m_A, modify(load(batch.m_A)));
+            else {
+                modify(operand).Store(value);
+                for(size_t i = 0; i < GROUP_SIZE; i++) if(mask[i]) batch.Write(base + i, addr[i], value[i]);
+            }
+        }
+        else if constexpr (instruction == Instructions::INX || instruction == DEX) {
+            const ByteLanes result = load(batch.m_X) + ByteLanes::Splat(instruction == Instructions::INX ? 0x01 : 0xFF);
+            update(batch.m_X, result);
+            status = SetNZ(status, result);
+        }
+        else if constexpr (instruction == Instructions::INY || instruction == DEY) {
+            const ByteLanes result = load(batch.m_Y) + ByteLanes::Splat(instruction == Instructions::INY ? 0x01 : 0xFF);
+            update(batch.m_Y, result);
+            status = SetNZ(status, result);
+        }
+        else if constexpr (instruction == TAX || instruction == TAY || instruction == TSX || instruction == TXA || instruction == TYA) {
+            const ByteLanes result = load(instruction == TAX || instruction == TAY ? batch.m_A : instruction == TSX ? batch.m_SP : instruction == TXA ? batch.m_X : batch.m_Y);
+            update(instruction == TAX || instruction == TSX ? batch.m_X : instruction == TAY ? batch.m_Y : batch.m_A, result);
+            status = SetNZ(status, result);
+        }
+        else if constexpr (instruction == TXS) update(batch.m_SP, load(batch.m_X));
+
+        else if constexpr (instruction == CLC) status = SetFlag(status, StatusFlag::CARRY, ByteLanes::Splat(0));
+        else if constexpr (instruction == SEC) status = SetFlag(status, StatusFlag::CARRY, ByteLanes::Splat(0xFF));
+        else if constexpr (instruction == CLD) status = SetFlag(status, StatusFlag::DECIMAL, ByteLanes::Splat(0));
+        else if constexpr (instruction == SED) status = SetFlag(status, StatusFlag::DECIMAL, ByteLanes::Splat(0xFF));
+        else if constexpr (instruction == CLI) status = SetFlag(status, StatusFlag::INTERRUPT, ByteLanes::Splat(0));
+        else if constexpr (instruction == SEI) status = SetFlag(status, StatusFlag::INTERRUPT, ByteLanes::Splat(0xFF));
+        else if constexpr (instruction == CLV) status = SetFlag(status, StatusFlag::INT_OVERFLOW, ByteLanes::Splat(0));
+
+        //Memory, stack and control flow : lane by lane, see CPUCore::Execute
+        else {
+            constexpr Byte BREAK = static_cast<Byte>(StatusFlag::BREAK);
+            constexpr Byte UNUSED = static_cast<Byte>(StatusFlag::UNUSED);
+
+            for(size_t i = 0; i < GROUP_SIZE; i++) {
+                if(!mask[i]) continue;
+                const size_t lane = base + i;
+                Word& pc = batch.m_PC[lane];
+                Byte& p = batch.m_P[lane];
+
+                auto branch = [&](const bool condition) {
+                    if(!condition) return;
+                    batch.m_Cycles[lane] += (pc >> 8) != (addr[i] >> 8) ? 2 : 1;
+                    pc = addr[i];
+                };
+
+                if constexpr (instruction == STA) batch.Write(lane, addr[i], batch.m_A[lane]);
+                else if constexpr (instruction == STX) batch.Write(lane, addr[i], batch.m_X[lane]);
+                else if constexpr (instruction == STY) batch.Write(lane, addr[i], batch.m_Y[lane]);
+
+                else if constexpr (instruction == PHA) batch.Push(lane, batch.m_A[lane]);
+                else if constexpr (instruction == PHP) batch.Push(lane, p | BREAK | UNUSED);
+                else if constexpr (instruction == PLA) {
+                    const Byte result = batch.m_A[lane] = batch.Pull(lane);
+                    p = (p & ~(static_cast<Byte>(StatusFlag::ZERO) | static_cast<Byte>(StatusFlag::NEGATIVE)))
+                      | (result == 0 ? static_cast<Byte>(StatusFlag::ZERO) : 0) | (result & static_cast<Byte>(StatusFlag::NEGATIVE));
+                }
+                else if constexpr (instruction == PLP) p = (batch.Pull(lane) & ~BREAK) | UNUSED;
+
+                else if constexpr (instruction == BCC) branch(!(p & static_cast<Byte>(StatusFlag::CARRY)));
+                else if constexpr (instruction == BCS) branch(p & static_cast<Byte>(StatusFlag::CARRY));
+                else if constexpr (instruction == BNE) branch(!(p & static_cast<Byte>(StatusFlag::ZERO)));
+                else if constexpr (instruction == BEQ) branch(p & static_cast<Byte>(StatusFlag::ZERO));
+                else if constexpr (instruction == BPL) branch(!(p & static_cast<Byte>(StatusFlag::NEGATIVE)));
+                else if constexpr (instruction == BMI) branch(p & static_cast<Byte>(StatusFlag::NEGATIVE));
+                else if constexpr (instruction == BVC) branch(!(p & static_cast<Byte>(StatusFlag::INT_OVERFLOW)));
+                else if constexpr (instruction == BVS) branch(p & static_cast<Byte>(StatusFlag::INT_OVERFLOW));
+
+                else if constexpr (instruction == JMP) pc = addr[i];
+                else if constexpr (instruction == JSR) {
+                    const Word ret = pc - 1;
+                    batch.Push(lane, ret >> 8);
+                    batch.Push(lane, ret & 0xFF);
+                    pc = addr[i];
+                }
+                else if constexpr (instruction == RTS) {
+                    const Byte lo = batch.Pull(lane);
+                    const Byte hi = batch.Pull(lane);
+                    pc = MAKE_WORD(hi, lo) + 1;
+                }
+                else if constexpr (instruction == RTI) {
+                    p = (batch.Pull(lane) & ~BREAK) | UNUSED;
+                    const Byte lo = batch.Pull(lane);
+                    const Byte hi = batch.Pull(lane);
+                    pc = MAKE_WORD(hi, lo);
+                }
+                else if constexpr (instruction == BRK) {
+                    pc++;
+                    batch.Push(lane, pc >> 8);
+                    batch.Push(lane, pc & 0xFF);
+                    batch.Push(lane, p | BREAK | UNUSED);
+                    p |= static_cast<Byte>(StatusFlag::INTERRUPT);
+                    pc = MAKE_WORD(batch.Read(lane, 0xFFFF), batch.Read(lane, 0xFFFE));
+                }
+                else if constexpr (instruction == ILL) {
+                    pc--; //Stays on the jamming opcode
+                    batch.m_Halted[lane] = 0xFF;
+                }
+            }
+            return;
+        }
+
+        ByteLanes::Select(selected, status, initialStatus).Store(&batch.m_P[base]);
+    }
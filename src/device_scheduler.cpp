@@ -0,0 +1,58 @@
+#include "device_scheduler.h"
+
+#include <algorithm>
+
+    void DeviceScheduler::Sleep(const uint64_t cycle, coroutine_handle<> handle) {
+        m_Wakes.push_back({ cycle, m_WakeOrder++, handle });
+        push_heap(m_Wakes.begin(), m_Wakes.end());
+    }
+
+    void DeviceScheduler::Arm() {
+        if(!m_Arm || m_Wakes.empty()) return;
+        const uint64_t next = m_Wakes.front().m_Cycle;
+        if(next >= m_Armed) return;
+        m_Armed = next;
+        m_Arm(next);
+    }
+
+    void DeviceScheduler::Spawn(DeviceTask task) {
+        //The devices that returned are dropped on the way
+        erase_if(m_Tasks, [](const DeviceTask& done) { return done.IsDone(); });
+        const coroutine_handle<> handle = task.GetHandle();
+        m_Tasks.push_back(std::move(task));
+        Resume(handle);
+    }
+
+    void DeviceScheduler::CatchUp() {
+        if(m_CatchingUp) return;
+
+        const uint64_t now = m_Clock ? max(m_Clock(), m_Now) : m_Now;
+        m_CatchingUp = true;
+        try {
+            while(!m_Wakes.empty() && m_Wakes.front().m_Cycle <= now) {
+                pop_heap(m_Wakes.begin(), m_Wakes.end());
+                const Wake wake = m_Wakes.back();
+                m_Wakes.pop_back();
+                m_Now = wake.m_Cycle;
+                wake.m_Handle.resume();
+            }
+        }
+        catch(...) {
+            m_CatchingUp = false;
+            throw;
+        }
+        m_CatchingUp = false;
+        m_Now = now;
+        Arm();
+    }
+
+    void DeviceScheduler::Resume(coroutine_handle<> handle) {
+        CatchUp();
+        handle.resume();
+        Arm();
+    }
+
+    void DeviceScheduler::Fire() {
+        m_Armed = NEVER;
+        CatchUp();
+    }
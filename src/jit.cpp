@@ -0,0 +1,843 @@
+#include "jit.h"
+#include "alu.h"
+
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define EMU6502_JIT_X64
+#endif
+
+#ifdef EMU6502_JIT_X64
+
+    static constexpr size_t CODE_ALIGN = 16;
+
+    ExecutableMemory::ExecutableMemory(const size_t size) {
+        void* base = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(base == MAP_FAILED) return;
+        m_Base = static_cast<Byte*>(base);
+        m_Size = size;
+    }
+
+    ExecutableMemory::~ExecutableMemory() {
+        if(m_Base) munmap(m_Base, m_Size);
+    }
+
+    void* ExecutableMemory::Commit(const vector<Byte>& code) {
+        const size_t start = (m_Used + CODE_ALIGN - 1) & ~(CODE_ALIGN - 1);
+        if(!m_Base || start + code.size() > m_Size) return nullptr;
+
+        //Only the host pages receiving the code are made writable, and never while executable
+        const size_t hostPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t first = start & ~(hostPage - 1);
+        const size_t last = (start + code.size() + hostPage - 1) & ~(hostPage - 1);
+
+        if(mprotect(m_Base + first, last - first, PROT_READ | PROT_WRITE)) return nullptr;
+        memcpy(m_Base + start, code.data(), code.size());
+        if(mprotect(m_Base + first, last - first, PROT_READ | PROT_EXEC)) return nullptr;
+
+        m_Used = start + code.size();
+        return m_Base + start;
+    }
+
+namespace {
+
+    //x86-64 registers, by encoding
+    enum Reg : Byte { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15, NONE = 0xFF };
+
+    //Condition codes (Jcc / SETcc)
+    enum Cond : Byte { CC_NC = 0x3, CC_Z = 0x4, CC_NZ = 0x5 };
+
+    //Group 1 opcode extensions (0x81 /ext)
+    enum Alu : Byte { ALU_ADD = 0, ALU_OR = 1, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 };
+
+    //[base + index + disp]
+    struct Mem {
+        Reg m_Base;
+        Reg m_Index = NONE;
+        int32_t m_Disp = 0;
+    };
+
+    //Register allocation of the translated code :
+    //  rdi : Registers*            rsi : NZ_TABLE
+    //  r12 : A     r13 : X     r14 : Y     r15 : P (zero extended)
+    //  ebx : cycles spent on penalties     ebp : instructions executed (set on exit)
+    //  rax, rcx, rdx, r8 - r11 : scratch
+    constexpr Reg REG_A = R12;
+    constexpr Reg REG_X = R13;
+    constexpr Reg REG_Y = R14;
+    constexpr Reg REG_P = R15;
+
+    constexpr int32_t OFF_PC = offsetof(Registers, m_PC);
+    constexpr int32_t OFF_SP = offsetof(Registers, m_SP);
+    constexpr int32_t OFF_ACC = offsetof(Registers, m_Acc);
+    constexpr int32_t OFF_X = offsetof(Registers, m_X);
+    constexpr int32_t OFF_Y = offsetof(Registers, m_Y);
+    constexpr int32_t OFF_STATUS = offsetof(Registers, m_CpuStatus);
+    constexpr int32_t OFF_OPVALUE = offsetof(Registers, m_OpValue);
+
+    constexpr Byte FLAG_C = static_cast<Byte>(StatusFlag::CARRY);
+    constexpr Byte FLAG_D = static_cast<Byte>(StatusFlag::DECIMAL);
+    constexpr Byte FLAG_Z = static_cast<Byte>(StatusFlag::ZERO);
+    constexpr Byte FLAG_B = static_cast<Byte>(StatusFlag::BREAK);
+    constexpr Byte FLAG_U = static_cast<Byte>(StatusFlag::UNUSED);
+    constexpr Byte FLAG_V = static_cast<Byte>(StatusFlag::INT_OVERFLOW);
+    constexpr Byte FLAG_N = static_cast<Byte>(StatusFlag::NEGATIVE);
+
+    //Z and N flags of every byte value
+    constexpr array<Byte, 256> MakeNZTable() {
+        array<Byte, 256> table {};
+        for(size_t value = 0; value < 256; value++)
+            table[value] = (value == 0 ? FLAG_Z : 0) | (value & FLAG_N);
+        return table;
+    }
+
+    constexpr array<Byte, 256> NZ_TABLE = MakeNZTable();
+
+    //Minimal x86-64 encoder, covering what the translator needs
+    class Emitter {
+
+        private :
+
+            vector<Byte> m_Code;
+
+            void Rex(const bool wide, const int reg, const Reg index, const int base, const bool byteRegs) {
+                const Byte rex = 0x40 | (wide << 3) | (((reg >> 3) & 1) << 2)
+                               | (index == NONE ? 0 : ((index >> 3) & 1) << 1) | ((base >> 3) & 1);
+                //Without REX, byte registers 4 - 7 would be AH, CH, DH, BH
+                if(rex != 0x40 || byteRegs) Emit(rex);
+            }
+
+            void ModRM(const int reg, const Reg rm) { Emit(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+
+            void ModRM(const int reg, const Mem& mem) {
+                const bool sib = mem.m_Index != NONE || (mem.m_Base & 7) == RSP;
+                Byte mod = 2;
+                if(mem.m_Disp == 0 && (mem.m_Base & 7) != RBP) mod = 0;
+                else if(mem.m_Disp >= -128 && mem.m_Disp <= 127) mod = 1;
+
+                Emit((mod << 6) | ((reg & 7) << 3) | (sib ? 4 : mem.m_Base & 7));
+                if(sib) Emit((((mem.m_Index == NONE ? RSP : mem.m_Index) & 7) << 3) | (mem.m_Base & 7));
+                if(mod == 1) Emit(static_cast<Byte>(mem.m_Disp));
+                else if(mod == 2) Emit32(mem.m_Disp);
+            }
+
+            template<typename RM>
+            void Instr(const initializer_list<Byte> opcode, const int reg, const RM& rm, const bool wide = false, const bool byteRegs = false, const Byte prefix = 0) {
+                if(prefix) Emit(prefix);
+                if constexpr (is_same_v<RM, Mem>) Rex(wide, reg, rm.m_Index, rm.m_Base, byteRegs);
+                else Rex(wide, reg, NONE, rm, byteRegs);
+                for(const Byte byte : opcode) Emit(byte);
+                ModRM(reg, rm);
+            }
+
+        public :
+
+            inline size_t Size() const { return m_Code.size(); }
+            inline vector<Byte>& Code() { return m_Code; }
+            inline void Truncate(const size_t size) { m_Code.resize(size); }
+
+            inline void Emit(const Byte byte) { m_Code.push_back(byte); }
+            void Emit16(const uint16_t value) { for(int i = 0; i < 2; i++) Emit(value >> (i * 8)); }
+            void Emit32(const uint32_t value) { for(int i = 0; i < 4; i++) Emit(value >> (i * 8)); }
+            void Emit64(const uint64_t value) { for(int i = 0; i < 8; i++) Emit(value >> (i * 8)); }
+
+            void Push(const Reg reg) { if(reg >= R8) Emit(0x41); Emit(0x50 | (reg & 7)); }
+            void Pop(const Reg reg) { if(reg >= R8) Emit(0x41); Emit(0x58 | (reg & 7)); }
+            void Ret() { Emit(0xC3); }
+
+            void Mov(const Reg dst, const Reg src) { Instr({ 0x89 }, src, dst); }
+            void MovImm(const Reg dst, const uint32_t value) { Rex(false, 0, NONE, dst, false); Emit(0xB8 | (dst & 7)); Emit32(value); }
+            void MovPtr(const Reg dst, const void* pointer) {
+                Rex(true, 0, NONE, dst, false);
+                Emit(0xB8 | (dst & 7));
+                Emit64(reinterpret_cast<uint64_t>(pointer));
+            }
+
+            //32-bit register operations
+            void AluReg(const Alu alu, const Reg dst, const Reg src) { Instr({ static_cast<Byte>((alu << 3) | 0x01) }, src, dst); }
+            void AluImm(const Alu alu, const Reg dst, const uint32_t value) { Instr({ 0x81 }, alu, dst); Emit32(value); }
+            void Test(const Reg dst, const Reg src) { Instr({ 0x85 }, src, dst); }
+            void TestImm(const Reg dst, const uint32_t value) { Instr({ 0xF7 }, 0, dst); Emit32(value); }
+            void Not(const Reg dst) { Instr({ 0xF7 }, 2, dst); }
+            void Inc(const Reg dst) { Instr({ 0xFF }, 0, dst); }
+            void Dec(const Reg dst) { Instr({ 0xFF }, 1, dst); }
+            void Shl(const Reg dst, const Byte count) { Instr({ 0xC1 }, 4, dst); Emit(count); }
+            void Shr(const Reg dst, const Byte count) { Instr({ 0xC1 }, 5, dst); Emit(count); }
+            void Shl64(const Reg dst, const Byte count) { Instr({ 0xC1 }, 4, dst, true); Emit(count); }
+            void Or64(const Reg dst, const Reg src) { Instr({ 0x09 }, src, dst, true); }
+            void ZeroExtend(const Reg dst, const Reg src) { Instr({ 0x0F, 0xB6 }, dst, src, false, true); }
+            void SetCond(const Cond cond, const Reg dst) { Instr({ 0x0F, static_cast<Byte>(0x90 | cond) }, 0, dst, false, true); }
+
+            //Memory operations
+            void LoadByte(const Reg dst, const Mem& mem) { Instr({ 0x0F, 0xB6 }, dst, mem); }
+            void LoadWord(const Reg dst, const Mem& mem) { Instr({ 0x0F, 0xB7 }, dst, mem); }
+            void StoreByte(const Reg src, const Mem& mem) { Instr({ 0x88 }, src, mem, false, true); }
+            void StoreByteImm(const Mem& mem, const Byte value) { Instr({ 0xC6 }, 0, mem); Emit(value); }
+            void CmpByteImm(const Mem& mem, const Byte value) { Instr({ 0x80 }, ALU_CMP, mem); Emit(value); }
+            void StoreWord(const Reg src, const Mem& mem) { Instr({ 0x89 }, src, mem, false, false, 0x66); }
+            void StoreWordImm(const Mem& mem, const Word value) { Instr({ 0xC7 }, 0, mem, false, false, 0x66); Emit16(value); }
+
+            //Jumps, return the position of the displacement to Patch()
+            size_t Jump(const Cond cond) { Emit(0x0F); Emit(0x80 | cond); Emit32(0); return Size() - 4; }
+            size_t Jump() { Emit(0xE9); Emit32(0); return Size() - 4; }
+
+            void Patch(const size_t position, const size_t target) {
+                const uint32_t displacement = static_cast<uint32_t>(target - (position + 4));
+                memcpy(m_Code.data() + position, &displacement, sizeof(displacement));
+            }
+    };
+
+    //Effective address of a memory operand, resolved at translation time as far as possible
+    struct Location {
+        const Byte* m_Read = nullptr;   //Host address of the byte (of the page when indexed), nullptr when unmapped
+        Byte* m_Write = nullptr;        //nullptr when writes are ignored (ROM)
+        bool m_Indexed = false;         //rcx holds the offset from the pointers above
+        int m_Page = -1;                //Page written to, -1 when it depends on rcx (ABX / ABY)
+        Byte m_BasePage = 0;
+    };
+
+    enum class Result : Byte {
+        UNSUPPORTED,    //Nothing usable was emitted, the block exits before the instruction
+        NEXT,           //Execution falls through to the next instruction
+        ENDED           //The instruction emitted its own exits
+    };
+
+    class Translator {
+
+        private :
+
+            Emitter m_Out;
+            const Bus& m_Bus;
+            const JitTracking& m_Tracking;
+
+            //Jumps to the epilogue
+            vector<size_t> m_Exits;
+
+            //Base cycles and instructions translated so far
+            uint32_t m_Cycles = 0;
+            uint32_t m_Count = 0;
+
+            void SetNZ(const Reg reg) {
+                m_Out.AluImm(ALU_AND, REG_P, static_cast<Byte>(~(FLAG_Z | FLAG_N)));
+                m_Out.LoadByte(R8, { RSI, reg });
+                m_Out.AluReg(ALU_OR, REG_P, R8);
+            }
+
+            void ClearFlags(const Byte flags) { m_Out.AluImm(ALU_AND, REG_P, static_cast<Byte>(~flags)); }
+
+            //Leaves the block, the PC has already been stored
+            void Leave(const uint32_t cycles, const uint32_t count) {
+                if(cycles) m_Out.AluImm(ALU_ADD, RBX, cycles);
+                m_Out.MovImm(RBP, count);
+                m_Exits.push_back(m_Out.Jump());
+            }
+
+            void Exit(const Word pc, const uint32_t cycles, const uint32_t count) {
+                m_Out.StoreWordImm({ RDI, NONE, OFF_PC }, pc);
+                Leave(cycles, count);
+            }
+
+            //The stack page must be plain RAM for pushes and pulls to be translated
+            bool HasRamStack() const {
+                const Bus::Page& page = m_Bus.GetPage(0x01);
+                return !page.m_Device && page.m_Write && page.m_Read == page.m_Write;
+            }
+
+            void Push(const Reg src) {
+                m_Out.MovPtr(RDX, m_Bus.GetPage(0x01).m_Write);
+                m_Out.LoadByte(RCX, { RDI, NONE, OFF_SP });
+                m_Out.StoreByte(src, { RDX, RCX });
+                m_Out.Dec(RCX);
+                m_Out.StoreByte(RCX, { RDI, NONE, OFF_SP });
+            }
+
+            void Pull(const Reg dst) {
+                m_Out.MovPtr(RDX, m_Bus.GetPage(0x01).m_Read);
+                m_Out.LoadByte(RCX, { RDI, NONE, OFF_SP });
+                m_Out.Inc(RCX);
+                m_Out.StoreByte(RCX, { RDI, NONE, OFF_SP });
+                m_Out.ZeroExtend(RCX, RCX);
+                m_Out.LoadByte(dst, { RDX, RCX });
+            }
+
+            //Writes to a page holding cached code are flagged like WriteTrackingBus does,
+            //and the block is left right after the instruction (see CachedCPU::Interpret)
+            void TrackWrite(const Location& location, const Word exit, const uint32_t cycles) {
+                size_t skip;
+                if(location.m_Page >= 0) {
+                    m_Out.MovPtr(RDX, m_Tracking.m_CodePages + location.m_Page);
+                    m_Out.CmpByteImm({ RDX }, 0);
+                    skip = m_Out.Jump(CC_Z);
+                    m_Out.MovPtr(RDX, m_Tracking.m_DirtyPages + location.m_Page);
+                    m_Out.StoreByteImm({ RDX }, 1);
+                }
+                else {
+                    m_Out.Shr(RCX, 8);
+                    m_Out.AluImm(ALU_ADD, RCX, location.m_BasePage);
+                    m_Out.MovPtr(RDX, m_Tracking.m_CodePages);
+                    m_Out.CmpByteImm({ RDX, RCX }, 0);
+                    skip = m_Out.Jump(CC_Z);
+                    m_Out.MovPtr(RDX, m_Tracking.m_DirtyPages);
+                    m_Out.StoreByteImm({ RDX, RCX }, 1);
+                }
+                m_Out.MovPtr(RDX, m_Tracking.m_CodeWritten);
+                m_Out.StoreByteImm({ RDX }, 1);
+                Exit(exit, cycles, m_Count + 1);
+                m_Out.Patch(skip, m_Out.Size());
+            }
+
+            //Resolves the operand of ZPG, ZPX, ZPY, ABS, ABX and ABY instructions.
+            //Indexed modes emit the computation of the offset into rcx (and of the page crossing penalty).
+            bool Locate(const JitInstruction& op, const Opcode& opcode, const bool write, Location& location) {
+                using enum AddressMode;
+
+                const address operand = op.m_Operand;
+
+                switch (opcode.m_AddrMode) {
+                    case ZPG:
+                    case ABS: {
+                        const Bus::Page& page = m_Bus.GetPage(operand.GetPage());
+                        if(page.m_Device) return false;
+                        if(page.m_Read) location.m_Read = page.m_Read + operand.GetRecord();
+                        if(page.m_Write) location.m_Write = page.m_Write + operand.GetRecord();
+                        location.m_Page = operand.GetPage();
+                        return true;
+                    }
+                    case ZPX:
+                    case ZPY: {
+                        //Never leaves the zero page
+                        const Bus::Page& page = m_Bus.GetPage(0x00);
+                        if(page.m_Device) return false;
+                        m_Out.Mov(RCX, opcode.m_AddrMode == ZPX ? REG_X : REG_Y);
+                        m_Out.AluImm(ALU_ADD, RCX, operand.GetRecord());
+                        m_Out.ZeroExtend(RCX, RCX);
+                        location = { page.m_Read, page.m_Write, true, 0 };
+                        return true;
+                    }
+                    case ABX:
+                    case ABY: {
+                        const Byte first = operand.GetPage();
+                        const Bus::Page& page = m_Bus.GetPage(first);
+                        if(page.m_Device) return false;
+                        //The index may carry into the next page : both have to be contiguous in host memory
+                        if(operand.GetRecord()) {
+                            if(first == 0xFF) return false;
+                            const Bus::Page& next = m_Bus.GetPage(first + 1);
+                            if(next.m_Device || !page.m_Read || next.m_Read != page.m_Read + 256) return false;
+                            if(write && (!page.m_Write || next.m_Write != page.m_Write + 256)) return false;
+                        }
+                        m_Out.Mov(RCX, opcode.m_AddrMode == ABX ? REG_X : REG_Y);
+                        m_Out.AluImm(ALU_ADD, RCX, operand.GetRecord());
+                        if(opcode.m_PageCross) {
+                            m_Out.Mov(R8, RCX);
+                            m_Out.Shr(R8, 8);
+                            m_Out.AluReg(ALU_ADD, RBX, R8);
+                        }
+                        location = { page.m_Read, page.m_Write, true, operand.GetRecord() ? -1 : first, first };
+                        return true;
+                    }
+                    default:
+                        return false;
+                }
+            }
+
+            //Operand value into eax
+            bool Load(const JitInstruction& op, const Opcode& opcode, Location& location) {
+                if(opcode.m_AddrMode == AddressMode::IMM) {
+                    m_Out.MovImm(RAX, m_Bus.ReadByte(op.m_Operand));
+                    return true;
+                }
+                if(!Locate(op, opcode, false, location)) return false;
+                LoadFrom(location);
+                return true;
+            }
+
+            void LoadFrom(const Location& location) {
+                //Unmapped memory reads as 0
+                if(!location.m_Read) {
+                    m_Out.AluReg(ALU_XOR, RAX, RAX);
+                    return;
+                }
+                m_Out.MovPtr(RDX, location.m_Read);
+                m_Out.LoadByte(RAX, { RDX, location.m_Indexed ? RCX : NONE });
+            }
+
+            void StoreTo(const Location& location, const Reg src, const JitInstruction& op, const uint32_t cycles) {
+                //Writes to ROM or unmapped memory are ignored
+                if(!location.m_Write) return;
+                m_Out.MovPtr(RDX, location.m_Write);
+                m_Out.StoreByte(src, { RDX, location.m_Indexed ? RCX : NONE });
+                TrackWrite(location, op.m_Next, cycles);
+            }
+
+            //A + eax + C, binary mode
+            void AddWithCarry() {
+                m_Out.Mov(RCX, REG_P);
+                m_Out.AluImm(ALU_AND, RCX, FLAG_C);
+                m_Out.Mov(R10, REG_A);
+                m_Out.AluReg(ALU_ADD, R10, RAX);
+                m_Out.AluReg(ALU_ADD, R10, RCX);
+                ClearFlags(FLAG_C | FLAG_V);
+
+                //Carry out of bit 7
+                m_Out.Mov(R11, R10);
+                m_Out.Shr(R11, 8);
+                m_Out.AluReg(ALU_OR, REG_P, R11);
+
+                //Overflow when both operands share a sign the result doesn't have
+                m_Out.Mov(R11, REG_A);
+                m_Out.AluReg(ALU_XOR, R11, RAX);
+                m_Out.Not(R11);
+                m_Out.Mov(RCX, REG_A);
+                m_Out.AluReg(ALU_XOR, RCX, R10);
+                m_Out.AluReg(ALU_AND, R11, RCX);
+                m_Out.AluImm(ALU_AND, R11, 0x80);
+                m_Out.Shr(R11, 1);
+                m_Out.AluReg(ALU_OR, REG_P, R11);
+
+                m_Out.ZeroExtend(REG_A, R10);
+                SetNZ(REG_A);
+            }
+
+            //ADC / SBC of eax in decimal mode, from the table (see CPUCore::DecimalArithmetic)
+            void DecimalArithmetic(const array<Word, DECIMAL_TABLE_SIZE>& table) {
+                //rcx = 2 * DecimalIndex(C, A, M)
+                m_Out.Mov(RCX, REG_P);
+                m_Out.AluImm(ALU_AND, RCX, FLAG_C);
+                m_Out.Shl(RCX, 8);
+                m_Out.AluReg(ALU_OR, RCX, REG_A);
+                m_Out.Shl(RCX, 8);
+                m_Out.AluReg(ALU_OR, RCX, RAX);
+                m_Out.Shl(RCX, 1);
+                m_Out.MovPtr(RDX, table.data());
+                m_Out.LoadWord(RAX, { RDX, RCX });
+
+                m_Out.ZeroExtend(REG_A, RAX);
+                m_Out.Shr(RAX, 8);
+                ClearFlags(ALU_FLAGS);
+                m_Out.AluReg(ALU_OR, REG_P, RAX);
+            }
+
+            void Compare(const Reg reg) {
+                ClearFlags(FLAG_C);
+                m_Out.Mov(RCX, reg);
+                m_Out.AluReg(ALU_SUB, RCX, RAX);
+                m_Out.SetCond(CC_NC, R8);
+                m_Out.ZeroExtend(R8, R8);
+                m_Out.AluReg(ALU_OR, REG_P, R8);
+                m_Out.ZeroExtend(RCX, RCX);
+                SetNZ(RCX);
+            }
+
+            void Bit() {
+                ClearFlags(FLAG_Z | FLAG_V | FLAG_N);
+                m_Out.Mov(R8, RAX);
+                m_Out.AluImm(ALU_AND, R8, FLAG_V | FLAG_N);
+                m_Out.AluReg(ALU_OR, REG_P, R8);
+                m_Out.Test(RAX, REG_A);
+                m_Out.SetCond(CC_Z, R8);
+                m_Out.ZeroExtend(R8, R8);
+                m_Out.Shl(R8, 1);
+                m_Out.AluReg(ALU_OR, REG_P, R8);
+            }
+
+            //Read-Modify-Write on eax, sets the flags. Leaves rcx untouched.
+            void Modify(const Instructions instruction) {
+                using enum Instructions;
+
+                switch (instruction) {
+                    case ASL:
+                    case ROL:
+                        m_Out.Mov(R9, REG_P);
+                        m_Out.AluImm(ALU_AND, R9, FLAG_C);
+                        ClearFlags(FLAG_C);
+                        m_Out.Mov(R8, RAX);
+                        m_Out.Shr(R8, 7);
+                        m_Out.AluReg(ALU_OR, REG_P, R8);
+                        m_Out.Shl(RAX, 1);
+                        if(instruction == ROL) m_Out.AluReg(ALU_OR, RAX, R9);
+                        m_Out.ZeroExtend(RAX, RAX);
+                        break;
+                    case LSR:
+                    case ROR:
+                        m_Out.Mov(R9, REG_P);
+                        m_Out.AluImm(ALU_AND, R9, FLAG_C);
+                        m_Out.Shl(R9, 7);
+                        ClearFlags(FLAG_C);
+                        m_Out.Mov(R8, RAX);
+                        m_Out.AluImm(ALU_AND, R8, 0x01);
+                        m_Out.AluReg(ALU_OR, REG_P, R8);
+                        m_Out.Shr(RAX, 1);
+                        if(instruction == ROR) m_Out.AluReg(ALU_OR, RAX, R9);
+                        break;
+                    case INC:
+                        m_Out.Inc(RAX);
+                        m_Out.ZeroExtend(RAX, RAX);
+                        break;
+                    default: //DEC
+                        m_Out.Dec(RAX);
+                        m_Out.ZeroExtend(RAX, RAX);
+                        break;
+                }
+                SetNZ(RAX);
+            }
+
+            void Branch(const JitInstruction& op, const Opcode& opcode, const Byte flag, const bool set) {
+                const uint32_t cycles = m_Cycles + opcode.m_Cycles;
+                m_Out.TestImm(REG_P, flag);
+                const size_t taken = m_Out.Jump(set ? CC_NZ : CC_Z);
+                Exit(op.m_Next, cycles, m_Count + 1);
+                m_Out.Patch(taken, m_Out.Size());
+                //1 more cycle when taken, 2 when landing on another page
+                const bool crossed = address(op.m_Next).GetPage() != address(op.m_Operand).GetPage();
+                Exit(op.m_Operand, cycles + 1 + crossed, m_Count + 1);
+            }
+
+        public :
+
+            Translator(const Bus& bus, const JitTracking& tracking) : m_Bus(bus), m_Tracking(tracking) {}
+
+            inline vector<Byte>& Code() { return m_Out.Code(); }
+
+            void Prologue() {
+                for(const Reg reg : { RBX, RBP, R12, R13, R14, R15 }) m_Out.Push(reg);
+                m_Out.LoadByte(REG_A, { RDI, NONE, OFF_ACC });
+                m_Out.LoadByte(REG_X, { RDI, NONE, OFF_X });
+                m_Out.LoadByte(REG_Y, { RDI, NONE, OFF_Y });
+                m_Out.LoadByte(REG_P, { RDI, NONE, OFF_STATUS });
+                m_Out.MovPtr(RSI, NZ_TABLE.data());
+                m_Out.AluReg(ALU_XOR, RBX, RBX);
+            }
+
+            void Epilogue() {
+                for(const size_t exit : m_Exits) m_Out.Patch(exit, m_Out.Size());
+                m_Out.StoreByte(REG_A, { RDI, NONE, OFF_ACC });
+                m_Out.StoreByte(REG_X, { RDI, NONE, OFF_X });
+                m_Out.StoreByte(REG_Y, { RDI, NONE, OFF_Y });
+                m_Out.StoreByte(REG_P, { RDI, NONE, OFF_STATUS });
+                //rax = instructions << 32 | cycles
+                m_Out.Mov(RAX, RBX);
+                m_Out.Shl64(RBP, 32);
+                m_Out.Or64(RAX, RBP);
+                for(const Reg reg : { R15, R14, R13, R12, RBP, RBX }) m_Out.Pop(reg);
+                m_Out.Ret();
+            }
+
+            //Leaves the block at pc, with everything translated so far executed
+            void ExitAt(const Word pc) { Exit(pc, m_Cycles, m_Count); }
+
+            Result Translate(const JitInstruction& op) {
+                using enum Instructions;
+
+                const Opcode& opcode = OPCODES[op.m_Code];
+                const uint32_t cycles = m_Cycles + opcode.m_Cycles;
+                const size_t mark = m_Out.Size();
+                const size_t exits = m_Exits.size();
+
+                auto unsupported = [&]() {
+                    m_Out.Truncate(mark);
+                    m_Exits.resize(exits);
+                    return Result::UNSUPPORTED;
+                };
+
+                //Implied and Accumulator modes latch the accumulator (see CPUCore::Resolve)
+                if(opcode.m_AddrMode == AddressMode::IMP || opcode.m_AddrMode == AddressMode::ACC)
+                    m_Out.StoreByte(REG_A, { RDI, NONE, OFF_OPVALUE });
+
+                Location location;
+                Result result = Result::NEXT;
+
+                switch (opcode.m_Instruction) {
+
+                    case LDA:
+                    case LDX:
+                    case LDY: {
+                        if(!Load(op, opcode, location)) return unsupported();
+                        const Reg reg = opcode.m_Instruction == LDA ? REG_A : opcode.m_Instruction == LDX ? REG_X : REG_Y;
+                        m_Out.Mov(reg, RAX);
+                        SetNZ(reg);
+                        break;
+                    }
+
+                    case STA:
+                    case STX:
+                    case STY:
+                        if(!Locate(op, opcode, true, location)) return unsupported();
+                        StoreTo(location, opcode.m_Instruction == STA ? REG_A : opcode.m_Instruction == STX ? REG_X : REG_Y, op, cycles);
+                        break;
+
+                    case AND:
+                    case ORA:
+                    case EOR:
+                        if(!Load(op, opcode, location)) return unsupported();
+                        m_Out.AluReg(opcode.m_Instruction == AND ? ALU_AND : opcode.m_Instruction == ORA ? ALU_OR : ALU_XOR, REG_A, RAX);
+                        SetNZ(REG_A);
+                        break;
+
+                    case ADC:
+                    case SBC: {
+                        if(!Load(op, opcode, location)) return unsupported();
+                        m_Out.TestImm(REG_P, FLAG_D);
+                        const size_t decimal = m_Out.Jump(CC_NZ);
+                        //Binary substraction is an addition of the one's complement
+                        if(opcode.m_Instruction == SBC) m_Out.AluImm(ALU_XOR, RAX, 0xFF);
+                        AddWithCarry();
+                        const size_t done = m_Out.Jump();
+                        m_Out.Patch(decimal, m_Out.Size());
+                        DecimalArithmetic(opcode.m_Instruction == ADC ? ADC_DECIMAL : SBC_DECIMAL);
+                        m_Out.Patch(done, m_Out.Size());
+                        break;
+                    }
+
+                    case CMP:
+                    case CPX:
+                    case CPY:
+                        if(!Load(op, opcode, location)) return unsupported();
+                        Compare(opcode.m_Instruction == CMP ? REG_A : opcode.m_Instruction == CPX ? REG_X : REG_Y);
+                        break;
+
+                    case BIT:
+                        if(!Load(op, opcode, location)) return unsupported();
+                        Bit();
+                        break;
+
+                    case ASL:
+                    case LSR:
+                    case ROL:
+                    case ROR:
+                    case INC:
+                    case DEC:
+                        if(opcode.m_AddrMode == AddressMode::ACC) {
+                            m_Out.Mov(RAX, REG_A);
+                            Modify(opcode.m_Instruction);
+                            m_Out.Mov(REG_A, RAX);
+                            break;
+                        }
+                        if(!Locate(op, opcode, true, location)) return unsupported();
+                        LoadFrom(location);
+                        Modify(opcode.m_Instruction);
+                        StoreTo(location, RAX, op, cycles);
+                        break;
+
+                    case INX:
+                    case INY:
+                    case DEX:
+                    case DEY: {
+                        const Reg reg = (opcode.m_Instruction == INX || opcode.m_Instruction == DEX) ? REG_X : REG_Y;
+                        if(opcode.m_Instruction == INX || opcode.m_Instruction == INY) m_Out.Inc(reg);
+                        else m_Out.Dec(reg);
+                        m_Out.ZeroExtend(reg, reg);
+                        SetNZ(reg);
+                        break;
+                    }
+
+                    case TAX: m_Out.Mov(REG_X, REG_A); SetNZ(REG_X); break;
+                    case TAY: m_Out.Mov(REG_Y, REG_A); SetNZ(REG_Y); break;
+                    case TXA: m_Out.Mov(REG_A, REG_X); SetNZ(REG_A); break;
+                    case TYA: m_Out.Mov(REG_A, REG_Y); SetNZ(REG_A); break;
+                    case TSX: m_Out.LoadByte(REG_X, { RDI, NONE, OFF_SP }); SetNZ(REG_X); break;
+                    case TXS: m_Out.StoreByte(REG_X, { RDI, NONE, OFF_SP }); break;
+
+                    case CLC: ClearFlags(FLAG_C); break;
+                    case SEC: m_Out.AluImm(ALU_OR, REG_P, FLAG_C); break;
+                    case CLD: ClearFlags(static_cast<Byte>(StatusFlag::DECIMAL)); break;
+                    case SED: m_Out.AluImm(ALU_OR, REG_P, static_cast<Byte>(StatusFlag::DECIMAL)); break;
+                    case CLI: ClearFlags(static_cast<Byte>(StatusFlag::INTERRUPT)); break;
+                    case SEI: m_Out.AluImm(ALU_OR, REG_P, static_cast<Byte>(StatusFlag::INTERRUPT)); break;
+                    case CLV: ClearFlags(FLAG_V); break;
+
+                    case NOP: break;
+
+                    case PHA:
+                    case PHP:
+                        if(!HasRamStack()) return unsupported();
+                        m_Out.Mov(RAX, opcode.m_Instruction == PHA ? REG_A : REG_P);
+                        if(opcode.m_Instruction == PHP) m_Out.AluImm(ALU_OR, RAX, FLAG_B | FLAG_U);
+                        Push(RAX);
+                        TrackWrite({ nullptr, nullptr, false, 0x01 }, op.m_Next, cycles);
+                        break;
+
+                    case PLA:
+                        if(!HasRamStack()) return unsupported();
+                        Pull(REG_A);
+                        SetNZ(REG_A);
+                        break;
+
+                    case PLP:
+                        if(!HasRamStack()) return unsupported();
+                        Pull(RAX);
+                        m_Out.AluImm(ALU_AND, RAX, static_cast<Byte>(~FLAG_B));
+                        m_Out.AluImm(ALU_OR, RAX, FLAG_U);
+                        m_Out.Mov(REG_P, RAX);
+                        break;
+
+                    case BCC: Branch(op, opcode, FLAG_C, false); result = Result::ENDED; break;
+                    case BCS: Branch(op, opcode, FLAG_C, true); result = Result::ENDED; break;
+                    case BNE: Branch(op, opcode, FLAG_Z, false); result = Result::ENDED; break;
+                    case BEQ: Branch(op, opcode, FLAG_Z, true); result = Result::ENDED; break;
+                    case BPL: Branch(op, opcode, FLAG_N, false); result = Result::ENDED; break;
+                    case BMI: Branch(op, opcode, FLAG_N, true); result = Result::ENDED; break;
+                    case BVC: Branch(op, opcode, FLAG_V, false); result = Result::ENDED; break;
+                    case BVS: Branch(op, opcode, FLAG_V, true); result = Result::ENDED; break;
+
+                    case JMP:
+                        //JMP (ind) reads its target from memory : left to the interpreter
+                        if(opcode.m_AddrMode != AddressMode::ABS) return unsupported();
+                        Exit(op.m_Operand, cycles, m_Count + 1);
+                        result = Result::ENDED;
+                        break;
+
+                    case JSR: {
+                        if(!HasRamStack()) return unsupported();
+                        //Pushes the address of the last byte of the JSR instruction
+                        const Word ret = op.m_Next - 1;
+                        m_Out.MovImm(RAX, ret >> 8);
+                        Push(RAX);
+                        m_Out.MovImm(RAX, ret & 0xFF);
+                        Push(RAX);
+                        TrackWrite({ nullptr, nullptr, false, 0x01 }, op.m_Operand, cycles);
+                        Exit(op.m_Operand, cycles, m_Count + 1);
+                        result = Result::ENDED;
+                        break;
+                    }
+
+                    case RTS:
+                        if(!HasRamStack()) return unsupported();
+                        Pull(RAX);
+                        Pull(R9);
+                        m_Out.Shl(R9, 8);
+                        m_Out.AluReg(ALU_OR, RAX, R9);
+                        m_Out.Inc(RAX);
+                        m_Out.StoreWord(RAX, { RDI, NONE, OFF_PC });
+                        Leave(cycles, m_Count + 1);
+                        result = Result::ENDED;
+                        break;
+
+                    //BRK, RTI (interrupts), indirect jumps and undocumented opcodes
+                    default:
+                        return unsupported();
+                }
+
+                m_Cycles = cycles;
+                m_Count++;
+                return result;
+            }
+    };
+}
+
+    vector<Byte> TranslateBlock( const vector<JitInstruction>& ops, const Bus& bus, const JitTracking& tracking, uint32_t& translated ) {
+        translated = 0;
+        if(ops.empty()) return {};
+
+        Translator translator(bus, tracking);
+        translator.Prologue();
+
+        for(size_t i = 0; i < ops.size(); i++) {
+            const Result result = translator.Translate(ops[i]);
+            if(result == Result::UNSUPPORTED) {
+                if(i == 0) return {};
+                translator.ExitAt(ops[i - 1].m_Next);
+                break;
+            }
+            translated++;
+            if(result == Result::ENDED) break;
+            if(i + 1 == ops.size()) translator.ExitAt(ops[i].m_Next);
+        }
+
+        translator.Epilogue();
+        return std::move(translator.Code());
+    }
+
+#else
+
+    //Other hosts : no executable memory, JitCPU runs the interpreter
+
+    ExecutableMemory::ExecutableMemory(const size_t size) {}
+    ExecutableMemory::~ExecutableMemory() {}
+    void* ExecutableMemory::Commit(const vector<Byte>& code) { return nullptr; }
+
+    vector<Byte> TranslateBlock( const vector<JitInstruction>& ops, const Bus& bus, const JitTracking& tracking, uint32_t& translated ) {
+        translated = 0;
+        return {};
+    }
+
+#endif
+
+    bool JitCPU::Compile(Block& block) {
+        //Busy-waits stay interpreted : their iterations get skipped rather than run (see CPUCore::WatchIdleLoop).
+        //Only the ones seen spinning : a counting loop has the same shape, and is worth translating.
+        const MicroOp& last = block.m_Ops.back();
+        const Word end = last.m_Next - 1 - OperandSize(OPCODES[last.m_Code].m_AddrMode);
+        if(m_IdleLoop.m_Confirmed && m_IdleLoop.m_Start == block.m_Start && m_IdleLoop.m_End == end) {
+            block.m_NativeFailed = true;
+            return false;
+        }
+
+        vector<JitInstruction> ops;
+        ops.reserve(block.m_Ops.size());
+        for(const MicroOp& op : block.m_Ops) ops.push_back({ op.m_Code, op.m_Operand, op.m_Next });
+
+        uint32_t translated = 0;
+        const vector<Byte> code = TranslateBlock(ops, Tracker().GetTarget(), { CodePages(), DirtyPages(), CodeWritten() }, translated);
+        if(code.empty()) {
+            block.m_NativeFailed = true;
+            return false;
+        }
+
+        void* entry = m_Code.Commit(code);
+        //Out of executable memory : start over, every block gets translated again
+        if(!entry) {
+            m_Code.Reset();
+            Invalidate();
+            return false;
+        }
+
+        block.m_Native = entry;
+        block.m_NativeOps = translated;
+        return true;
+    }
+
+    uint64_t JitCPU::Run(uint64_t instructions) {
+        if(m_Mode == ExecutionMode::INTERPRETER || !m_Code.IsAvailable()) return CachedCPU<Bus>::Run(instructions);
+
+        const uint64_t start = m_Cycles;
+        m_IdleArmed = false;
+        for(;;) {
+            if(m_IdleSkip) instructions -= SkipIdle(GetNextDeadline(), instructions);
+            //Interrupts and events are looked at between blocks
+            if(m_Cycles >= m_SliceEnd) Poll();
+            if(!instructions || m_Halted) break;
+
+            Block* block = Lookup(m_PC);
+            //Uncacheable code is interpreted
+            if(!block) {
+                m_Cycles += Dispatch();
+                instructions--;
+                continue;
+            }
+
+            //A failed compilation may have dropped the block
+            if(!block->m_Native && !block->m_NativeFailed && ++block->m_Visits >= HOT_THRESHOLD && !Compile(*block))
+                continue;
+
+            //The native code can't stop before its end : near the instruction budget, the block is interpreted
+            if(block->m_Native && block->m_NativeOps <= instructions) {
+                //The native code works on the packed status byte
+                m_CpuStatus = GetStatus();
+                const uint64_t result = reinterpret_cast<NativeBlock>(block->m_Native)(this);
+                SetStatus(m_CpuStatus);
+                m_Cycles += static_cast<uint32_t>(result);
+                instructions -= result >> 32;
+                //A CLI / PLP in the block may have unmasked an IRQ held : polled before the next block
+                if(m_IrqLines && !HasStatusFlag(StatusFlag::INTERRUPT)) Attention();
+                continue;
+            }
+
+            m_Cycles += Interpret(*block, instructions);
+        }
+        return m_Cycles - start;
+    }
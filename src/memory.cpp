@@ -0,0 +1,57 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+    Memory::Memory(const size_t size) : m_Size(size), m_Data(size, 0), m_Dirty((size + PAGE_SIZE - 1) / PAGE_SIZE, 0) {}
+
+    IODevice::io_ptr Memory::Make(const size_t size) {
+        return make_shared<Memory>(size);
+    }
+
+    void Memory::ReadBytes(const address& addr, span<Byte> bytes) const {
+        const size_t start = addr.GetValue();
+        const size_t count = start < m_Size ? std::min(bytes.size(), m_Size - start) : 0;
+        std::copy_n(m_Data.data() + std::min(start, m_Size), count, bytes.begin());
+        std::fill(bytes.begin() + count, bytes.end(), 0);
+    }
+
+    void Memory::WriteBytes(const address& addr, span<const Byte> bytes) {
+        const size_t start = addr.GetValue();
+        if(start >= m_Size) return;
+        const size_t count = std::min(bytes.size(), m_Size - start);
+        std::copy_n(bytes.begin(), count, m_Data.begin() + start);
+        if(count) MarkDirty(start / PAGE_SIZE, (start + count - 1) / PAGE_SIZE - start / PAGE_SIZE + 1);
+    }
+
+    void Memory::MarkDirty(const size_t page, const size_t count) {
+        const size_t end = std::min(page + count, m_Dirty.size());
+        for(size_t i = page; i < end; i++) Touch(i * PAGE_SIZE);
+    }
+
+    void Memory::ClearDirty() {
+        for(const size_t page : m_DirtyPages) m_Dirty[page] = 0;
+        m_DirtyPages.clear();
+    }
+
+    Memory::snapshot_ptr Memory::Snapshot() {
+        if(!m_Base || !m_DirtyPages.empty()) m_Base = make_shared<const memory>(m_Data);
+        ClearDirty();
+        return m_Base;
+    }
+
+    void Memory::Restore(const snapshot_ptr& snapshot) {
+        if(!snapshot || snapshot->size() != m_Size) throw invalid_argument("Snapshot of another memory size");
+
+        if(snapshot == m_Base) {
+            for(const size_t page : m_DirtyPages) {
+                const size_t start = page * PAGE_SIZE;
+                std::copy_n(snapshot->begin() + start, std::min(PAGE_SIZE, m_Size - start), m_Data.begin() + start);
+            }
+        }
+        else {
+            std::copy(snapshot->begin(), snapshot->end(), m_Data.begin());
+            m_Base = snapshot;
+        }
+        ClearDirty();
+    }
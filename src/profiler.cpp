@@ -0,0 +1,115 @@
+#include "profiler.h"
+
+#include <iomanip>
+
+namespace {
+
+    //"0x1F"
+    struct Hex {
+        unsigned m_Value;
+        int m_Digits;
+    };
+
+    ostream& operator<<(ostream& os, const Hex& hex) {
+        const ios::fmtflags flags = os.flags();
+        os << "\"0x" << std::hex << uppercase << setfill('0') << setw(hex.m_Digits) << hex.m_Value << '"';
+        os.flags(flags);
+        return os;
+    }
+}
+
+    uint64_t Profiler::GetInstructionCount() const {
+        uint64_t count = 0;
+        for(const OpcodeCounters& counters : m_Opcodes) count += counters.m_Count;
+        return count;
+    }
+
+    uint64_t Profiler::GetCycleCount() const {
+        uint64_t cycles = 0;
+        for(const OpcodeCounters& counters : m_Opcodes) cycles += counters.m_Cycles;
+        return cycles;
+    }
+
+    void Profiler::Reset() {
+        m_Opcodes.fill({});
+        m_Pages.fill({});
+        m_IndexedPageCrossings = 0;
+        m_BranchesTaken = 0;
+        m_BranchPageCrossings = 0;
+        m_ZeroPageWraps = 0;
+    }
+
+    void Profiler::Dump(ostream& json) const {
+        //Per addressing mode and per instruction, summed from the opcodes
+        array<OpcodeCounters, ADDRESS_MODE_COUNT> modes {};
+        array<OpcodeCounters, INSTRUCTION_COUNT> instructions {};
+        for(size_t code = 0; code < 256; code++) {
+            const OpcodeCounters& counters = m_Opcodes[code];
+            for(OpcodeCounters* total : { &modes[static_cast<size_t>(OPCODES[code].m_AddrMode)], &instructions[static_cast<size_t>(OPCODES[code].m_Instruction)] }) {
+                total->m_Count += counters.m_Count;
+                total->m_Cycles += counters.m_Cycles;
+                total->m_Penalties += counters.m_Penalties;
+            }
+        }
+
+        auto counters = [&json](const OpcodeCounters& counters) {
+            json << "\"count\": " << counters.m_Count << ", \"cycles\": " << counters.m_Cycles << ", \"penalties\": " << counters.m_Penalties;
+        };
+
+        json << "{\n";
+        json << "  \"instructions\": " << GetInstructionCount() << ",\n";
+        json << "  \"cycles\": " << GetCycleCount() << ",\n";
+
+        json << "  \"opcodes\": [";
+        const char* separator = "\n";
+        for(size_t code = 0; code < 256; code++) {
+            if(!m_Opcodes[code].m_Count) continue;
+            const Opcode& opcode = OPCODES[code];
+            json << separator << "    { \"opcode\": " << Hex { static_cast<unsigned>(code), 2 }
+                 << ", \"instruction\": \"" << INSTRUCTION_NAMES[static_cast<size_t>(opcode.m_Instruction)]
+                 << "\", \"mode\": \"" << ADDRESS_MODE_NAMES[static_cast<size_t>(opcode.m_AddrMode)] << "\", ";
+            counters(m_Opcodes[code]);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  ],\n";
+
+        json << "  \"instruction_counts\": {";
+        separator = "\n";
+        for(size_t i = 0; i < INSTRUCTION_COUNT; i++) {
+            if(!instructions[i].m_Count) continue;
+            json << separator << "    \"" << INSTRUCTION_NAMES[i] << "\": { ";
+            counters(instructions[i]);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  },\n";
+
+        json << "  \"address_modes\": {";
+        separator = "\n";
+        for(size_t i = 0; i < ADDRESS_MODE_COUNT; i++) {
+            if(!modes[i].m_Count) continue;
+            json << separator << "    \"" << ADDRESS_MODE_NAMES[i] << "\": { ";
+            counters(modes[i]);
+            json << " }";
+            separator = ",\n";
+        }
+        json << "\n  },\n";
+
+        json << "  \"pages\": [";
+        separator = "\n";
+        for(size_t page = 0; page < 256; page++) {
+            const PageCounters& counters = m_Pages[page];
+            if(!counters.m_Instructions && !counters.m_Reads && !counters.m_Writes) continue;
+            json << separator << "    { \"page\": " << Hex { static_cast<unsigned>(page), 2 }
+                 << ", \"instructions\": " << counters.m_Instructions << ", \"cycles\": " << counters.m_Cycles
+                 << ", \"reads\": " << counters.m_Reads << ", \"writes\": " << counters.m_Writes << " }";
+            separator = ",\n";
+        }
+        json << "\n  ],\n";
+
+        json << "  \"page_crossings\": { \"indexed\": " << m_IndexedPageCrossings << ", \"branches\": " << m_BranchPageCrossings
+             << ", \"zero_page_wraps\": " << m_ZeroPageWraps << " },\n";
+        json << "  \"branches_taken\": " << m_BranchesTaken << "\n";
+        json << "}\n";
+    }
@@ -0,0 +1,143 @@
+#include "recompiler.h"
+#include "aot.h"
+
+#include <stdexcept>
+
+    Recompiler::Recompiler(vector<Byte> image, const Word base) : m_Image(std::move(image)), m_Base(base) {
+        if(m_Image.empty() || base + m_Image.size() > 0x10000) throw out_of_range("Image doesn't fit in the address space");
+    }
+
+    void Recompiler::AddEntryPoint(const Word addr) {
+        if(!Contains(addr)) throw out_of_range("Entry point outside of the image");
+        m_EntryPoints.insert(addr);
+    }
+
+    void Recompiler::AddVectors() {
+        for(const Word vector : { 0xFFFA, 0xFFFC, 0xFFFE }) {
+            if(!Contains(vector, 2)) continue;
+            const Word target = MAKE_WORD(At(vector + 1), At(vector));
+            if(Contains(target)) m_EntryPoints.insert(target);
+        }
+    }
+
+    bool Recompiler::Decode(const Word addr, Instruction& instruction) const {
+        if(!Contains(addr)) return false;
+
+        const Byte code = At(addr);
+        const Opcode& opcode = OPCODES[code];
+        const Byte size = OperandSize(opcode.m_AddrMode);
+        if(opcode.m_Instruction == Instructions::ILL || !Contains(addr, 1 + size)) return false;
+
+        const Word next = addr + 1 + size;
+
+        //Implied and Immediate : the operand is the address following the opcode
+        Word operand = addr + 1;
+        if(opcode.m_AddrMode == AddressMode::REL) operand = next + static_cast<signed char>(At(addr + 1));
+        else if(opcode.m_AddrMode != AddressMode::IMM && size == 1) operand = At(addr + 1);
+        else if(size == 2) operand = MAKE_WORD(At(addr + 2), At(addr + 1));
+
+        instruction = { addr, code, operand, next };
+        return true;
+    }
+
+    void Recompiler::Analyze() {
+        m_Blocks.clear();
+
+        //First pass : every reachable instruction, and where the blocks start
+        map<Word, Instruction> code;
+        set<Word> leaders = m_EntryPoints;
+        vector<Word> pending(m_EntryPoints.begin(), m_EntryPoints.end());
+
+        auto follow = [&](const Word target, const bool leader) {
+            if(!Contains(target)) return;
+            if(leader) leaders.insert(target);
+            if(!code.count(target)) pending.push_back(target);
+        };
+
+        while(!pending.empty()) {
+            const Word addr = pending.back();
+            pending.pop_back();
+
+            Instruction instruction;
+            if(code.count(addr) || !Decode(addr, instruction)) continue;
+            code[addr] = instruction;
+
+            const Opcode& opcode = OPCODES[instruction.m_Code];
+            if(!IsControlFlow(opcode.m_Instruction)) {
+                follow(instruction.m_Next, false);
+                continue;
+            }
+
+            switch (opcode.m_Instruction) {
+                case Instructions::JMP:
+                    if(opcode.m_AddrMode == AddressMode::ABS) follow(instruction.m_Operand, true);
+                    break;
+                //Subroutines are expected to return right after the JSR
+                case Instructions::JSR:
+                    follow(instruction.m_Operand, true);
+                    follow(instruction.m_Next, true);
+                    break;
+                case Instructions::RTS:
+                case Instructions::RTI:
+                case Instructions::BRK:
+                    break;
+                default: //Branches
+                    follow(instruction.m_Operand, true);
+                    follow(instruction.m_Next, true);
+                    break;
+            }
+        }
+
+        //Second pass : the blocks, from each leader to the next control flow instruction or leader
+        for(const Word start : leaders) {
+            Block block { start, {} };
+            auto it = code.find(start);
+            while(it != code.end()) {
+                const Instruction& instruction = it->second;
+                block.m_Instructions.push_back(instruction);
+                if(IsControlFlow(OPCODES[instruction.m_Code].m_Instruction) || leaders.count(instruction.m_Next)) break;
+                it = code.find(instruction.m_Next);
+            }
+            if(!block.m_Instructions.empty()) m_Blocks[start] = std::move(block);
+        }
+    }
+
+    static string Hex(const uint64_t value, const int digits) {
+        static const char* DIGITS = "0123456789ABCDEF";
+        string text(digits, '0');
+        for(int i = 0; i < digits; i++) text[digits - 1 - i] = DIGITS[(value >> (i * 4)) & 0xF];
+        return text;
+    }
+
+    void Recompiler::Emit(ostream& os, const string& name, const string& bus) const {
+        const string cpu = "AotCPU<" + bus + ">";
+
+        os << "//Generated by emu6502-aot, do not edit.\n"
+           << "//Image : $" << Hex(m_Base, 4) << " - $" << Hex(m_Base + m_Image.size() - 1, 4)
+           << ", " << m_Blocks.size() << " blocks\n"
+           << "//Use : extern const AotProgram<" << bus << "> " << name << "; then AotCPU<" << bus << ">::Load(" << name << ")\n\n"
+           << "#include <aot.h>\n"
+           << "#include <bus.h>\n\n"
+           << "namespace {\n";
+
+        for(const auto& [start, block] : m_Blocks) {
+            os << "\n    uint64_t Block_" << Hex(start, 4) << "(" << cpu << "& cpu) {\n"
+               << "        uint64_t cycles = 0;\n";
+            for(const Instruction& instruction : block.m_Instructions)
+                os << "        cycles += cpu.RunOpcode<0x" << Hex(instruction.m_Code, 2) << ">(0x" << Hex(instruction.m_Operand, 4)
+                   << ", 0x" << Hex(instruction.m_Next, 4) << ");    //$" << Hex(instruction.m_Address, 4) << "\n";
+            os << "        return cycles;\n"
+               << "    }\n";
+        }
+
+        if(!m_Blocks.empty()) {
+            os << "\n    const AotBlock<" << bus << "> BLOCKS[] = {\n";
+            for(const auto& [start, block] : m_Blocks)
+                os << "        { 0x" << Hex(start, 4) << ", " << block.m_Instructions.size() << ", &Block_" << Hex(start, 4) << " },\n";
+            os << "    };\n";
+        }
+        os << "}\n\n"
+           << "extern const AotProgram<" << bus << "> " << name << ";\n"
+           << "const AotProgram<" << bus << "> " << name << " = { 0x" << Hex(m_Base, 4) << ", " << m_Image.size()
+           << ", 0x" << Hex(HashImage(m_Image.data(), m_Image.size()), 16) << "ull, " << (m_Blocks.empty() ? "nullptr" : "BLOCKS") << ", " << m_Blocks.size() << " };\n";
+    }
@@ -0,0 +1,135 @@
+#include "rom.h"
+#include "bus.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define EMU6502_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+    shared_ptr<Rom> Rom::Open(const string& path) {
+        auto rom = make_shared<Rom>();
+
+#ifdef EMU6502_MMAP
+        const int file = open(path.c_str(), O_RDONLY);
+        if(file < 0) throw runtime_error("Can't open " + path);
+
+        struct stat info;
+        if(fstat(file, &info) != 0) {
+            close(file);
+            throw runtime_error("Can't stat " + path);
+        }
+
+        rom->m_Size = info.st_size;
+        if(rom->m_Size) {
+            void* mapping = mmap(nullptr, rom->m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+            if(mapping == MAP_FAILED) {
+                close(file);
+                throw runtime_error("Can't map " + path);
+            }
+            rom->m_Mapping = mapping;
+            rom->m_MappingSize = rom->m_Size;
+            rom->m_Data = static_cast<const Byte*>(mapping);
+        }
+        //The mapping stays valid once the file is closed
+        close(file);
+#else
+        ifstream file(path, ios::binary);
+        if(!file) throw runtime_error("Can't open " + path);
+        rom->m_Copy.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        rom->m_Data = rom->m_Copy.data();
+        rom->m_Size = rom->m_Copy.size();
+#endif
+        return rom;
+    }
+
+    shared_ptr<Rom> Rom::Make(span<const Byte> bytes) {
+        auto rom = make_shared<Rom>();
+        rom->m_Copy.assign(bytes.begin(), bytes.end());
+        rom->m_Data = rom->m_Copy.data();
+        rom->m_Size = rom->m_Copy.size();
+        return rom;
+    }
+
+    Rom::~Rom() {
+#ifdef EMU6502_MMAP
+        if(m_Mapping) munmap(m_Mapping, m_MappingSize);
+#endif
+    }
+
+    void Rom::ReadBytes(const address& addr, span<Byte> bytes) const {
+        const size_t start = addr.GetValue();
+        const size_t count = start < m_Size ? std::min(bytes.size(), m_Size - start) : 0;
+        std::copy_n(m_Data + std::min(start, m_Size), count, bytes.begin());
+        std::fill(bytes.begin() + count, bytes.end(), 0);
+    }
+
+    static constexpr size_t PAGE_SIZE = 256;
+    static constexpr size_t NES_HEADER_SIZE = 16;
+    static constexpr size_t NES_TRAINER_SIZE = 512;
+    static constexpr size_t NES_BANK_SIZE = 0x4000;
+
+    static void CheckSegment(const Rom& rom, const Program::Segment& segment) {
+        if(segment.m_Offset + segment.m_Size > rom.GetSize()) throw out_of_range("Segment past the end of the image");
+        if(segment.m_Base + segment.m_Size > 0x10000) throw out_of_range("Segment doesn't fit in the address space");
+    }
+
+    Program Program::Binary(const string& path, const Word base) {
+        Program program { Rom::Open(path), {} };
+        program.m_Segments.push_back({ 0, program.m_Rom->GetSize(), base });
+        CheckSegment(*program.m_Rom, program.m_Segments.back());
+        return program;
+    }
+
+    Program Program::Prg(const string& path) {
+        Program program { Rom::Open(path), {} };
+        const Rom& rom = *program.m_Rom;
+        if(rom.GetSize() < 2) throw invalid_argument(path + " : missing load address");
+
+        program.m_Segments.push_back({ 2, rom.GetSize() - 2, rom.ReadWord(0) });
+        CheckSegment(rom, program.m_Segments.back());
+        return program;
+    }
+
+    Program Program::Nes(const string& path) {
+        Program program { Rom::Open(path), {} };
+        const Rom& rom = *program.m_Rom;
+        if(rom.GetSize() < NES_HEADER_SIZE || rom.ReadByte(0) != 'N' || rom.ReadByte(1) != 'E' || rom.ReadByte(2) != 'S' || rom.ReadByte(3) != 0x1A)
+            throw invalid_argument(path + " : not an iNES image");
+
+        const size_t banks = rom.ReadByte(4);
+        const bool trainer = rom.ReadByte(6) & 0x04;
+        if(!banks) throw invalid_argument(path + " : no PRG-ROM");
+
+        const size_t prg = NES_HEADER_SIZE + (trainer ? NES_TRAINER_SIZE : 0);
+        const size_t last = prg + (banks - 1) * NES_BANK_SIZE;
+        program.m_Segments.push_back({ prg, NES_BANK_SIZE, 0x8000 });
+        program.m_Segments.push_back({ last, NES_BANK_SIZE, 0xC000 });
+        for(const Segment& segment : program.m_Segments) CheckSegment(rom, segment);
+        return program;
+    }
+
+    void Program::Map(Bus& bus) const {
+        for(const Segment& segment : m_Segments) {
+            size_t mapped = 0;
+            if(segment.m_Base % PAGE_SIZE == 0) {
+                const size_t pages = segment.m_Size / PAGE_SIZE;
+                if(pages) bus.MapRom(segment.m_Base / PAGE_SIZE, pages, m_Rom, segment.m_Offset);
+                mapped = pages * PAGE_SIZE;
+            }
+            if(mapped < segment.m_Size)
+                bus.WriteBytes(segment.m_Base + mapped, m_Rom->GetBytes().subspan(segment.m_Offset + mapped, segment.m_Size - mapped));
+        }
+    }
+
+    void Program::Load(IODevice& device) const {
+        for(const Segment& segment : m_Segments)
+            device.WriteBytes(segment.m_Base, m_Rom->GetBytes().subspan(segment.m_Offset, segment.m_Size));
+    }
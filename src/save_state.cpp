@@ -0,0 +1,233 @@
+#include "save_state.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+    constexpr size_t PAGE_SIZE = 256;
+
+    enum : Byte {
+        HALTED = 1 << 0,
+        NMI_PENDING = 1 << 1,
+        RESET_PENDING = 1 << 2
+    };
+
+    inline uint32_t Checksum(const vector<Byte>& payload) {
+        return static_cast<uint32_t>(HashImage(payload.data(), payload.size()));
+    }
+
+    //Runs of (unchanged, stored) counts, then the stored bytes, until the page is covered.
+    //A lone unchanged byte between two changed ones is stored : cheaper than starting a new run.
+    void EncodePage(span<const Byte> page, span<const Byte> base, StateWriter& out) {
+        const size_t size = page.size();
+        size_t i = 0;
+        while(i < size) {
+            Byte skip = 0;
+            while(i < size && skip < 255 && page[i] == base[i]) {
+                skip++;
+                i++;
+            }
+
+            const size_t start = i;
+            Byte count = 0;
+            while(i < size && count < 255) {
+                if(page[i] == base[i] && (i + 1 >= size || page[i + 1] == base[i + 1])) break;
+                count++;
+                i++;
+            }
+
+            out.Write(skip);
+            out.Write(count);
+            out.WriteBytes(page.subspan(start, count));
+        }
+    }
+
+    void DecodePage(span<Byte> page, StateReader& in) {
+        size_t i = 0;
+        while(i < page.size()) {
+            i += in.Read();
+            const Byte count = in.Read();
+            if(i + count > page.size()) throw runtime_error("Corrupted save state page");
+            in.ReadBytes(page.subspan(i, count));
+            i += count;
+        }
+    }
+
+    inline span<const Byte> Page(const vector<Byte>& memory, const size_t page) {
+        const size_t start = page * PAGE_SIZE;
+        return span<const Byte>(memory).subspan(start, min(PAGE_SIZE, memory.size() - start));
+    }
+}
+
+    void StateReader::ReadBytes(span<Byte> bytes) {
+        if(m_In.size() - m_Position < bytes.size()) throw runtime_error("Truncated state");
+        copy_n(m_In.begin() + m_Position, bytes.size(), bytes.begin());
+        m_Position += bytes.size();
+    }
+
+    uint64_t StateReader::ReadInt(const size_t size) {
+        if(m_In.size() - m_Position < size) throw runtime_error("Truncated state");
+        uint64_t value = 0;
+        for(size_t i = 0; i < size; i++) value |= static_cast<uint64_t>(m_In[m_Position + i]) << (8 * i);
+        m_Position += size;
+        return value;
+    }
+
+    SaveStateWriter::SaveStateWriter(ostream& out, const size_t keyframeInterval)
+        : m_Out(out), m_KeyframeInterval(max<size_t>(keyframeInterval, 1)) {
+        m_Out.write(SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC));
+        m_Out.put(static_cast<char>(SAVE_STATE_VERSION));
+        if(!m_Out) throw runtime_error("Can't write the save state");
+    }
+
+    void SaveStateWriter::Write(const MachineState& state) {
+        const bool keyframe = !m_Count || m_SinceKeyframe >= m_KeyframeInterval
+                           || state.m_Memory.size() != m_Previous.m_Memory.size()
+                           || state.m_Devices.size() != m_Previous.m_Devices.size();
+
+        m_Payload.clear();
+        StateWriter out(m_Payload);
+
+        const Registers& registers = state.m_Registers;
+        out.WriteWord(registers.m_PC);
+        out.Write(registers.m_SP);
+        out.Write(registers.m_Acc);
+        out.Write(registers.m_X);
+        out.Write(registers.m_Y);
+        out.Write(registers.m_CpuStatus.m_Value);
+        out.Write(registers.m_OpValue);
+        out.Write((state.m_Halted ? HALTED : 0) | (state.m_NmiPending ? NMI_PENDING : 0) | (state.m_ResetPending ? RESET_PENDING : 0));
+        out.Write32(state.m_IrqLines);
+        out.Write64(state.m_Cycles);
+
+        //Pages, against zeros or the previous state
+        static const array<Byte, PAGE_SIZE> ZEROS {};
+        vector<size_t> pages;
+        const size_t pageCount = (state.m_Memory.size() + PAGE_SIZE - 1) / PAGE_SIZE;
+        for(size_t page = 0; page < pageCount; page++) {
+            const span<const Byte> current = Page(state.m_Memory, page);
+            const span<const Byte> base = keyframe ? span<const Byte>(ZEROS).first(current.size()) : Page(m_Previous.m_Memory, page);
+            if(!equal(current.begin(), current.end(), base.begin())) pages.push_back(page);
+        }
+        out.Write32(state.m_Memory.size());
+        out.WriteWord(pages.size());
+        for(const size_t page : pages) {
+            const span<const Byte> current = Page(state.m_Memory, page);
+            out.WriteWord(page);
+            EncodePage(current, keyframe ? span<const Byte>(ZEROS).first(current.size()) : Page(m_Previous.m_Memory, page), out);
+        }
+
+        vector<size_t> devices;
+        for(size_t i = 0; i < state.m_Devices.size(); i++) {
+            if(keyframe ? !state.m_Devices[i].empty() : state.m_Devices[i] != m_Previous.m_Devices[i]) devices.push_back(i);
+        }
+        out.WriteWord(state.m_Devices.size());
+        out.WriteWord(devices.size());
+        for(const size_t i : devices) {
+            out.WriteWord(i);
+            out.Write32(state.m_Devices[i].size());
+            out.WriteBytes(state.m_Devices[i]);
+        }
+
+        WriteFrame(keyframe ? FRAME_KEYFRAME : FRAME_DELTA);
+
+        m_Previous = state;
+        m_SinceKeyframe = keyframe ? 1 : m_SinceKeyframe + 1;
+        m_Count++;
+    }
+
+    void SaveStateWriter::WriteFrame(const Byte kind) {
+        vector<Byte> header;
+        StateWriter out(header);
+        out.Write(kind);
+        out.Write32(m_Payload.size());
+
+        vector<Byte> trailer;
+        StateWriter(trailer).Write32(Checksum(m_Payload));
+
+        m_Out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        m_Out.write(reinterpret_cast<const char*>(m_Payload.data()), m_Payload.size());
+        m_Out.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+        m_Out.flush();
+        if(!m_Out) throw runtime_error("Can't write the save state");
+    }
+
+    SaveStateReader::SaveStateReader(istream& in) : m_In(in) {
+        char magic[sizeof(SAVE_STATE_MAGIC)] = {};
+        m_In.read(magic, sizeof(magic));
+        const int version = m_In.get();
+        if(!m_In || !equal(magic, magic + sizeof(magic), SAVE_STATE_MAGIC)) throw runtime_error("Not a save state");
+        if(version != SAVE_STATE_VERSION) throw runtime_error("Unsupported save state version " + to_string(version));
+    }
+
+    bool SaveStateReader::Next() {
+        Byte header[5];
+        m_In.read(reinterpret_cast<char*>(header), sizeof(header));
+        if(m_In.gcount() != sizeof(header)) return false;
+
+        const Byte kind = header[0];
+        if(kind != FRAME_KEYFRAME && kind != FRAME_DELTA) throw runtime_error("Corrupted save state frame");
+        if(kind == FRAME_DELTA && !m_Count) throw runtime_error("Save state delta without a keyframe");
+
+        const uint32_t size = StateReader(header).ReadInt(5) >> 8;
+        m_Payload.resize(size + 4);
+        m_In.read(reinterpret_cast<char*>(m_Payload.data()), m_Payload.size());
+        if(static_cast<size_t>(m_In.gcount()) != m_Payload.size()) return false;
+
+        const uint32_t checksum = StateReader(span<const Byte>(m_Payload).subspan(size)).Read32();
+        m_Payload.resize(size);
+        if(checksum != Checksum(m_Payload)) throw runtime_error("Corrupted save state frame");
+
+        //Decoded aside : a frame that turns out malformed leaves the current state alone
+        MachineState state = kind == FRAME_KEYFRAME ? MachineState {} : m_State;
+        StateReader in(m_Payload);
+
+        Registers& registers = state.m_Registers;
+        registers.m_PC = in.ReadWord();
+        registers.m_SP = in.Read();
+        registers.m_Acc = in.Read();
+        registers.m_X = in.Read();
+        registers.m_Y = in.Read();
+        registers.m_CpuStatus = in.Read();
+        registers.m_OpValue = in.Read();
+        const Byte flags = in.Read();
+        state.m_Halted = flags & HALTED;
+        state.m_NmiPending = flags & NMI_PENDING;
+        state.m_ResetPending = flags & RESET_PENDING;
+        state.m_IrqLines = in.Read32();
+        state.m_Cycles = in.Read64();
+
+        const size_t memorySize = in.Read32();
+        if(kind == FRAME_KEYFRAME) state.m_Memory.assign(memorySize, 0);
+        else if(memorySize != state.m_Memory.size()) throw runtime_error("Save state delta of another memory size");
+        for(size_t count = in.ReadWord(); count; count--) {
+            const size_t page = in.ReadWord();
+            if(page * PAGE_SIZE >= state.m_Memory.size()) throw runtime_error("Corrupted save state page");
+            const size_t start = page * PAGE_SIZE;
+            DecodePage(span<Byte>(state.m_Memory).subspan(start, min(PAGE_SIZE, state.m_Memory.size() - start)), in);
+        }
+
+        const size_t deviceCount = in.ReadWord();
+        if(kind == FRAME_KEYFRAME) state.m_Devices.assign(deviceCount, {});
+        else if(deviceCount != state.m_Devices.size()) throw runtime_error("Save state delta of another device count");
+        for(size_t count = in.ReadWord(); count; count--) {
+            const size_t i = in.ReadWord();
+            if(i >= deviceCount) throw runtime_error("Corrupted save state device");
+            state.m_Devices[i].resize(in.Read32());
+            in.ReadBytes(state.m_Devices[i]);
+        }
+        if(!in.IsAtEnd()) throw runtime_error("Corrupted save state frame");
+
+        m_State = std::move(state);
+        m_Count++;
+        return true;
+    }
+
+    bool SaveStateReader::ReadLast() {
+        while(Next()) {}
+        return m_Count > 0;
+    }
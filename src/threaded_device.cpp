@@ -0,0 +1,191 @@
+#include "threaded_device.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace {
+
+    //Yields before going to sleep : the other side is usually about to move
+    constexpr int SPINS = 64;
+}
+
+    ThreadedDevice::ThreadedDevice(io_ptr device, const uint64_t latency, const size_t capacity)
+        : m_Device(std::move(device)), m_Events(bit_ceil(max<size_t>(capacity, 2))), m_Mask(m_Events.size() - 1), m_Latency(latency) {
+        if(!m_Device) throw invalid_argument("Threading no device");
+        m_Thread = thread(&ThreadedDevice::DeviceLoop, this);
+    }
+
+    ThreadedDevice::~ThreadedDevice() {
+        BusEvent stop {};
+        stop.m_Kind = BusEvent::STOP;
+        Post(stop);
+        m_Thread.join();
+    }
+
+    void ThreadedDevice::Post(const BusEvent& event) {
+        const size_t tail = m_Tail.load(memory_order_relaxed);
+        if(tail == m_FreeUntil) {
+            m_FreeUntil = m_Head.load(memory_order_acquire) + m_Events.size();
+            if(tail == m_FreeUntil) {
+                WaitForHead(tail - m_Events.size() + 1);
+                m_FreeUntil = m_Head.load(memory_order_acquire) + m_Events.size();
+            }
+        }
+        m_Events[tail & m_Mask] = event;
+
+        //Sequentially consistent with the device thread's m_ConsumerAsleep store then m_Tail load :
+        //either it sees the event, or this sees it asleep
+        m_Tail.store(tail + 1, memory_order_seq_cst);
+        if(m_ConsumerAsleep.load(memory_order_seq_cst)) m_Tail.notify_one();
+    }
+
+    void ThreadedDevice::WaitForHead(const size_t head) const {
+        for(int i = 0; i < SPINS; i++) {
+            if(m_Head.load(memory_order_acquire) >= head) return;
+            this_thread::yield();
+        }
+        for(;;) {
+            m_ProducerWaiting.store(true, memory_order_seq_cst);
+            const size_t current = m_Head.load(memory_order_seq_cst);
+            if(current >= head) break;
+            m_Head.wait(current, memory_order_acquire);
+        }
+        m_ProducerWaiting.store(false, memory_order_relaxed);
+    }
+
+    void ThreadedDevice::CheckError() const {
+        if(m_Failed.load(memory_order_acquire)) rethrow_exception(m_Error);
+    }
+
+    void ThreadedDevice::Sync() const {
+        const size_t tail = m_Tail.load(memory_order_relaxed);
+        if(m_Head.load(memory_order_acquire) != tail) WaitForHead(tail);
+        CheckError();
+    }
+
+    void ThreadedDevice::DeviceLoop() {
+        size_t head = m_Head.load(memory_order_relaxed);
+        for(;;) {
+            size_t tail = m_Tail.load(memory_order_acquire);
+            for(int i = 0; i < SPINS && head == tail; i++) {
+                this_thread::yield();
+                tail = m_Tail.load(memory_order_acquire);
+            }
+            if(head == tail) {
+                m_ConsumerAsleep.store(true, memory_order_seq_cst);
+                tail = m_Tail.load(memory_order_seq_cst);
+                if(head == tail) m_Tail.wait(tail, memory_order_acquire);
+                m_ConsumerAsleep.store(false, memory_order_relaxed);
+                continue;
+            }
+
+            for(; head != tail; head++) {
+                const BusEvent& event = m_Events[head & m_Mask];
+                const bool stop = event.m_Kind == BusEvent::STOP;
+
+                //Once failed, the writes are dropped : the CPU's thread throws from its next access
+                if(!stop && !m_Failed.load(memory_order_relaxed)) {
+                    try {
+                        Apply(event);
+                    }
+                    catch(...) {
+                        m_Error = current_exception();
+                        m_Failed.store(true, memory_order_release);
+                    }
+                }
+
+                //One event at a time : a CPU waiting for the window or for room moves on as soon as it can
+                m_Head.store(head + 1, memory_order_seq_cst);
+                if(m_ProducerWaiting.load(memory_order_seq_cst)) m_Head.notify_one();
+                if(stop) return;
+            }
+        }
+    }
+
+    void ThreadedDevice::Apply(const BusEvent& event) {
+        switch (event.m_Kind) {
+            case BusEvent::WRITE_BYTE: m_Device->WriteByte(event.m_Addr, event.m_Data[0]); break;
+            case BusEvent::WRITE_WORD: m_Device->WriteWord(event.m_Addr, MAKE_WORD(event.m_Data[1], event.m_Data[0])); break;
+            case BusEvent::WRITE_BYTES: m_Device->WriteBytes(event.m_Addr, span<const Byte>(event.m_Data.data(), event.m_Size)); break;
+            default: break;
+        }
+    }
+
+    void ThreadedDevice::Submit(BusEvent& event) {
+        CheckError();
+        if(!m_Clock) {
+            Post(event);
+            return;
+        }
+
+        //The device lags more than the window behind : waits until the writes left are recent enough
+        event.m_Cycle = m_Clock();
+        const size_t tail = m_Tail.load(memory_order_relaxed);
+        for(size_t head = m_Head.load(memory_order_acquire); head != tail; head = m_Head.load(memory_order_acquire)) {
+            if(event.m_Cycle - m_Events[head & m_Mask].m_Cycle <= m_Latency) break;
+            WaitForHead(head + 1);
+        }
+        Post(event);
+    }
+
+    Byte ThreadedDevice::ReadByte(const address& addr) const {
+        Sync();
+        return m_Device->ReadByte(addr);
+    }
+
+    Word ThreadedDevice::ReadWord(const address& addr) const {
+        Sync();
+        return m_Device->ReadWord(addr);
+    }
+
+    void ThreadedDevice::ReadBytes(const address& addr, span<Byte> bytes) const {
+        Sync();
+        m_Device->ReadBytes(addr, bytes);
+    }
+
+    void ThreadedDevice::WriteByte(const address& addr, const Byte data) {
+        BusEvent event {};
+        event.m_Addr = addr.GetValue();
+        event.m_Kind = BusEvent::WRITE_BYTE;
+        event.m_Size = 1;
+        event.m_Data[0] = data;
+        Submit(event);
+    }
+
+    void ThreadedDevice::WriteWord(const address& addr, const Word data) {
+        BusEvent event {};
+        event.m_Addr = addr.GetValue();
+        event.m_Kind = BusEvent::WRITE_WORD;
+        event.m_Size = 2;
+        event.m_Data[0] = data & 0xFF;
+        event.m_Data[1] = data >> 8;
+        Submit(event);
+    }
+
+    //Split into events of at most BusEvent::MAX_BYTES, each a WriteBytes to the device
+    void ThreadedDevice::WriteBytes(const address& addr, span<const Byte> bytes) {
+        Word current = addr.GetValue();
+        for(size_t done = 0; done < bytes.size();) {
+            const size_t count = min(bytes.size() - done, BusEvent::MAX_BYTES);
+            BusEvent event {};
+            event.m_Addr = current;
+            event.m_Kind = BusEvent::WRITE_BYTES;
+            event.m_Size = static_cast<Byte>(count);
+            copy_n(bytes.begin() + done, count, event.m_Data.begin());
+            Submit(event);
+            current += count;
+            done += count;
+        }
+    }
+
+    void ThreadedDevice::SaveState(vector<Byte>& out) const {
+        Sync();
+        m_Device->SaveState(out);
+    }
+
+    void ThreadedDevice::LoadState(span<const Byte> in) {
+        Sync();
+        m_Device->LoadState(in);
+    }
@@ -0,0 +1,224 @@
+#include "trace.h"
+#include "opcodes.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+    enum : Byte {
+        PC_FOLLOWS = 0,
+        PC_TARGET = 1,
+        PC_STORED = 2,
+        PC_MASK = 0x03,
+
+        CHANGED_A = 1 << 2,
+        CHANGED_X = 1 << 3,
+        CHANGED_Y = 1 << 4,
+        CHANGED_SP = 1 << 5,
+        CHANGED_P = 1 << 6,
+        CYCLES_STORED = 1 << 7
+    };
+
+    //Records are encoded in batches, the file is written once this much is pending
+    constexpr size_t BATCH_SIZE = 1024;
+    constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+    //Longest encoded record : header, opcode, PC, 5 registers, cycles, address
+    constexpr size_t MAX_RECORD_SIZE = 12;
+
+    inline Word FollowingPC(const TraceRecord& record) {
+        return record.m_PC + 1 + OperandSize(OPCODES[record.m_Opcode].m_AddrMode);
+    }
+
+    //Operand bytes of the effective address the addressing mode doesn't give away
+    inline Byte AddressSize(const AddressMode addrMode) {
+        switch (addrMode) {
+            case AddressMode::IMM:
+            case AddressMode::IMP:
+            case AddressMode::ACC:
+            case AddressMode::ILL:
+                return 0;
+            case AddressMode::REL:
+            case AddressMode::ZPG:
+            case AddressMode::ZPX:
+            case AddressMode::ZPY:
+                return 1;
+            default:
+                return 2;
+        }
+    }
+
+    void Encode(const TraceRecord& record, const TraceRecord& previous, vector<Byte>& out) {
+        const Opcode& opcode = OPCODES[record.m_Opcode];
+
+        Byte header = PC_STORED;
+        if(record.m_PC == FollowingPC(previous)) header = PC_FOLLOWS;
+        else if(record.m_PC == previous.m_Addr) header = PC_TARGET;
+
+        if(record.m_Acc != previous.m_Acc) header |= CHANGED_A;
+        if(record.m_X != previous.m_X) header |= CHANGED_X;
+        if(record.m_Y != previous.m_Y) header |= CHANGED_Y;
+        if(record.m_SP != previous.m_SP) header |= CHANGED_SP;
+        if(record.m_Status != previous.m_Status) header |= CHANGED_P;
+        if(record.m_Cycles != opcode.m_Cycles) header |= CYCLES_STORED;
+
+        out.push_back(header);
+        out.push_back(record.m_Opcode);
+        if((header & PC_MASK) == PC_STORED) {
+            out.push_back(record.m_PC & 0xFF);
+            out.push_back(record.m_PC >> 8);
+        }
+        if(header & CHANGED_A) out.push_back(record.m_Acc);
+        if(header & CHANGED_X) out.push_back(record.m_X);
+        if(header & CHANGED_Y) out.push_back(record.m_Y);
+        if(header & CHANGED_SP) out.push_back(record.m_SP);
+        if(header & CHANGED_P) out.push_back(record.m_Status);
+        if(header & CYCLES_STORED) out.push_back(record.m_Cycles);
+
+        const Byte size = AddressSize(opcode.m_AddrMode);
+        if(opcode.m_AddrMode == AddressMode::REL) out.push_back(static_cast<Byte>(record.m_Addr - (record.m_PC + 2)));
+        else if(size >= 1) out.push_back(record.m_Addr & 0xFF);
+        if(size == 2) out.push_back(record.m_Addr >> 8);
+    }
+}
+
+    TraceRing::TraceRing(const size_t capacity)
+        : m_Records(bit_ceil(max<size_t>(capacity, 2))), m_Mask(m_Records.size() - 1) {}
+
+    size_t TraceRing::Pop(TraceRecord* records, const size_t count) {
+        const size_t head = m_Head.load(memory_order_relaxed);
+        const size_t available = min(m_Tail.load(memory_order_acquire) - head, count);
+        for(size_t i = 0; i < available; i++) records[i] = m_Records[(head + i) & m_Mask];
+        m_Head.store(head + available, memory_order_release);
+        return available;
+    }
+
+    TraceWriter::TraceWriter(const string& path, const size_t capacity) : m_Ring(capacity), m_File(path, ios::binary) {
+        if(!m_File) throw runtime_error("Can't create " + path);
+        m_File.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        m_File.put(static_cast<char>(TRACE_VERSION));
+        m_Thread = thread(&TraceWriter::WriterLoop, this);
+    }
+
+    TraceWriter::~TraceWriter() {
+        Close();
+    }
+
+    void TraceWriter::Close() {
+        if(!m_Thread.joinable()) return;
+        m_Stopping.store(true, memory_order_release);
+        m_Thread.join();
+        m_File.close();
+    }
+
+    void TraceWriter::WriterLoop() {
+        vector<TraceRecord> batch(BATCH_SIZE);
+        vector<Byte> out;
+        out.reserve(FLUSH_SIZE + BATCH_SIZE * MAX_RECORD_SIZE);
+        TraceRecord previous {};
+
+        auto flush = [&]() {
+            m_File.write(reinterpret_cast<const char*>(out.data()), out.size());
+            out.clear();
+        };
+
+        for(;;) {
+            //Read before popping : once stopping, an empty ring means every record has been seen
+            const bool stopping = m_Stopping.load(memory_order_acquire);
+            const size_t count = m_Ring.Pop(batch.data(), batch.size());
+
+            for(size_t i = 0; i < count; i++) {
+                Encode(batch[i], previous, out);
+                previous = batch[i];
+            }
+            m_Written += count;
+
+            if(out.size() >= FLUSH_SIZE || (!count && !out.empty())) flush();
+            if(count) continue;
+            if(stopping) break;
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+        m_File.flush();
+    }
+
+    TraceReader::TraceReader(const string& path) : m_File(path, ios::binary) {
+        if(!m_File) throw runtime_error("Can't open " + path);
+        char magic[sizeof(TRACE_MAGIC)] = {};
+        m_File.read(magic, sizeof(magic));
+        const int version = m_File.get();
+        if(!m_File || !equal(magic, magic + sizeof(magic), TRACE_MAGIC)) throw runtime_error(path + " isn't a trace");
+        if(version != TRACE_VERSION) throw runtime_error(path + " : unsupported trace version " + to_string(version));
+    }
+
+    //Makes sure `count` bytes are buffered from m_Position, false if the file ends before
+    bool TraceReader::Fill(const size_t count) {
+        if(m_Buffer.size() - m_Position >= count) return true;
+        m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_Position);
+        m_Position = 0;
+
+        const size_t size = m_Buffer.size();
+        m_Buffer.resize(size + FLUSH_SIZE);
+        m_File.read(reinterpret_cast<char*>(m_Buffer.data() + size), FLUSH_SIZE);
+        m_Buffer.resize(size + m_File.gcount());
+        return m_Buffer.size() >= count;
+    }
+
+    bool TraceReader::Next(TraceRecord& record) {
+        if(!Fill(2)) {
+            if(m_Buffer.size() > m_Position) throw runtime_error("Truncated trace record");
+            return false;
+        }
+
+        const Byte header = m_Buffer[m_Position];
+        const Byte code = m_Buffer[m_Position + 1];
+        const Opcode& opcode = OPCODES[code];
+
+        const size_t size = 2 + ((header & PC_MASK) == PC_STORED ? 2 : 0) + popcount(static_cast<Byte>(header & ~PC_MASK))
+                          + AddressSize(opcode.m_AddrMode);
+        if(!Fill(size)) throw runtime_error("Truncated trace record");
+
+        const Byte* data = m_Buffer.data() + m_Position + 2;
+        m_Position += size;
+
+        record = m_Previous;
+        record.m_Opcode = code;
+        switch (header & PC_MASK) {
+            case PC_FOLLOWS: record.m_PC = FollowingPC(m_Previous); break;
+            case PC_TARGET: record.m_PC = m_Previous.m_Addr; break;
+            case PC_STORED: record.m_PC = MAKE_WORD(data[1], data[0]); data += 2; break;
+            default: throw runtime_error("Corrupted trace record");
+        }
+        if(header & CHANGED_A) record.m_Acc = *data++;
+        if(header & CHANGED_X) record.m_X = *data++;
+        if(header & CHANGED_Y) record.m_Y = *data++;
+        if(header & CHANGED_SP) record.m_SP = *data++;
+        if(header & CHANGED_P) record.m_Status = *data++;
+        record.m_Cycles = header & CYCLES_STORED ? *data++ : opcode.m_Cycles;
+
+        switch (opcode.m_AddrMode) {
+            case AddressMode::IMM:
+            case AddressMode::IMP:
+            case AddressMode::ACC:
+            case AddressMode::ILL:
+                record.m_Addr = record.m_PC + 1;
+                break;
+            case AddressMode::REL:
+                record.m_Addr = record.m_PC + 2 + static_cast<signed char>(data[0]);
+                break;
+            case AddressMode::ZPG:
+            case AddressMode::ZPX:
+            case AddressMode::ZPY:
+                record.m_Addr = data[0];
+                break;
+            default:
+                record.m_Addr = MAKE_WORD(data[1], data[0]);
+                break;
+        }
+
+        m_Previous = record;
+        return true;
+    }
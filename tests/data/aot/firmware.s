@@ -0,0 +1,36 @@
+; Source of firmware.bin, mapped at $FF00 (test_aot)
+
+        * = $FF00
+reset   LDX #$FF
+        TXS
+        LDY #0
+fill    TYA             ; $0200,Y = Y and $0300,Y = Y ^ $55
+        STA $0200,Y
+        JSR mix
+        INY
+        BNE fill
+        LDA #0          ; $10 = sum of the table
+        CLC
+        TAX
+sum     ADC $0200,X
+        INX
+        BNE sum
+        STA $10
+        LDA #<done      ; jumps through a pointer built at run time
+        STA $12
+        LDA #>done
+        STA $13
+        JMP ($0012)
+
+        * = $FF30
+mix     EOR #$55
+        STA $0300,Y
+        RTS
+
+        * = $FF40
+done    LDA #$AA
+        STA $11
+        .byte $02       ; jam
+
+        * = $FFFA
+        .word done, reset, done
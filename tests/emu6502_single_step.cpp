@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cpu.h>
+#include <memory.h>
+#include <opcodes.h>
+#include "single_step.h"
+
+using namespace std;
+
+//emu6502_single_step : runs SingleStepTests 6502 vectors (see StepTest), sharded across the cores
+//
+//  emu6502_single_step <directory | file.json>... [--jobs <n>] [--shard <k>/<n>] [--illegal] [--failures <n>]
+//
+//  --jobs      worker threads, every core by default
+//  --shard     only the k-th of n slices of the files (0 <= k < n), to spread a corpus over several machines
+//  --illegal   also runs the vectors of the undocumented opcodes, which jam the CPU
+//  --failures  mismatches reported per file, 5 by default
+//
+//Every worker reuses one CPU and one Memory : a vector writes its initial RAM, runs one instruction, and the
+//memory is restored to the blank snapshot taken up front, which only copies back the pages the vector touched.
+//Registers, RAM and the cycle count are compared. Bits 4 and 5 of P (B and unused) aren't flags, they are left out.
+
+namespace {
+
+    constexpr Byte NOT_FLAGS = 0x30;
+
+    struct Options {
+        vector<filesystem::path> m_Files;
+        size_t m_Jobs = max(thread::hardware_concurrency(), 1u);
+        size_t m_Shard = 0;
+        size_t m_ShardCount = 1;
+        bool m_Illegal = false;
+        size_t m_MaxFailures = 5;
+    };
+
+    struct FileResult {
+        uint64_t m_Passed = 0;
+        uint64_t m_Failed = 0;
+        uint64_t m_Skipped = 0;
+        vector<string> m_Failures;      //The first ones
+        string m_Error;                 //The file couldn't be read
+    };
+
+    //CPU exposing what a vector sets : the registers, and the state a jammed opcode leaves behind
+    class StepCPU : public CPU {
+
+            public :
+
+                using CPU::CPU;
+
+                void Load(const StepState& state) {
+                    Registers registers = GetRegisters();
+                    registers.m_PC = state.m_PC;
+                    registers.m_SP = state.m_SP;
+                    registers.m_Acc = state.m_Acc;
+                    registers.m_X = state.m_X;
+                    registers.m_Y = state.m_Y;
+                    registers.m_CpuStatus = state.m_Status;
+                    SetRegisters(registers);
+                    m_Halted = false;
+                    m_IrqLines = 0;
+                    m_NmiPending = false;
+                    m_ResetPending = false;
+                }
+    };
+
+    void Usage() {
+        cerr << "usage : emu6502_single_step <directory | file.json>... [--jobs <n>] [--shard <k>/<n>] [--illegal] [--failures <n>]" << endl;
+    }
+
+    string Mismatch(const StepTest& test, const char* what, const unsigned expected, const unsigned actual) {
+        char line[128];
+        snprintf(line, sizeof(line), " : %s expected %02X, got %02X", what, expected, actual);
+        return test.m_Name + line;
+    }
+
+    //Runs the vector, appends what differs to `failures` while they hold less than `maxFailures` lines
+    bool RunTest(const StepTest& test, StepCPU& cpu, const Memory& memory, vector<string>& failures, const size_t maxFailures) {
+        cpu.Load(test.m_Initial);
+        const Byte cycles = cpu.Step();
+
+        const StepState& expected = test.m_Final;
+        const Registers registers = cpu.GetRegisters();
+        bool passed = true;
+        auto check = [&](const char* what, const unsigned expected, const unsigned actual) {
+            if(expected == actual) return;
+            passed = false;
+            if(failures.size() < maxFailures) failures.push_back(Mismatch(test, what, expected, actual));
+        };
+
+        check("PC", expected.m_PC, registers.m_PC);
+        check("SP", expected.m_SP, registers.m_SP);
+        check("A", expected.m_Acc, registers.m_Acc);
+        check("X", expected.m_X, registers.m_X);
+        check("Y", expected.m_Y, registers.m_Y);
+        check("P", expected.m_Status & ~NOT_FLAGS, registers.m_CpuStatus.m_Value & ~NOT_FLAGS);
+        check("cycles", test.m_Cycles, cycles);
+        for(const auto& [addr, value] : expected.m_Ram) {
+            char what[16];
+            snprintf(what, sizeof(what), "$%04X", addr);
+            check(what, value, memory.ReadByte(addr));
+        }
+        return passed;
+    }
+
+    FileResult RunFile(const filesystem::path& path, const Options& options) {
+        FileResult result;
+
+        auto memory = make_shared<Memory>();
+        const Memory::snapshot_ptr blank = memory->Snapshot();
+        StepCPU cpu(memory);
+
+        try {
+            ifstream file(path, ios::binary);
+            if(!file) throw runtime_error("can't open the file");
+
+            StepTestReader reader(file);
+            StepTest test;
+            while(reader.Next(test)) {
+                for(const auto& [addr, value] : test.m_Initial.m_Ram) (*memory)[addr] = value;
+
+                if(!options.m_Illegal && OPCODES[memory->ReadByte(test.m_Initial.m_PC)].m_Instruction == Instructions::ILL) result.m_Skipped++;
+                else if(RunTest(test, cpu, *memory, result.m_Failures, options.m_MaxFailures)) result.m_Passed++;
+                else result.m_Failed++;
+
+                memory->Restore(blank);
+            }
+        }
+        catch(const exception& e) {
+            result.m_Error = e.what();
+        }
+        return result;
+    }
+
+    //The .json files of the directories, and the files given as is, sorted
+    vector<filesystem::path> ListFiles(const vector<filesystem::path>& inputs) {
+        vector<filesystem::path> files;
+        for(const filesystem::path& input : inputs) {
+            if(!filesystem::is_directory(input)) {
+                if(!filesystem::exists(input)) throw runtime_error(input.string() + " doesn't exist");
+                files.push_back(input);
+                continue;
+            }
+            for(const filesystem::directory_entry& entry : filesystem::directory_iterator(input)) {
+                if(entry.is_regular_file() && entry.path().extension() == ".json") files.push_back(entry.path());
+            }
+        }
+        sort(files.begin(), files.end());
+        return files;
+    }
+
+    Options ParseOptions(const int argc, char** argv) {
+        Options options;
+        vector<filesystem::path> inputs;
+        for(int i = 1; i < argc; i++) {
+            const string arg = argv[i];
+            auto value = [&]() -> string {
+                if(i + 1 >= argc) throw invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if(arg == "--jobs") options.m_Jobs = max<size_t>(stoul(value()), 1);
+            else if(arg == "--shard") {
+                const string shard = value();
+                const size_t slash = shard.find('/');
+                if(slash == string::npos) throw invalid_argument("--shard takes <k>/<n>");
+                options.m_Shard = stoul(shard.substr(0, slash));
+                options.m_ShardCount = stoul(shard.substr(slash + 1));
+                if(!options.m_ShardCount || options.m_Shard >= options.m_ShardCount) throw invalid_argument("--shard takes <k>/<n>, 0 <= k < n");
+            }
+            else if(arg == "--illegal") options.m_Illegal = true;
+            else if(arg == "--failures") options.m_MaxFailures = stoul(value());
+            else if(arg[0] != '-') inputs.push_back(arg);
+            else throw invalid_argument("Unknown argument : " + arg);
+        }
+
+        const vector<filesystem::path> files = ListFiles(inputs);
+        for(size_t i = options.m_Shard; i < files.size(); i += options.m_ShardCount) options.m_Files.push_back(files[i]);
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+
+    try {
+        if(argc < 2) {
+            Usage();
+            return EXIT_FAILURE;
+        }
+        const Options options = ParseOptions(argc, argv);
+        if(options.m_Files.empty()) throw runtime_error("No test file");
+
+        //The workers take the files in turn
+        vector<FileResult> results(options.m_Files.size());
+        atomic<size_t> next { 0 };
+        auto worker = [&]() {
+            for(size_t i = next++; i < options.m_Files.size(); i = next++) results[i] = RunFile(options.m_Files[i], options);
+        };
+
+        const auto start = chrono::steady_clock::now();
+        vector<thread> workers;
+        for(size_t i = 1; i < min(options.m_Jobs, options.m_Files.size()); i++) workers.emplace_back(worker);
+        worker();
+        for(thread& thread : workers) thread.join();
+        const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        FileResult total;
+        size_t errors = 0;
+        for(size_t i = 0; i < results.size(); i++) {
+            const FileResult& result = results[i];
+            total.m_Passed += result.m_Passed;
+            total.m_Failed += result.m_Failed;
+            total.m_Skipped += result.m_Skipped;
+
+            const string name = options.m_Files[i].filename().string();
+            if(!result.m_Error.empty()) {
+                cerr << name << " : " << result.m_Error << endl;
+                errors++;
+            }
+            if(!result.m_Failed) continue;
+            cout << name << " : " << result.m_Failed << " failed" << endl;
+            for(const string& failure : result.m_Failures) cout << "    " << failure << endl;
+        }
+
+        const uint64_t run = total.m_Passed + total.m_Failed;
+        cout << options.m_Files.size() << " files, " << run << " vectors run, " << total.m_Passed << " passed, " << total.m_Failed << " failed, "
+             << total.m_Skipped << " skipped in " << seconds << " s (" << static_cast<uint64_t>(run / max(seconds, 1e-9)) << " vectors/s, "
+             << min(options.m_Jobs, options.m_Files.size()) << " threads)" << endl;
+
+        return total.m_Failed || errors ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    catch(const exception& e) {
+        cerr << "emu6502_single_step : " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <random>
+#include <vector>
+#include <types.h>
+#include <opcodes.h>
+#include <cpu_core.h>
+
+using namespace std;
+
+//Writes `bytes` from `addr` on, through the bus WriteByte
+template<typename BusPolicy>
+inline void Load(BusPolicy& bus, const Word addr, initializer_list<Byte> bytes) {
+    Word at = addr;
+    for(const Byte byte : bytes) bus.WriteByte(at++, byte);
+}
+
+//Registers to run from `pc` : stack at its top, interrupts masked, the rest cleared
+inline Registers StartAt(const Word pc) {
+    Registers registers {};
+    registers.m_PC = pc;
+    registers.m_SP = 0xFF;
+    registers.m_CpuStatus = static_cast<Byte>(StatusFlag::INTERRUPT) | static_cast<Byte>(StatusFlag::UNUSED);
+    return registers;
+}
+
+//Random registers, decimal mode off
+inline Registers RandomRegisters(mt19937& rng) {
+    Registers registers {};
+    registers.m_PC = rng();
+    registers.m_SP = rng();
+    registers.m_Acc = rng();
+    registers.m_X = rng();
+    registers.m_Y = rng();
+    registers.m_CpuStatus = (rng() & ~static_cast<Byte>(StatusFlag::DECIMAL)) | static_cast<Byte>(StatusFlag::UNUSED);
+    return registers;
+}
+
+//64 KB of random code that never jams : the undocumented opcodes are drawn again
+inline vector<Byte> RandomImage(mt19937& rng) {
+    vector<Byte> image(0x10000);
+    for(Byte& byte : image) {
+        do byte = rng();
+        while(OPCODES[byte].m_Instruction == Instructions::ILL);
+    }
+    return image;
+}
+
+inline bool operator==(const Registers& a, const Registers& b) {
+    return a.m_PC == b.m_PC && a.m_SP == b.m_SP && a.m_Acc == b.m_Acc && a.m_X == b.m_X && a.m_Y == b.m_Y
+        && a.m_CpuStatus.m_Value == b.m_CpuStatus.m_Value;
+}
@@ -0,0 +1,199 @@
+#include "single_step.h"
+
+#include <cctype>
+#include <stdexcept>
+
+    StepTestReader::StepTestReader(istream& in) : m_In(in), m_Buffer(BUFFER_SIZE) {}
+
+    //Refills the buffer once consumed, false at the end of the stream
+    bool StepTestReader::Fill() {
+        if(m_Position < m_Size) return true;
+        m_In.read(m_Buffer.data(), m_Buffer.size());
+        m_Size = m_In.gcount();
+        m_Position = 0;
+        return m_Size != 0;
+    }
+
+    char StepTestReader::Peek() {
+        if(!Fill()) Fail("unexpected end of file");
+        return m_Buffer[m_Position];
+    }
+
+    char StepTestReader::Get() {
+        const char c = Peek();
+        m_Position++;
+        return c;
+    }
+
+    void StepTestReader::Expect(const char c) {
+        SkipSpace();
+        if(Get() != c) Fail(string("expected '") + c + "'");
+    }
+
+    void StepTestReader::SkipSpace() {
+        while(Fill()) {
+            const char c = m_Buffer[m_Position];
+            if(c != ' ' && c != '\n' && c != '\r' && c != '\t') return;
+            m_Position++;
+        }
+    }
+
+    void StepTestReader::ReadString(string& value) {
+        Expect('"');
+        value.clear();
+        for(char c = Get(); c != '"'; c = Get()) {
+            if(c == '\\') Fail("escaped characters aren't supported");
+            value.push_back(c);
+        }
+    }
+
+    uint64_t StepTestReader::ReadNumber() {
+        SkipSpace();
+        char c = Peek();
+        if(c < '0' || c > '9') Fail("expected a number");
+        uint64_t value = 0;
+        while(c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            m_Position++;
+            if(!Fill()) break;
+            c = m_Buffer[m_Position];
+        }
+        return value;
+    }
+
+    void StepTestReader::SkipValue() {
+        SkipSpace();
+        const char c = Peek();
+        if(c == '"') {
+            string value;
+            ReadString(value);
+        }
+        else if(c == '[' || c == '{') {
+            const char close = c == '[' ? ']' : '}';
+            m_Position++;
+            SkipSpace();
+            if(Peek() == close) {
+                m_Position++;
+                return;
+            }
+            for(;;) {
+                if(close == '}') {
+                    string key;
+                    ReadString(key);
+                    Expect(':');
+                }
+                SkipValue();
+                SkipSpace();
+                const char next = Get();
+                if(next == close) return;
+                if(next != ',') Fail("expected ',' or a closing bracket");
+            }
+        }
+        else if(c >= '0' && c <= '9') ReadNumber();
+        else {
+            //true, false, null
+            while(Fill() && isalpha(static_cast<unsigned char>(m_Buffer[m_Position]))) m_Position++;
+        }
+    }
+
+    void StepTestReader::ReadState(StepState& state) {
+        state.m_Ram.clear();
+        Expect('{');
+        string key;
+        for(;;) {
+            ReadString(key);
+            Expect(':');
+            if(key == "pc") state.m_PC = ReadNumber();
+            else if(key == "s") state.m_SP = ReadNumber();
+            else if(key == "a") state.m_Acc = ReadNumber();
+            else if(key == "x") state.m_X = ReadNumber();
+            else if(key == "y") state.m_Y = ReadNumber();
+            else if(key == "p") state.m_Status = ReadNumber();
+            else if(key == "ram") {
+                Expect('[');
+                SkipSpace();
+                if(Peek() == ']') m_Position++;
+                else for(;;) {
+                    Expect('[');
+                    const Word addr = ReadNumber();
+                    Expect(',');
+                    const Byte value = ReadNumber();
+                    Expect(']');
+                    state.m_Ram.emplace_back(addr, value);
+                    SkipSpace();
+                    const char next = Get();
+                    if(next == ']') break;
+                    if(next != ',') Fail("expected ',' or ']'");
+                }
+            }
+            else SkipValue();
+
+            SkipSpace();
+            const char next = Get();
+            if(next == '}') return;
+            if(next != ',') Fail("expected ',' or '}'");
+        }
+    }
+
+    //Skips an array, returns its number of elements
+    size_t StepTestReader::CountArray() {
+        Expect('[');
+        SkipSpace();
+        if(Peek() == ']') {
+            m_Position++;
+            return 0;
+        }
+        size_t count = 0;
+        for(;;) {
+            SkipValue();
+            count++;
+            SkipSpace();
+            const char next = Get();
+            if(next == ']') return count;
+            if(next != ',') Fail("expected ',' or ']'");
+        }
+    }
+
+    bool StepTestReader::Next(StepTest& test) {
+        if(m_Done) return false;
+
+        SkipSpace();
+        if(!m_Started) {
+            m_Started = true;
+            Expect('[');
+            SkipSpace();
+        }
+        else {
+            const char next = Get();
+            if(next == ']') m_Done = true;
+            else if(next != ',') Fail("expected ',' or ']'");
+            SkipSpace();
+        }
+        if(!m_Done && Peek() == ']') {
+            m_Position++;
+            m_Done = true;
+        }
+        if(m_Done) return false;
+
+        test.m_Cycles = 0;
+        Expect('{');
+        string key;
+        for(;;) {
+            ReadString(key);
+            Expect(':');
+            if(key == "name") ReadString(test.m_Name);
+            else if(key == "initial") ReadState(test.m_Initial);
+            else if(key == "final") ReadState(test.m_Final);
+            else if(key == "cycles") test.m_Cycles = CountArray();
+            else SkipValue();
+
+            SkipSpace();
+            const char next = Get();
+            if(next == '}') return true;
+            if(next != ',') Fail("expected ',' or '}'");
+        }
+    }
+
+    void StepTestReader::Fail(const string& what) const {
+        throw runtime_error("Malformed test file : " + what);
+    }
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <types.h>
+
+using namespace std;
+
+//Registers and memory of a single-step test, before ("initial") or after ("final") the instruction
+struct StepState {
+    Word m_PC = 0;
+    Byte m_SP = 0;
+    Byte m_Acc = 0;
+    Byte m_X = 0;
+    Byte m_Y = 0;
+    Byte m_Status = 0;
+    vector<pair<Word, Byte>> m_Ram;     //(address, value), every location the instruction touches
+};
+
+//One vector of the SingleStepTests 6502 suites (https://github.com/SingleStepTests/65x02) :
+//
+//  { "name": "a9 23 6f", "initial": { "pc": 1234, "s": 189, "a": 0, "x": 1, "y": 2, "p": 36, "ram": [[1234, 169], ...] },
+//    "final": { ... }, "cycles": [[1234, 169, "read"], ...] }
+//
+//The cycles list every bus access of the instruction : only their count is kept.
+struct StepTest {
+    string m_Name;
+    StepState m_Initial;
+    StepState m_Final;
+    size_t m_Cycles = 0;
+};
+
+//Pull parser over a test file, a JSON array of vectors : Next() decodes them one at a time,
+//through a fixed size buffer, so that a file never needs to fit in memory.
+//Only the JSON the suites use is understood : objects, arrays, strings without escapes, and unsigned integers.
+class StepTestReader {
+
+        private :
+
+            static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+            istream& m_In;
+            vector<char> m_Buffer;
+            size_t m_Position = 0;
+            size_t m_Size = 0;
+            bool m_Started = false;
+            bool m_Done = false;
+
+            bool Fill();
+            char Peek();
+            char Get();
+            void Expect(const char c);
+            void SkipSpace();
+
+            void ReadString(string& value);
+            uint64_t ReadNumber();
+            void SkipValue();
+
+            void ReadState(StepState& state);
+            size_t CountArray();
+
+            [[noreturn]] void Fail(const string& what) const;
+
+        public :
+
+            explicit StepTestReader(istream& in);
+
+            //Decodes the next vector into `test`, false after the last one. Throws runtime_error on malformed input.
+            bool Next(StepTest& test);
+};
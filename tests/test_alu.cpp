@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <alu.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //Decimal ADC / SBC of the NMOS 6502, written from Bruce Clark's description independently of alu.h.
+    //Returns the result, `flags` receives N, V, Z and C at their place in the status register.
+    int DecimalAdc(const int a, const int b, const int c, int& flags) {
+        int low = (a & 0x0F) + (b & 0x0F) + c;
+        if(low >= 0x0A) low = ((low + 0x06) & 0x0F) + 0x10;
+        int result = (a & 0xF0) + (b & 0xF0) + low;
+        const int sign = static_cast<signed char>(a & 0xF0) + static_cast<signed char>(b & 0xF0) + low;
+        if(result >= 0xA0) result += 0x60;
+        flags = (result >= 0x100 ? 0x01 : 0) | (((a + b + c) & 0xFF) == 0 ? 0x02 : 0) | ((sign < -128 || sign > 127) ? 0x40 : 0) | (sign & 0x80);
+        return result & 0xFF;
+    }
+
+    int DecimalSbc(const int a, const int b, const int c, int& flags) {
+        int low = (a & 0x0F) - (b & 0x0F) + c - 1;
+        if(low < 0) low = ((low - 0x06) & 0x0F) - 0x10;
+        int result = (a & 0xF0) - (b & 0xF0) + low;
+        if(result < 0) result -= 0x60;
+        const int binary = a - b + c - 1;
+        flags = (binary >= 0 ? 0x01 : 0) | ((binary & 0xFF) == 0 ? 0x02 : 0) | (((a ^ b) & (a ^ binary) & 0x80) ? 0x40 : 0) | (binary & 0x80);
+        return result & 0xFF;
+    }
+}
+
+//The compile-time tables, and the core running ADC / SBC in decimal mode, match the reference for every input
+TEST(Alu, DecimalModeMatchesTheNmosReference) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    for(int sbc = 0; sbc < 2; sbc++) for(int c = 0; c < 2; c++) for(int a = 0; a < 256; a++) for(int b = 0; b < 256; b++) {
+        int flags = 0;
+        const int result = sbc ? DecimalSbc(a, b, c, flags) : DecimalAdc(a, b, c, flags);
+
+        const Word entry = sbc ? DecimalSub(a, b, c) : DecimalAdd(a, b, c);
+        ASSERT_EQ(entry & 0xFF, result) << (sbc ? "SBC " : "ADC ") << a << ", " << b << ", " << c;
+        ASSERT_EQ(entry >> 8, flags) << (sbc ? "SBC " : "ADC ") << a << ", " << b << ", " << c;
+
+        Load(memory, 0x0200, { static_cast<Byte>(sbc ? 0xE9 : 0x69), static_cast<Byte>(b) });
+        Registers registers = StartAt(0x0200);
+        registers.m_Acc = a;
+        registers.m_CpuStatus = registers.m_CpuStatus.m_Value | static_cast<Byte>(StatusFlag::DECIMAL) | c;
+        cpu.SetRegisters(registers);
+        cpu.Step();
+        ASSERT_EQ(cpu.GetAccumulator(), result);
+        ASSERT_EQ(cpu.GetStatus().m_Value & ALU_FLAGS, flags);
+    }
+}
+
+//A few valid BCD sums, as a program would see them
+TEST(Alu, DecimalSums) {
+    EXPECT_EQ(DecimalAdd(0x09, 0x01, 0) & 0xFF, 0x10);
+    EXPECT_EQ(DecimalAdd(0x99, 0x01, 0) & 0xFF, 0x00);
+    EXPECT_EQ(DecimalAdd(0x99, 0x01, 0) >> 8 & static_cast<Byte>(StatusFlag::CARRY), static_cast<Byte>(StatusFlag::CARRY));
+    EXPECT_EQ(DecimalSub(0x10, 0x01, 1) & 0xFF, 0x09);
+    EXPECT_EQ(DecimalSub(0x00, 0x01, 1) & 0xFF, 0x99);
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <aot.h>
+#include <bus.h>
+#include <cpu_core.h>
+#include "helpers.h"
+
+//Generated at build time from data/aot/firmware.bin by emu6502-aot
+extern const AotProgram<Bus> firmware;
+
+namespace {
+
+    vector<Byte> ReadFirmware() {
+        ifstream file(FIRMWARE_IMAGE, ios::binary);
+        return vector<Byte>(istreambuf_iterator<char>(file), {});
+    }
+}
+
+//The recompiled firmware runs as the interpreter does : registers, memory and cycles
+TEST(AotCPU, MatchesTheCore) {
+    const vector<Byte> rom = ReadFirmware();
+    ASSERT_EQ(rom.size(), 0x100u);
+    EXPECT_GT(firmware.m_Count, 0u);
+
+    vector<Byte> reference_ram(0xFF00), ram(0xFF00);
+    Bus reference_bus, bus;
+    reference_bus.MapRam(0x00, 0xFF, reference_ram.data());
+    reference_bus.MapRom(0xFF, 1, rom.data());
+    bus.MapRam(0x00, 0xFF, ram.data());
+    bus.MapRom(0xFF, 1, rom.data());
+
+    CPUCore<Bus> reference(reference_bus);
+    AotCPU<Bus> cpu(bus);
+    ASSERT_TRUE(cpu.Load(firmware));
+    reference.Reset();
+    cpu.Reset();
+
+    EXPECT_EQ(cpu.Run(100000), reference.Run(100000));
+    EXPECT_TRUE(cpu.IsHalted());
+    EXPECT_TRUE(cpu.GetRegisters() == reference.GetRegisters());
+    EXPECT_TRUE(ram == reference_ram);
+    EXPECT_EQ(ram[0x11], 0xAA);
+    EXPECT_EQ(ram[0x0355], 0x00);
+}
+
+//The blocks are only registered on the image they were generated from
+TEST(AotCPU, RejectsAnotherImage) {
+    vector<Byte> rom = ReadFirmware();
+    rom[0x05] ^= 1;
+    vector<Byte> ram(0xFF00);
+    Bus bus;
+    bus.MapRam(0x00, 0xFF, ram.data());
+    bus.MapRom(0xFF, 1, rom.data());
+    AotCPU<Bus> cpu(bus);
+    EXPECT_FALSE(cpu.Load(firmware));
+}
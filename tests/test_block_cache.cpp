@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <block_cache.h>
+#include <bus.h>
+#include <cpu_core.h>
+#include "helpers.h"
+
+//Random code replayed from the block cache matches the interpreter, cycle for cycle
+TEST(CachedCPU, MatchesTheCoreOnRandomCode) {
+    mt19937 rng(4);
+    for(int round = 0; round < 300; round++) {
+        SCOPED_TRACE(round);
+        const vector<Byte> image = RandomImage(rng);
+        const Registers start = RandomRegisters(rng);
+
+        vector<Byte> reference_ram = image, ram = image;
+        Bus reference_bus, bus;
+        reference_bus.MapRam(0x00, 256, reference_ram.data());
+        bus.MapRam(0x00, 256, ram.data());
+
+        CPUCore<Bus> reference(reference_bus);
+        CachedCPU<Bus> cpu(bus);
+        reference.SetRegisters(start);
+        cpu.SetRegisters(start);
+
+        EXPECT_EQ(cpu.Run(2000), reference.Run(2000));
+        EXPECT_TRUE(cpu.GetRegisters() == reference.GetRegisters());
+        EXPECT_TRUE(ram == reference_ram);
+    }
+}
+
+//A store into the block being run drops it : the modified instruction runs as written
+TEST(CachedCPU, SelfModifyingCode) {
+    vector<Byte> ram(0x10000);
+    Bus bus;
+    bus.MapRam(0x00, 256, ram.data());
+
+    //0200 : LDA #$05 ; STA $0206 ; LDX #$00 (operand rewritten to $05) ; jam
+    Load(bus, 0x0200, { 0xA9, 0x05, 0x8D, 0x06, 0x02, 0xA2, 0x00, 0x02 });
+    Load(bus, 0xFFFC, { 0x00, 0x02 });
+    CachedCPU<Bus> cpu(bus);
+    cpu.SetRegisters(StartAt(0x0200));
+    cpu.Run(100);
+    EXPECT_TRUE(cpu.IsHalted());
+    EXPECT_EQ(cpu.GetX(), 0x05);
+
+    //Host writes are not seen until Invalidate()
+    Load(bus, 0x0200, { 0xA9, 0x07, 0x8D, 0x06, 0x02, 0xA2, 0x00, 0x02 });
+    cpu.Invalidate();
+    cpu.Reset();
+    cpu.Run(100);
+    EXPECT_EQ(cpu.GetX(), 0x07);
+}
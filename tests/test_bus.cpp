@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <bus.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //Remembers the accesses it gets, reads back the low byte of the address
+    struct Recorder : IODevice {
+        mutable vector<Word> m_Reads;
+        vector<pair<Word, Byte>> m_Writes;
+
+        Byte ReadByte(const address& addr) const override { m_Reads.push_back(addr.GetValue()); return addr.GetRecord(); }
+        Word ReadWord(const address& addr) const override { return MAKE_WORD(ReadByte(addr.GetValue() + 1), ReadByte(addr)); }
+        void WriteByte(const address& addr, const Byte data) override { m_Writes.emplace_back(addr.GetValue(), data); }
+        void WriteWord(const address& addr, const Word data) override { WriteByte(addr, data & 0xFF); WriteByte(addr.GetValue() + 1, data >> 8); }
+    };
+}
+
+TEST(Bus, RamPagesPointToTheMemory) {
+    auto ram = Memory::Make();
+    Bus bus;
+    bus.MapMemory(0x00, 0x10, ram);
+
+    bus.WriteByte(0x0234, 0x42);
+    EXPECT_EQ(ram->ReadByte(0x0234), 0x42);
+    EXPECT_EQ(bus.GetPage(0x02).m_Read, static_cast<Memory&>(*ram).GetData() + 0x0200);
+    EXPECT_EQ(bus.GetPage(0x02).m_Write, static_cast<Memory&>(*ram).GetData() + 0x0200);
+
+    bus.WriteWord(0x0FFF, 0xBEEF);
+    EXPECT_EQ(bus.ReadWord(0x0FFF), 0x00EF) << "the high byte went to an unmapped page";
+}
+
+TEST(Bus, RomIgnoresWrites) {
+    vector<Byte> rom(0x100, 0xEA);
+    Bus bus;
+    bus.MapRom(0xFF, 1, rom.data());
+    bus.WriteByte(0xFF10, 0x00);
+    EXPECT_EQ(bus.ReadByte(0xFF10), 0xEA);
+    EXPECT_EQ(rom[0x10], 0xEA);
+}
+
+TEST(Bus, DevicePagesDispatchWithTheFullAddress) {
+    auto device = make_shared<Recorder>();
+    Bus bus;
+    bus.MapDevice(0xD0, 2, device);
+
+    EXPECT_TRUE(bus.IsDevicePage(0xD1));
+    EXPECT_FALSE(bus.IsDevicePage(0xD2));
+    EXPECT_EQ(bus.ReadByte(0xD123), 0x23);
+    bus.WriteByte(0xD045, 7);
+    ASSERT_EQ(device->m_Reads.size(), 1u);
+    EXPECT_EQ(device->m_Reads[0], 0xD123);
+    ASSERT_EQ(device->m_Writes.size(), 1u);
+    EXPECT_EQ(device->m_Writes[0], make_pair(Word(0xD045), Byte(7)));
+
+    bus.Unmap(0xD0, 2);
+    EXPECT_EQ(bus.ReadByte(0xD123), 0);
+    bus.WriteByte(0xD045, 8);
+    EXPECT_EQ(device->m_Writes.size(), 1u);
+}
+
+TEST(Bus, BulkAccessesCrossPages) {
+    auto ram = Memory::Make(0x800);
+    Bus bus;
+    bus.MapMemory(0x00, 8, ram);
+
+    vector<Byte> bytes(300);
+    for(size_t i = 0; i < bytes.size(); i++) bytes[i] = i;
+    bus.WriteBytes(0x07F0, bytes);
+
+    vector<Byte> back(300, 0xFF);
+    bus.ReadBytes(0x07F0, back);
+    EXPECT_TRUE(equal(back.begin(), back.begin() + 16, bytes.begin()));
+    EXPECT_TRUE(all_of(back.begin() + 16, back.end(), [](const Byte byte) { return byte == 0; })) << "past the RAM is unmapped";
+}
+
+//A core on a Bus mapping RAM everywhere runs as one on the Memory itself
+TEST(Bus, CoreOnTheBusMatchesTheCoreOnMemory) {
+    mt19937 rng(3);
+    for(int round = 0; round < 100; round++) {
+        SCOPED_TRACE(round);
+        const vector<Byte> image = RandomImage(rng);
+        const Registers start = RandomRegisters(rng);
+
+        Memory memory;
+        copy(image.begin(), image.end(), memory.GetData());
+        CPUCore<Memory> reference(memory);
+        reference.SetRegisters(start);
+
+        vector<Byte> ram = image;
+        Bus bus;
+        bus.MapRam(0x00, 256, ram.data());
+        CPUCore<Bus> core(bus);
+        core.SetRegisters(start);
+
+        EXPECT_EQ(core.Run(2000), reference.Run(2000));
+        EXPECT_TRUE(core.GetRegisters() == reference.GetRegisters());
+        EXPECT_TRUE(equal(ram.begin(), ram.end(), memory.GetData()));
+    }
+}
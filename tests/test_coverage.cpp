@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <coverage.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    using CoverageCore = CPUCore<Memory, EdgeCoverage>;
+
+    constexpr size_t MAP_SIZE = 1 << 16;
+
+    //$0400 : LDX #2 ; loop : DEX ; BNE loop ; JMP $0400
+    void Boot(Memory& memory, CoverageCore& core) {
+        Load(memory, 0x0400, { 0xA2, 0x02, 0xCA, 0xD0, 0xFD, 0x4C, 0x00, 0x04 });
+        core.SetRegisters(StartAt(0x0400));
+    }
+
+    size_t Edges(const vector<Byte>& map) {
+        return count_if(map.begin(), map.end(), [](const Byte counter) { return counter != 0; });
+    }
+
+    size_t Hits(const vector<Byte>& map) {
+        return accumulate(map.begin(), map.end(), size_t { 0 });
+    }
+}
+
+TEST(Coverage, CountsTakenAndNotTakenBranchesApart) {
+    Memory memory;
+    vector<Byte> map(MAP_SIZE);
+    CoverageCore core(memory);
+    Boot(memory, core);
+    core.SetTracer(EdgeCoverage(map));
+
+    //LDX DEX BNE(taken) DEX BNE(not taken) JMP : the edge out of the JMP is only counted on the next instruction
+    core.Run(6);
+    EXPECT_EQ(Edges(map), 2u);
+    EXPECT_EQ(Hits(map), 2u);
+
+    core.Run(1);
+    EXPECT_EQ(Edges(map), 3u);
+
+    //Every later round takes the same three edges
+    core.Run(6 * 10);
+    EXPECT_EQ(Edges(map), 3u);
+    EXPECT_EQ(Hits(map), 3u + 3 * 10);
+}
+
+TEST(Coverage, CountersSaturate) {
+    Memory memory;
+    vector<Byte> map(MAP_SIZE);
+    CoverageCore core(memory);
+    Boot(memory, core);
+    core.SetTracer(EdgeCoverage(map));
+
+    core.Run(6 * 1000);
+    EXPECT_EQ(Edges(map), 3u);
+    EXPECT_EQ(*max_element(map.begin(), map.end()), 0xFF);
+}
+
+TEST(Coverage, ResetForgetsThePendingEdge) {
+    Memory memory;
+    vector<Byte> map(MAP_SIZE);
+    CoverageCore core(memory);
+    Boot(memory, core);
+    core.SetTracer(EdgeCoverage(map));
+
+    //Stops after the JMP
+    core.Run(6);
+    core.GetTracer().Reset();
+    fill(map.begin(), map.end(), 0);
+    core.Run(1);
+    EXPECT_EQ(Edges(map), 0u);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <cpu_batch.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+//Every lane, on its own memory, runs as a CPUCore<Memory> stepping the same instructions
+TEST(CPUBatch, LanesMatchTheCore) {
+    mt19937 rng(7);
+    constexpr size_t LANES = 100;
+    constexpr int STEPS = 500;
+    for(int round = 0; round < 5; round++) {
+        SCOPED_TRACE(round);
+        CPUBatch batch(LANES);
+        vector<vector<Byte>> images(LANES);
+        vector<Registers> starts(LANES);
+        for(size_t lane = 0; lane < LANES; lane++) {
+            images[lane] = RandomImage(rng);
+            starts[lane] = RandomRegisters(rng);
+            copy(images[lane].begin(), images[lane].end(), static_cast<Memory&>(*batch.GetMemory(lane)).GetData());
+            batch.SetRegisters(lane, starts[lane]);
+        }
+        batch.Run(STEPS);
+
+        for(size_t lane = 0; lane < LANES; lane++) {
+            SCOPED_TRACE(lane);
+            Memory memory;
+            copy(images[lane].begin(), images[lane].end(), memory.GetData());
+            CPUCore<Memory> core(memory);
+            core.SetRegisters(starts[lane]);
+            uint64_t cycles = 0;
+            for(int step = 0; step < STEPS && !core.IsHalted(); step++) cycles += core.Step();
+
+            EXPECT_TRUE(batch.GetRegisters(lane) == core.GetRegisters());
+            EXPECT_EQ(batch.GetCycles(lane), cycles);
+            EXPECT_EQ(batch.IsHalted(lane), core.IsHalted());
+            const Byte* lane_memory = static_cast<Memory&>(*batch.GetMemory(lane)).GetData();
+            EXPECT_TRUE(equal(lane_memory, lane_memory + 0x10000, memory.GetData()));
+        }
+    }
+}
+
+//Lanes start as a reset CPUCore does : PC from their memory's RESET vector, SP at $FD, interrupts disabled
+TEST(CPUBatch, LanesStartFromTheResetVector) {
+    auto memory = Memory::Make();
+    Memory& ram = static_cast<Memory&>(*memory);
+    //0200 : LDA #$42 ; STA $10 ; jam
+    Load(ram, 0x0200, { 0xA9, 0x42, 0x85, 0x10, 0x02 });
+    Load(ram, 0xFFFC, { 0x00, 0x02 });
+
+    CPUBatch batch(3, memory);
+    CPUCore<Memory> core(ram);
+    core.Reset();
+    for(size_t lane = 0; lane < batch.GetLaneCount(); lane++) {
+        EXPECT_TRUE(batch.GetRegisters(lane) == core.GetRegisters());
+        EXPECT_FALSE(batch.IsHalted(lane));
+    }
+
+    batch.Run(3);
+    EXPECT_EQ(ram.ReadByte(0x10), 0x42);
+    EXPECT_TRUE(batch.IsHalted(0));
+
+    //A lane given another program is reset again
+    auto other = Memory::Make();
+    Load(static_cast<Memory&>(*other), 0xFFFC, { 0x34, 0x12 });
+    batch.SetMemory(1, other);
+    batch.Reset(1);
+    EXPECT_EQ(batch.GetRegisters(1).m_PC, 0x1234);
+    EXPECT_FALSE(batch.IsHalted(1));
+}
+
+//The lanes write through the Memory : a snapshot taken before the run restores what they wrote
+TEST(CPUBatch, SharedMemoryRestores) {
+    auto memory = Memory::Make();
+    Memory& ram = static_cast<Memory&>(*memory);
+    //0200 : LDA #$42 ; STA $10 ; PHA ; JMP *
+    Load(ram, 0x0200, { 0xA9, 0x42, 0x85, 0x10, 0x48, 0x4C, 0x05, 0x02 });
+    const auto snapshot = ram.Snapshot();
+
+    CPUBatch batch(4, memory);
+    for(size_t lane = 0; lane < batch.GetLaneCount(); lane++) batch.SetRegisters(lane, StartAt(0x0200));
+    batch.Run(10);
+    EXPECT_EQ(ram.ReadByte(0x10), 0x42);
+    EXPECT_EQ(ram.ReadByte(0x1FF), 0x42);
+
+    ram.Restore(snapshot);
+    EXPECT_EQ(ram.ReadByte(0x10), 0x00);
+    EXPECT_EQ(ram.ReadByte(0x1FF), 0x00);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <cpu.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+//CPU runs through the IODevice interface, CPUCore<Memory> with its accesses inlined : they agree on everything
+TEST(CPUCore, MatchesTheAdapterOnRandomCode) {
+    mt19937 rng(2);
+    for(int round = 0; round < 200; round++) {
+        SCOPED_TRACE(round);
+        const vector<Byte> image = RandomImage(rng);
+        const Registers start = RandomRegisters(rng);
+
+        Memory memory;
+        copy(image.begin(), image.end(), memory.GetData());
+        CPUCore<Memory> core(memory);
+        core.SetRegisters(start);
+
+        auto device = Memory::Make();
+        auto& adapted = static_cast<Memory&>(*device);
+        copy(image.begin(), image.end(), adapted.GetData());
+        CPU cpu(device);
+        cpu.SetRegisters(start);
+
+        EXPECT_EQ(core.Run(2000), cpu.Run(2000));
+        EXPECT_TRUE(core.GetRegisters() == cpu.GetRegisters());
+        EXPECT_TRUE(equal(memory.GetData(), memory.GetData() + 0x10000, adapted.GetData()));
+    }
+}
+
+TEST(CPUCore, ResetLoadsTheVector) {
+    Memory memory;
+    Load(memory, 0xFFFC, { 0x34, 0x12 });
+    CPUCore<Memory> cpu(memory);
+    cpu.Reset();
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x1234);
+    EXPECT_EQ(cpu.GetStackPointer(), 0xFD);
+    EXPECT_TRUE(cpu.HasStatusFlag(StatusFlag::INTERRUPT));
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <bus.h>
+#include <debugger.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    using StopReason = DebugCPU::StopReason;
+
+    //Reads back the low byte of the address, keeps the last write
+    struct Latch : IODevice {
+        Byte m_Written = 0;
+
+        Byte ReadByte(const address& addr) const override { return addr.GetRecord(); }
+        Word ReadWord(const address& addr) const override { return MAKE_WORD(ReadByte(addr.GetValue() + 1), ReadByte(addr)); }
+        void WriteByte(const address& addr, const Byte data) override { m_Written = data; }
+        void WriteWord(const address& addr, const Word data) override { WriteByte(addr, data & 0xFF); WriteByte(addr.GetValue() + 1, data >> 8); }
+    };
+
+    //$0400 : LDX #0 ; loop : INC $2000,X ; INX ; BNE loop ; INC $3000 ; JMP $0400
+    void Boot(Bus& bus) {
+        bus.MapMemory(0x00, 0x100, Memory::Make());
+        Load(bus, 0x0400, { 0xA2, 0x00, 0xFE, 0x00, 0x20, 0xE8, 0xD0, 0xFA, 0xEE, 0x00, 0x30, 0x4C, 0x00, 0x04 });
+        Load(bus, 0xFFFC, { 0x00, 0x04 });
+    }
+}
+
+TEST(Debugger, StopsOnBreakpointsAndResumes) {
+    Bus bus;
+    Boot(bus);
+    DebugCPU cpu(bus);
+    cpu.Reset();
+
+    const uint32_t id = cpu.AddBreakpoint(0x0408);
+    EXPECT_EQ(cpu.GetTraps(0x04), TRAP_EXECUTE);
+    cpu.Run(100000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::BREAKPOINT);
+    EXPECT_EQ(cpu.GetStop().m_Id, id);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0408);
+    EXPECT_EQ(bus.ReadByte(0x3000), 0x00);
+
+    //The INC $3000 it stopped on runs, then the whole loop again
+    cpu.Run(100000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::BREAKPOINT);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0408);
+    EXPECT_EQ(bus.ReadByte(0x3000), 0x01);
+    EXPECT_EQ(bus.ReadByte(0x2000), 0x02);
+
+    cpu.RemoveBreakpoint(id);
+    EXPECT_EQ(cpu.GetTraps(0x04), 0);
+    cpu.Run(1000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::NONE);
+}
+
+TEST(Debugger, ChecksConditionsWhenHit) {
+    Bus bus;
+    Boot(bus);
+    DebugCPU cpu(bus);
+    cpu.Reset();
+
+    cpu.AddBreakpoint(0x0402, [](const Registers& registers) { return registers.m_X == 0x80; });
+    cpu.Run(100000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::BREAKPOINT);
+    EXPECT_EQ(cpu.GetRegisters().m_X, 0x80);
+    EXPECT_EQ(bus.ReadByte(0x207F), 0x01);
+    EXPECT_EQ(bus.ReadByte(0x2080), 0x00);
+}
+
+TEST(Debugger, StopsAfterWatchedAccesses) {
+    Bus bus;
+    Boot(bus);
+    DebugCPU cpu(bus);
+    cpu.Reset();
+
+    const uint32_t write = cpu.AddWatchpoint(0x2010, 0x2010, TRAP_WRITE);
+    cpu.Run(100000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::WRITE);
+    EXPECT_EQ(cpu.GetStop().m_Id, write);
+    EXPECT_EQ(cpu.GetStop().m_Address, 0x2010);
+    EXPECT_EQ(cpu.GetStop().m_Value, 0x01);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0405) << "stops right after the INC";
+    EXPECT_EQ(bus.ReadByte(0x2010), 0x01) << "the write went through";
+    cpu.RemoveWatchpoint(write);
+
+    cpu.AddWatchpoint(0x3000, 0x3000, TRAP_READ);
+    cpu.Run(100000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::READ);
+    EXPECT_EQ(cpu.GetStop().m_Address, 0x3000);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x040B);
+
+    cpu.ClearTraps();
+    cpu.Run(1000);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::NONE);
+}
+
+TEST(Debugger, StepsOverBreakpoints) {
+    Bus bus;
+    Boot(bus);
+    DebugCPU cpu(bus);
+    cpu.Reset();
+
+    cpu.AddBreakpoint(0x0400);
+    cpu.Step();
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0402);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::NONE);
+}
+
+TEST(Debugger, RemapsOnlyTheWatchedPages) {
+    Bus bus;
+    Boot(bus);
+    const Bus::Page page = bus.GetPage(0x20);
+    {
+        DebugCPU cpu(bus);
+        cpu.AddBreakpoint(0x0400);
+        EXPECT_FALSE(bus.IsDevicePage(0x04)) << "breakpoints leave the bus alone";
+
+        cpu.AddWatchpoint(0x2000, 0x20FF, TRAP_WRITE);
+        EXPECT_EQ(bus.GetPage(0x20).m_Read, page.m_Read) << "reads of a write-watched page stay direct";
+        EXPECT_EQ(bus.GetPage(0x20).m_Write, nullptr);
+        EXPECT_EQ(bus.GetPage(0x21).m_Write, bus.GetPage(0x1F).m_Write + 0x200);
+
+        //The host's accesses aren't watched
+        bus.WriteByte(0x2000, 0x55);
+        EXPECT_EQ(bus.ReadByte(0x2000), 0x55);
+
+        cpu.AddWatchpoint(0x2080, 0x2080, TRAP_READ);
+        EXPECT_EQ(cpu.GetTraps(0x20), TRAP_READ | TRAP_WRITE);
+        EXPECT_EQ(bus.GetPage(0x20).m_Read, nullptr);
+    }
+    EXPECT_EQ(bus.GetPage(0x20).m_Read, page.m_Read) << "the core maps the pages back";
+    EXPECT_EQ(bus.GetPage(0x20).m_Write, page.m_Write);
+    EXPECT_EQ(bus.GetPage(0x20).m_Device, nullptr);
+}
+
+TEST(Debugger, WatchesDevicePages) {
+    Bus bus;
+    Boot(bus);
+    auto latch = make_shared<Latch>();
+    bus.MapDevice(0xD0, 1, latch);
+    //$0400 : LDA $D042 ; STA $D010 ; JMP $0400
+    Load(bus, 0x0400, { 0xAD, 0x42, 0xD0, 0x8D, 0x10, 0xD0, 0x4C, 0x00, 0x04 });
+
+    DebugCPU cpu(bus);
+    cpu.Reset();
+    cpu.AddWatchpoint(0xD010, 0xD010, TRAP_WRITE);
+    cpu.Run(100);
+    EXPECT_EQ(cpu.GetStop().m_Reason, StopReason::WRITE);
+    EXPECT_EQ(cpu.GetStop().m_Value, 0x42);
+    EXPECT_EQ(latch->m_Written, 0x42);
+
+    cpu.ClearTraps();
+    EXPECT_EQ(bus.GetPage(0xD0).m_Device, latch.get());
+}
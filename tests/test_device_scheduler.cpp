@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <block_cache.h>
+#include <bus.h>
+#include <cpu_core.h>
+#include <device_scheduler.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //Raises IRQ line 2 every `period` cycles. Register 0 : low byte of the cycles until the next one,
+    //register 1 : whether one is pending, reading it acknowledges it.
+    struct Timer : IODevice {
+        DeviceScheduler& m_Scheduler;
+        uint64_t m_Period;
+        uint64_t m_Next = 0;
+        int m_Fired = 0;
+        mutable bool m_Pending = false;
+
+        Timer(DeviceScheduler& scheduler, const uint64_t period) : m_Scheduler(scheduler), m_Period(period) {}
+
+        DeviceTask Run() {
+            for(;;) {
+                m_Next = m_Scheduler.GetCycles() + m_Period;
+                co_await m_Scheduler.Cycles(m_Period);
+                m_Fired++;
+                m_Pending = true;
+                m_Scheduler.AssertIRQ(2);
+            }
+        }
+
+        Byte ReadByte(const address& addr) const override {
+            m_Scheduler.CatchUp();
+            if(addr.GetRecord() == 1) {
+                const bool pending = m_Pending;
+                m_Pending = false;
+                m_Scheduler.ReleaseIRQ(2);
+                return pending;
+            }
+            return static_cast<Byte>(m_Next - m_Scheduler.GetCycles());
+        }
+
+        Word ReadWord(const address& addr) const override { return ReadByte(addr); }
+        void WriteByte(const address& addr, const Byte data) override {}
+        void WriteWord(const address& addr, const Word data) override {}
+    };
+
+    //A write starts sending the byte, for 100 cycles. Reads are 1 while it sends.
+    struct Uart : IODevice {
+        DeviceScheduler& m_Scheduler;
+        BusSignal<Byte> m_Transmit { m_Scheduler };
+        bool m_Busy = false;
+        string m_Output;
+        vector<uint64_t> m_Sent;
+
+        explicit Uart(DeviceScheduler& scheduler) : m_Scheduler(scheduler) {}
+
+        DeviceTask Run() {
+            for(;;) {
+                const Byte data = co_await m_Transmit;
+                m_Busy = true;
+                co_await m_Scheduler.Cycles(100);
+                m_Output.push_back(data);
+                m_Sent.push_back(m_Scheduler.GetCycles());
+                m_Busy = false;
+            }
+        }
+
+        Byte ReadByte(const address& addr) const override {
+            m_Scheduler.CatchUp();
+            return m_Busy;
+        }
+
+        Word ReadWord(const address& addr) const override { return ReadByte(addr); }
+
+        void WriteByte(const address& addr, const Byte data) override {
+            m_Scheduler.CatchUp();
+            if(!m_Busy) m_Transmit.Notify(data);
+        }
+
+        void WriteWord(const address& addr, const Word data) override {}
+    };
+
+    struct Failing : IODevice {
+        DeviceScheduler& m_Scheduler;
+
+        explicit Failing(DeviceScheduler& scheduler) : m_Scheduler(scheduler) {}
+
+        DeviceTask Run() {
+            co_await m_Scheduler.Cycles(500);
+            throw runtime_error("device failure");
+        }
+
+        Byte ReadByte(const address& addr) const override { return 0; }
+        Word ReadWord(const address& addr) const override { return 0; }
+        void WriteByte(const address& addr, const Byte data) override {}
+        void WriteWord(const address& addr, const Word data) override {}
+    };
+
+    constexpr const char* MESSAGE = "hello, coroutines";
+
+    //Prints MESSAGE on the UART, waiting while it sends, and counts the timer's IRQs at $10
+    template<typename Timing>
+    void PrintsAndCountsInterrupts() {
+        const auto bus = Bus::Make();
+        bus->MapMemory(0x00, 0xD0, Memory::Make());
+        bus->MapMemory(0xE0, 0x20, Memory::Make(), 0xE000);
+        DeviceScheduler scheduler;
+        const auto timer = make_shared<Timer>(scheduler, 1000);
+        const auto uart = make_shared<Uart>(scheduler);
+        bus->MapDevice(0xD0, 1, timer);
+        bus->MapDevice(0xD1, 1, uart);
+
+        //$E000 : CLI ; LDX #0 ; loop : LDA $F000,X ; BEQ done ; wait : LDY $D100 ; BNE wait ; STA $D100 ; INX ; JMP loop ; done : JMP done
+        Load(*bus, 0xE000, { 0x58, 0xA2, 0x00, 0xBD, 0x00, 0xF0, 0xF0, 0x0C, 0xAC, 0x00, 0xD1, 0xD0, 0xFB, 0x8D, 0x00, 0xD1, 0xE8, 0x4C, 0x03, 0xE0, 0x4C, 0x14, 0xE0 });
+        //$E100 : PHA ; LDA $D001 ; INC $10 ; PLA ; RTI
+        Load(*bus, 0xE100, { 0x48, 0xAD, 0x01, 0xD0, 0xE6, 0x10, 0x68, 0x40 });
+        for(size_t i = 0; i <= strlen(MESSAGE); i++) bus->WriteByte(0xF000 + i, MESSAGE[i]);
+        bus->WriteWord(0xFFFC, 0xE000);
+        bus->WriteWord(0xFFFE, 0xE100);
+
+        CPUCore<Bus, NoTrace, Timing> core(*bus);
+        scheduler.Attach(core);
+        scheduler.Spawn(timer->Run());
+        scheduler.Spawn(uart->Run());
+        core.RunFor(20500);
+
+        EXPECT_EQ(uart->m_Output, MESSAGE);
+        EXPECT_EQ(timer->m_Fired, 20);
+        EXPECT_EQ(bus->ReadByte(0x10), 20) << "every IRQ was handled";
+        for(size_t i = 1; i < uart->m_Sent.size(); i++) EXPECT_GE(uart->m_Sent[i] - uart->m_Sent[i - 1], 100u);
+    }
+
+    //$0400 : LDA $D000 ; STA $20 ; NOP ; LDA $D000 ; STA $21
+    shared_ptr<Bus> TimerReads() {
+        const auto bus = Bus::Make();
+        bus->MapMemory(0x00, 0xD0, Memory::Make());
+        bus->MapMemory(0xE0, 0x20, Memory::Make(), 0xE000);
+        Load(*bus, 0x0400, { 0xAD, 0x00, 0xD0, 0x85, 0x20, 0xEA, 0xAD, 0x00, 0xD0, 0x85, 0x21 });
+        bus->WriteWord(0xFFFC, 0x0400);
+        return bus;
+    }
+}
+
+TEST(DeviceScheduler, RunsDevicesAlongFastTiming) {
+    PrintsAndCountsInterrupts<FastTiming>();
+}
+
+TEST(DeviceScheduler, RunsDevicesAlongCycleExactTiming) {
+    PrintsAndCountsInterrupts<CycleExact>();
+}
+
+TEST(DeviceScheduler, CatchesUpToTheAccessCycle) {
+    const auto bus = TimerReads();
+    DeviceScheduler scheduler;
+    const auto timer = make_shared<Timer>(scheduler, 200);
+    bus->MapDevice(0xD0, 1, timer);
+    CPUCore<Bus, NoTrace, CycleExact> core(*bus);
+    scheduler.Attach(core);
+    scheduler.Spawn(timer->Run());
+    for(int i = 0; i < 5; i++) core.Step();
+
+    //The first read on cycle 3, the second LDA starts on cycle 4 + 3 + 2 = 9 and reads on cycle 12
+    EXPECT_EQ(bus->ReadByte(0x20), 197);
+    EXPECT_EQ(bus->ReadByte(0x21), 188);
+}
+
+TEST(DeviceScheduler, CatchesUpToTheInstructionOnFastTiming) {
+    const auto bus = TimerReads();
+    DeviceScheduler scheduler;
+    const auto timer = make_shared<Timer>(scheduler, 200);
+    bus->MapDevice(0xD0, 1, timer);
+    CPUCore<Bus> core(*bus);
+    scheduler.Attach(core);
+    scheduler.Spawn(timer->Run());
+    for(int i = 0; i < 5; i++) core.Step();
+
+    //Whole instructions : the reads see the cycle their instruction started on
+    EXPECT_EQ(bus->ReadByte(0x20), 200);
+    EXPECT_EQ(bus->ReadByte(0x21), 191);
+}
+
+//Inside Run() too, where the core otherwise counts the cycles once the slice is done
+TEST(DeviceScheduler, CatchesUpWithinRuns) {
+    const auto bus = TimerReads();
+    DeviceScheduler scheduler;
+    const auto timer = make_shared<Timer>(scheduler, 200);
+    bus->MapDevice(0xD0, 1, timer);
+    CPUCore<Bus> core(*bus);
+    scheduler.Attach(core);
+    scheduler.Spawn(timer->Run());
+    core.Run(5);
+
+    EXPECT_EQ(bus->ReadByte(0x20), 200);
+    EXPECT_EQ(bus->ReadByte(0x21), 191);
+}
+
+TEST(DeviceScheduler, CatchesUpWithinCachedBlocks) {
+    const auto bus = TimerReads();
+    DeviceScheduler scheduler;
+    const auto timer = make_shared<Timer>(scheduler, 200);
+    bus->MapDevice(0xD0, 1, timer);
+    CachedCPU<Bus> core(*bus);
+    scheduler.Attach(core);
+    scheduler.Spawn(timer->Run());
+    core.Run(5);
+
+    EXPECT_EQ(bus->ReadByte(0x20), 200);
+    EXPECT_EQ(bus->ReadByte(0x21), 191);
+}
+
+TEST(DeviceScheduler, DeviceExceptionsLeaveTheRunningLoop) {
+    Memory memory;
+    DeviceScheduler scheduler;
+    Failing device(scheduler);
+    CPUCore<Memory> core(memory);
+    scheduler.Attach(core);
+    scheduler.Spawn(device.Run());
+
+    EXPECT_THROW(core.RunFor(10000), runtime_error);
+    //The device is done, the core runs on
+    EXPECT_NO_THROW(core.RunFor(10000));
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    constexpr Byte C = static_cast<Byte>(StatusFlag::CARRY);
+    constexpr Byte Z = static_cast<Byte>(StatusFlag::ZERO);
+    constexpr Byte V = static_cast<Byte>(StatusFlag::INT_OVERFLOW);
+    constexpr Byte N = static_cast<Byte>(StatusFlag::NEGATIVE);
+    constexpr Byte NZCV = N | Z | C | V;
+
+    Byte NZ(const Byte value) { return (value ? 0 : Z) | (value & N); }
+
+    //Runs `code operand` once from A = a, carry = carry, returns the status byte
+    Byte RunImmediate(CPUCore<Memory>& cpu, Memory& memory, const Byte code, const Byte a, const Byte operand, const bool carry) {
+        Load(memory, 0x0200, { code, operand });
+        Registers registers = StartAt(0x0200);
+        registers.m_Acc = a;
+        registers.m_CpuStatus = registers.m_CpuStatus.m_Value | (carry ? C : 0);
+        cpu.SetRegisters(registers);
+        cpu.Step();
+        return cpu.GetStatus().m_Value;
+    }
+}
+
+//N, Z, C and V come out of the lazy evaluation as the 6502 sets them, for every input
+TEST(StatusFlags, ArithmeticAndCompares) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    for(int a = 0; a < 256; a++) for(int m = 0; m < 256; m++) for(int carry = 0; carry < 2; carry++) {
+        const int sum = a + m + carry;
+        const Byte adc = static_cast<Byte>(sum);
+        const Byte adc_flags = NZ(adc) | (sum > 0xFF ? C : 0) | ((~(a ^ m) & (a ^ adc) & 0x80) ? V : 0);
+        ASSERT_EQ(RunImmediate(cpu, memory, 0x69, a, m, carry) & NZCV, adc_flags) << a << " + " << m << " + " << carry;
+        ASSERT_EQ(cpu.GetAccumulator(), adc);
+
+        const int difference = a - m - !carry;
+        const Byte sbc = static_cast<Byte>(difference);
+        const Byte sbc_flags = NZ(sbc) | (difference >= 0 ? C : 0) | (((a ^ m) & (a ^ sbc) & 0x80) ? V : 0);
+        ASSERT_EQ(RunImmediate(cpu, memory, 0xE9, a, m, carry) & NZCV, sbc_flags) << a << " - " << m << " - " << !carry;
+
+        //CMP leaves V alone
+        const Byte cmp_flags = NZ(static_cast<Byte>(a - m)) | (a >= m ? C : 0);
+        ASSERT_EQ(RunImmediate(cpu, memory, 0xC9, a, m, carry) & (N | Z | C), cmp_flags);
+
+        const Byte and_flags = NZ(a & m) | (carry ? C : 0);
+        ASSERT_EQ(RunImmediate(cpu, memory, 0x29, a, m, carry) & (N | Z | C), and_flags);
+    }
+}
+
+//Shifts and rotates through the carry, on the accumulator
+TEST(StatusFlags, Shifts) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    for(int a = 0; a < 256; a++) for(int carry = 0; carry < 2; carry++) {
+        const Byte asl = a << 1, lsr = a >> 1, rol = (a << 1) | carry, ror = (a >> 1) | (carry << 7);
+        EXPECT_EQ(RunImmediate(cpu, memory, 0x0A, a, 0, carry) & (N | Z | C), NZ(asl) | (a & 0x80 ? C : 0));
+        EXPECT_EQ(RunImmediate(cpu, memory, 0x4A, a, 0, carry) & (N | Z | C), NZ(lsr) | (a & 0x01 ? C : 0));
+        EXPECT_EQ(RunImmediate(cpu, memory, 0x2A, a, 0, carry) & (N | Z | C), NZ(rol) | (a & 0x80 ? C : 0));
+        EXPECT_EQ(RunImmediate(cpu, memory, 0x6A, a, 0, carry) & (N | Z | C), NZ(ror) | (a & 0x01 ? C : 0));
+        EXPECT_EQ(cpu.GetAccumulator(), ror);
+    }
+}
+
+//BIT takes N and V from memory, Z from A & M
+TEST(StatusFlags, Bit) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    for(int a = 0; a < 256; a += 3) for(int m = 0; m < 256; m++) {
+        Load(memory, 0x0010, { static_cast<Byte>(m) });
+        EXPECT_EQ(RunImmediate(cpu, memory, 0x24, a, 0x10, false) & (N | Z | V), (m & (N | V)) | ((a & m) ? 0 : Z));
+    }
+}
+
+//The packed byte survives a PHP / PLP, and the single flag accessors agree with it
+TEST(StatusFlags, PushPullAndAccessors) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    //0200 : LDA #$80 ; PHP ; LDA #$00 ; PLP
+    Load(memory, 0x0200, { 0xA9, 0x80, 0x08, 0xA9, 0x00, 0x28 });
+    cpu.SetRegisters(StartAt(0x0200));
+    cpu.Run(4);
+    EXPECT_TRUE(cpu.HasStatusFlag(StatusFlag::NEGATIVE));
+    EXPECT_FALSE(cpu.HasStatusFlag(StatusFlag::ZERO));
+    EXPECT_EQ(memory.ReadByte(0x01FF) & (N | Z), N);
+
+    cpu.SetStatusFlag(StatusFlag::ZERO);
+    cpu.SetStatusFlag(StatusFlag::NEGATIVE, false);
+    cpu.SetStatusFlag(StatusFlag::INT_OVERFLOW);
+    EXPECT_EQ(cpu.GetStatus().m_Value & NZCV, Z | V);
+    EXPECT_TRUE(cpu.HasStatusFlag(StatusFlag::ZERO));
+    EXPECT_FALSE(cpu.HasStatusFlag(StatusFlag::NEGATIVE));
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bus.h>
+#include <cpu_core.h>
+#include <jit.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //An enabled trace policy records every instruction : idle loops are interpreted, the reference
+    struct Interpreted {
+        static constexpr bool ENABLED = true;
+        void Record(const TraceRecord&) {}
+    };
+
+    //0400 : LDA #0 ; STA $10 ; CLI
+    //0405 : wait : LDA $10 ; BEQ wait ; INC $11 ; LDA #0 ; STA $10 ; LDA $11 ; CMP #$40 ; BNE wait ; JMP *
+    //IRQ handler 0500 : INC $12 ; PHA ; LDA #1 ; STA $10 ; PLA ; RTI
+    template<typename Core, typename BusPolicy>
+    void Boot(Core& cpu, BusPolicy& bus) {
+        Load(bus, 0x0400, { 0xA9, 0x00, 0x85, 0x10, 0x58, 0xA5, 0x10, 0xF0, 0xFC, 0xE6, 0x11, 0xA9, 0x00, 0x85, 0x10,
+                            0xA5, 0x11, 0xC9, 0x40, 0xD0, 0xF0, 0x4C, 0x15, 0x04 });
+        Load(bus, 0x0500, { 0xE6, 0x12, 0x48, 0xA9, 0x01, 0x85, 0x10, 0x68, 0x40 });
+        Load(bus, 0xFFFC, { 0x00, 0x04, 0x00, 0x05 });
+        cpu.Reset();
+    }
+
+    //Raises the IRQ line every `period` cycles, for 20 cycles
+    template<typename Core>
+    void Timer(Core& cpu, const uint64_t period) {
+        cpu.Schedule(cpu.GetCycles() + period, [&cpu, period]() {
+            cpu.AssertIRQ();
+            cpu.Schedule(cpu.GetCycles() + 20, [&cpu]() { cpu.ReleaseIRQ(); });
+            Timer(cpu, period);
+        });
+    }
+
+    template<typename A, typename B>
+    void ExpectSame(A& a, B& b, const Memory& memory_a, const Memory& memory_b) {
+        ASSERT_EQ(a.GetCycles(), b.GetCycles());
+        ASSERT_EQ(a.GetProgramCounter(), b.GetProgramCounter());
+        ASSERT_EQ(a.GetAccumulator(), b.GetAccumulator());
+        ASSERT_EQ(a.GetStatus().m_Value, b.GetStatus().m_Value);
+        ASSERT_TRUE(equal(memory_a.GetData(), memory_a.GetData() + 0x10000, memory_b.GetData()));
+    }
+}
+
+//Skipping the busy-waits gives the cycles, registers and memory interpreting them does
+TEST(IdleLoops, SkippingMatchesInterpreting) {
+    for(const uint64_t period : { 97, 1000, 12345, 100000 }) {
+        SCOPED_TRACE(period);
+        Memory fast_memory, slow_memory;
+        CPUCore<Memory> fast(fast_memory);
+        CPUCore<Memory, Interpreted> slow(slow_memory);
+        Boot(fast, fast_memory);
+        Boot(slow, slow_memory);
+        Timer(fast, period);
+        Timer(slow, period);
+
+        for(int i = 0; i < 100; i++) {
+            fast.RunFor(7777);
+            slow.RunFor(7777);
+            ExpectSame(fast, slow, fast_memory, slow_memory);
+        }
+        for(int i = 0; i < 100; i++) {
+            fast.Run(3333);
+            slow.Run(3333);
+            ExpectSame(fast, slow, fast_memory, slow_memory);
+        }
+    }
+}
+
+//The block cache and the JIT take interrupts between blocks : they run alike, and the program does what it does interpreted
+TEST(IdleLoops, SkippingMatchesOnTheJit) {
+    auto cached_memory = Memory::Make(), jit_memory = Memory::Make();
+    auto cached_bus = Bus::Make(), jit_bus = Bus::Make();
+    cached_bus->MapMemory(0x00, 256, cached_memory);
+    jit_bus->MapMemory(0x00, 256, jit_memory);
+    JitCPU cached(*cached_bus, ExecutionMode::INTERPRETER), jit(*jit_bus, ExecutionMode::JIT);
+    Memory slow_memory;
+    CPUCore<Memory, Interpreted> slow(slow_memory);
+    Boot(cached, *cached_bus);
+    Boot(jit, *jit_bus);
+    Boot(slow, slow_memory);
+    Timer(cached, 1000);
+    Timer(jit, 1000);
+    Timer(slow, 1000);
+
+    for(int i = 0; i < 100; i++) {
+        cached.Run(3333);
+        jit.Run(3333);
+        slow.Run(3333);
+        ExpectSame(jit, cached, static_cast<Memory&>(*jit_memory), static_cast<Memory&>(*cached_memory));
+    }
+    //$40 wake ups, then JMP *
+    EXPECT_EQ(jit.GetProgramCounter(), 0x0415);
+    EXPECT_EQ(slow.GetProgramCounter(), 0x0415);
+    EXPECT_EQ(jit_memory->ReadByte(0x11), 0x40);
+    EXPECT_EQ(slow_memory.ReadByte(0x11), 0x40);
+}
+
+//JMP * with nothing scheduled : the whole budget goes in one skip
+TEST(IdleLoops, FastForwardsToTheBudget) {
+    Memory memory;
+    CPUCore<Memory> cpu(memory);
+    Load(memory, 0x0400, { 0x58, 0x4C, 0x01, 0x04 });
+    Load(memory, 0xFFFC, { 0x00, 0x04 });
+    cpu.Reset();
+    const uint64_t budget = 10000000000;
+    const uint64_t cycles = cpu.RunFor(budget);
+    EXPECT_GE(cycles, budget);
+    EXPECT_LT(cycles, budget + 3);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0401);
+}
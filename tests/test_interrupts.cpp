@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <block_cache.h>
+#include <bus.h>
+#include <cpu_core.h>
+#include <jit.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //0200 : CLI ; loop : INX ; JMP loop      IRQ / NMI handler 0300 : INC $10 ; RTI
+    shared_ptr<Bus> MakeMachine(Memory*& ram) {
+        auto bus = Bus::Make();
+        auto memory = Memory::Make();
+        bus->MapMemory(0x00, 256, memory);
+        ram = &static_cast<Memory&>(*memory);
+        Load(*ram, 0x0200, { 0x58, 0xE8, 0x4C, 0x01, 0x02 });
+        Load(*ram, 0x0300, { 0xE6, 0x10, 0x40 });
+        Load(*ram, 0xFFFA, { 0x00, 0x03, 0x00, 0x02, 0x00, 0x03 });
+        return bus;
+    }
+
+    //A timer raising the IRQ line every 1000 cycles, released 5 cycles later : the handler runs once per tick
+    template<typename Core>
+    void PeriodicIrq() {
+        Memory* ram = nullptr;
+        auto bus = MakeMachine(ram);
+        Core cpu(*bus);
+        cpu.Reset();
+
+        int ticks = 0;
+        function<void()> tick = [&]() {
+            ticks++;
+            cpu.AssertIRQ();
+            cpu.Schedule(cpu.GetCycles() + 5, [&]() { cpu.ReleaseIRQ(); });
+            cpu.Schedule(cpu.GetCycles() + 1000, tick);
+        };
+        cpu.Schedule(1000, tick);
+        while(cpu.GetCycles() < 100500) cpu.Run(100);
+
+        EXPECT_EQ(ticks, 100);
+        EXPECT_EQ(ram->ReadByte(0x10), 100);
+    }
+}
+
+TEST(Interrupts, PeriodicIrqOnTheCore) { PeriodicIrq<CPUCore<Bus>>(); }
+TEST(Interrupts, PeriodicIrqOnTheBlockCache) { PeriodicIrq<CachedCPU<Bus>>(); }
+TEST(Interrupts, PeriodicIrqOnTheJit) { PeriodicIrq<JitCPU>(); }
+
+//NMI is an edge : one trigger, one handler run, whatever the I flag
+TEST(Interrupts, NmiIgnoresTheMask) {
+    Memory* ram = nullptr;
+    auto bus = MakeMachine(ram);
+    CPUCore<Bus> cpu(*bus);
+    cpu.Reset();
+    cpu.Run(1);
+    cpu.SetStatusFlag(StatusFlag::INTERRUPT);
+    cpu.TriggerNMI();
+    cpu.RunFor(100);
+    EXPECT_EQ(ram->ReadByte(0x10), 1);
+}
+
+//A masked IRQ line is held until CLI, a jammed CPU only answers to RESET
+TEST(Interrupts, MaskedIrqWaitsForCli) {
+    Memory* ram = nullptr;
+    auto bus = MakeMachine(ram);
+    CPUCore<Bus> cpu(*bus);
+    cpu.Reset();
+    cpu.AssertIRQ();
+    cpu.Step();
+    EXPECT_EQ(ram->ReadByte(0x10), 0) << "the CLI runs before the line is looked at";
+    cpu.RunFor(20);
+    EXPECT_GT(ram->ReadByte(0x10), 0);
+    cpu.ReleaseIRQ();
+
+    Load(*ram, 0x0201, { 0x02 });
+    cpu.RunFor(100);
+    EXPECT_TRUE(cpu.IsHalted());
+    cpu.TriggerNMI();
+    cpu.RunFor(100);
+    EXPECT_TRUE(cpu.IsHalted());
+
+    Load(*ram, 0x0201, { 0xE8 });
+    cpu.TriggerReset();
+    cpu.RunFor(100);
+    EXPECT_FALSE(cpu.IsHalted());
+    EXPECT_GT(cpu.GetX(), 0);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <bus.h>
+#include <cpu_core.h>
+#include <jit.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //Compiles every block on its first visit, so that random code runs natively as much as it can
+    struct EagerJit : JitCPU {
+        using JitCPU::JitCPU;
+
+        uint64_t m_NativeInstructions = 0;
+
+        uint64_t RunEager(uint64_t instructions) {
+            const uint64_t start = m_Cycles;
+            while(instructions && !m_Halted) {
+                Block* block = Lookup(m_PC);
+                if(!block) {
+                    m_Cycles += Dispatch();
+                    instructions--;
+                    continue;
+                }
+                if(!block->m_Native && !block->m_NativeFailed && !Compile(*block)) continue;
+                if(block->m_Native && block->m_NativeOps <= instructions) {
+                    m_CpuStatus = GetStatus();
+                    const uint64_t result = reinterpret_cast<NativeBlock>(block->m_Native)(this);
+                    SetStatus(m_CpuStatus);
+                    m_Cycles += static_cast<uint32_t>(result);
+                    instructions -= result >> 32;
+                    m_NativeInstructions += result >> 32;
+                    continue;
+                }
+                m_Cycles += Interpret(*block, instructions);
+            }
+            return m_Cycles - start;
+        }
+
+        bool IsNative(const Word pc) {
+            const Block* block = Lookup(pc);
+            return block && block->m_Native;
+        }
+    };
+
+    //RAM everywhere, with the reset vector on `pc`
+    shared_ptr<Bus> MakeMachine(Memory*& ram, const Word pc) {
+        auto bus = Bus::Make();
+        auto memory = Memory::Make();
+        bus->MapMemory(0x00, 256, memory);
+        ram = &static_cast<Memory&>(*memory);
+        Load(*ram, 0xFFFC, { static_cast<Byte>(pc & 0xFF), static_cast<Byte>(pc >> 8) });
+        return bus;
+    }
+
+    constexpr bool HAS_JIT =
+#if defined(__x86_64__) && defined(__unix__)
+        true;
+#else
+        false;
+#endif
+}
+
+//Random code run natively matches the interpreter : registers, memory and cycles, ROM pages included
+TEST(JitCPU, MatchesTheCoreOnRandomCode) {
+    mt19937 rng(5);
+    uint64_t native = 0;
+    for(int round = 0; round < 300; round++) {
+        SCOPED_TRACE(round);
+        vector<Byte> image = RandomImage(rng);
+        //BRK vectors through random memory, which the translated code never reaches anyway
+        for(Byte& byte : image) if(byte == 0x00) byte = 0xEA;
+        const Registers start = RandomRegisters(rng);
+
+        vector<Byte> reference_ram = image, ram = image;
+        Bus reference_bus, bus;
+        reference_bus.MapRam(0x00, 256, reference_ram.data());
+        bus.MapRam(0x00, 256, ram.data());
+        if(round % 3 == 1) {
+            reference_bus.MapRom(0x80, 0x10, image.data() + 0x8000);
+            bus.MapRom(0x80, 0x10, image.data() + 0x8000);
+        }
+
+        CPUCore<Bus> reference(reference_bus);
+        EagerJit cpu(bus);
+        reference.SetRegisters(start);
+        cpu.SetRegisters(start);
+
+        EXPECT_EQ(cpu.RunEager(3000), reference.Run(3000));
+        EXPECT_TRUE(cpu.GetRegisters() == reference.GetRegisters());
+        EXPECT_TRUE(ram == reference_ram);
+        native += cpu.m_NativeInstructions;
+    }
+    if(HAS_JIT) EXPECT_GT(native, 0u);
+}
+
+//Hot counting loops are translated, busy-waits are left to the idle loop detection
+TEST(JitCPU, CompilesHotLoops) {
+    if(!HAS_JIT) GTEST_SKIP() << "no native code on this host";
+
+    Memory* ram = nullptr;
+    //0200 : LDX #0 ; DEX ; BNE $0202 ; JMP $0200
+    auto counting_bus = MakeMachine(ram, 0x0200);
+    Load(*ram, 0x0200, { 0xA2, 0x00, 0xCA, 0xD0, 0xFD, 0x4C, 0x00, 0x02 });
+    EagerJit counting(*counting_bus);
+    counting.Reset();
+    counting.Run(100000);
+    EXPECT_TRUE(counting.IsNative(0x0202));
+
+    //0300 : LDA $10 ; BEQ $0300
+    auto busy_bus = MakeMachine(ram, 0x0300);
+    Load(*ram, 0x0300, { 0xA5, 0x10, 0xF0, 0xFC });
+    EagerJit busy(*busy_bus);
+    busy.Reset();
+    busy.Schedule(1000000, [](){});
+    busy.Run(100000);
+    EXPECT_FALSE(busy.IsNative(0x0300));
+}
+
+//An IRQ held while masked is taken right after a native CLI, as on the interpreter
+TEST(JitCPU, HeldIrqAfterCli) {
+    Memory* ram = nullptr;
+    auto bus = MakeMachine(ram, 0x0210);
+    //0210 : SEI ; INX ; JMP $0220      0220 : CLI ; INY ; JMP $0210      handler 0300 : INC $12 ; JMP $0302
+    Load(*ram, 0x0210, { 0x78, 0xE8, 0x4C, 0x20, 0x02 });
+    Load(*ram, 0x0220, { 0x58, 0xC8, 0x4C, 0x10, 0x02 });
+    Load(*ram, 0x0300, { 0xE6, 0x12, 0x4C, 0x02, 0x03 });
+    Load(*ram, 0xFFFE, { 0x00, 0x03 });
+    Load(*ram, 0x0012, { 234 });
+
+    JitCPU cpu(*bus);
+    cpu.Reset();
+    cpu.Run(3003);
+    cpu.AssertIRQ();
+    cpu.Run(3000);
+    EXPECT_EQ(ram->ReadByte(0x0012), 235);
+}
+
+//Both execution modes give the same result on the same program
+TEST(JitCPU, ExecutionModesAgree) {
+    auto run = [](const ExecutionMode mode) {
+        Memory* ram = nullptr;
+        auto bus = MakeMachine(ram, 0x0200);
+        //0200 : LDY #0 ; loop : TYA ; STA $1000,Y ; INY ; BNE loop ; jam
+        Load(*ram, 0x0200, { 0xA0, 0x00, 0x98, 0x99, 0x00, 0x10, 0xC8, 0xD0, 0xF9, 0x02 });
+        JitCPU cpu(*bus, mode);
+        cpu.Reset();
+        const uint64_t cycles = cpu.Run(10000);
+        EXPECT_TRUE(cpu.IsHalted());
+        for(int i = 0; i < 256; i++) EXPECT_EQ(ram->ReadByte(0x1000 + i), i);
+        return cycles;
+    };
+    EXPECT_EQ(run(ExecutionMode::JIT), run(ExecutionMode::INTERPRETER));
+}
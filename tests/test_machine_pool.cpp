@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <bus.h>
+#include <machine_pool.h>
+#include "helpers.h"
+
+namespace {
+
+    //Every write throws
+    struct Faulty : IODevice {
+        Byte ReadByte(const address&) const override { return 0; }
+        Word ReadWord(const address&) const override { return 0; }
+        void WriteByte(const address&, const Byte) override { throw runtime_error("device fault"); }
+        void WriteWord(const address&, const Word) override { throw runtime_error("device fault"); }
+    };
+
+    //LDX #start ; loop : INX ; DEY ; BNE loop ; jam      (Y = count)
+    unique_ptr<Machine<Memory>> Counter(const Byte start, const Byte count) {
+        auto machine = Machine<Memory>::Make();
+        Load(machine->GetBus(), 0x0200, { 0xA2, start, 0xA0, count, 0xE8, 0x88, 0xD0, 0xFC, 0x02 });
+        machine->SetRegisters(StartAt(0x0200));
+        return machine;
+    }
+
+    //LDY #$80 ; loop : DEY ; BNE loop ; STA $D000 (faulty) or $0010 ; jam
+    unique_ptr<Machine<Bus>> Writer(const bool faulty) {
+        auto bus = Bus::Make();
+        auto ram = Memory::Make();
+        bus->MapMemory(0x00, 0xD0, ram);
+        bus->MapDevice(0xD0, 1, make_shared<Faulty>());
+        Load(*bus, 0x0200, { 0xA0, 0x80, 0x88, 0xD0, 0xFD, 0x8D, 0x00, static_cast<Byte>(faulty ? 0xD0 : 0x00), 0x02 });
+        auto machine = Machine<Bus>::Make(bus);
+        machine->SetRegisters(StartAt(0x0200));
+        return machine;
+    }
+}
+
+//Every machine runs to its end, whichever worker picks it up
+TEST(MachinePool, RunsEveryMachine) {
+    MachinePool<Memory> pool(4, 500);
+    vector<MachinePool<Memory>::Ticket> tickets;
+    for(int i = 0; i < 200; i++) {
+        auto machine = Counter(i, i % 50 + 1);
+        //An endless loop stopped by its cycle limit
+        if(i % 3 == 0) {
+            Load(machine->GetBus(), 0x0208, { 0x4C, 0x00, 0x02 });
+            machine->SetCycleLimit(20000 + i * 100);
+        }
+        tickets.push_back(pool.Submit(std::move(machine)));
+    }
+
+    auto first = pool.Await(tickets[5]);
+    EXPECT_TRUE(first->IsHalted());
+    EXPECT_EQ(first->GetRegisters().m_X, 5 + 6);
+    EXPECT_TRUE(pool.IsDone(tickets[5]));
+    EXPECT_THROW(pool.Await(tickets[5]), invalid_argument);
+
+    const auto rest = pool.Collect();
+    ASSERT_EQ(rest.size(), 199u);
+    for(const auto& machine : rest) EXPECT_TRUE(machine->IsDone());
+    EXPECT_TRUE(pool.Collect().empty());
+}
+
+//A machine whose device throws is dropped, Await() / Collect() rethrow, the others carry on
+TEST(MachinePool, HandsRunErrorsBack) {
+    MachinePool<Bus> pool(3, 50);
+    vector<MachinePool<Bus>::Ticket> tickets;
+    for(int i = 0; i < 10; i++) tickets.push_back(pool.Submit(Writer(i == 3 || i == 7)));
+
+    EXPECT_THROW(pool.Await(tickets[3]), runtime_error);
+    auto machine = pool.Await(tickets[4]);
+    ASSERT_TRUE(machine);
+    EXPECT_TRUE(machine->IsHalted());
+
+    EXPECT_THROW(pool.Collect(), runtime_error);
+    const auto rest = pool.Collect();
+    EXPECT_EQ(rest.size(), 7u);
+    for(const auto& other : rest) EXPECT_TRUE(other->IsHalted());
+}
+
+//Destroying the pool drops the machines still running, even ones that never end
+TEST(MachinePool, DestructionDropsRunningMachines) {
+    promise<void> destroyed;
+    future<void> done = destroyed.get_future();
+    thread owner([&destroyed]() {
+        {
+            MachinePool<Memory> pool(2, 1000);
+            //0400 : JMP $0400, no cycle limit
+            auto machine = Machine<Memory>::Make();
+            Load(machine->GetBus(), 0x0400, { 0x4C, 0x00, 0x04 });
+            machine->SetRegisters(StartAt(0x0400));
+            pool.Submit(std::move(machine));
+            this_thread::sleep_for(chrono::milliseconds(20));
+        }
+        destroyed.set_value();
+    });
+
+    if(done.wait_for(chrono::seconds(10)) == future_status::ready) owner.join();
+    else {
+        owner.detach();
+        FAIL() << "the pool destructor did not return";
+    }
+}
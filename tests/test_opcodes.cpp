@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <cpu_core.h>
+#include <memory.h>
+#include <opcodes.h>
+#include "helpers.h"
+
+TEST(Opcodes, DecodesTheDocumentedOpcodes) {
+    size_t documented = 0;
+    for(const Opcode& opcode : OPCODES) documented += opcode.m_Instruction != Instructions::ILL;
+    EXPECT_EQ(documented, 151u);
+
+    EXPECT_EQ(OPCODES[0xA9].m_Instruction, Instructions::LDA);
+    EXPECT_EQ(OPCODES[0xA9].m_AddrMode, AddressMode::IMM);
+    EXPECT_EQ(OPCODES[0xA9].m_Cycles, 2);
+
+    EXPECT_EQ(OPCODES[0x6C].m_Instruction, Instructions::JMP);
+    EXPECT_EQ(OPCODES[0x6C].m_AddrMode, AddressMode::IND);
+    EXPECT_EQ(OPCODES[0x6C].m_Cycles, 5);
+
+    EXPECT_EQ(OPCODES[0x71].m_AddrMode, AddressMode::INY);
+    EXPECT_TRUE(OPCODES[0x71].m_PageCross);
+    EXPECT_FALSE(OPCODES[0x91].m_PageCross);
+
+    EXPECT_EQ(OPCODES[0x00].m_Cycles, 7);
+    EXPECT_EQ(OPCODES[0x02].m_Instruction, Instructions::ILL);
+}
+
+//A loop, a subroutine call and a jam, through the table-driven Run()
+TEST(Opcodes, RunsAProgram) {
+    Memory memory;
+    //0200 : LDX #10 ; LDA #0 ; CLC ; loop : STX $10 ; ADC $10 ; DEX ; BNE loop ; JSR $0300 ; STA $20 ; jam
+    Load(memory, 0x0200, { 0xA2, 10, 0xA9, 0, 0x18, 0x86, 0x10, 0x65, 0x10, 0xCA, 0xD0, 0xF9, 0x20, 0x00, 0x03, 0x85, 0x20, 0x02 });
+    //0300 : ASL A ; LDY #$FF ; INY ; RTS
+    Load(memory, 0x0300, { 0x0A, 0xA0, 0xFF, 0xC8, 0x60 });
+
+    CPUCore<Memory> cpu(memory);
+    cpu.SetRegisters(StartAt(0x0200));
+    const uint64_t cycles = cpu.Run(1000);
+
+    EXPECT_TRUE(cpu.IsHalted());
+    EXPECT_EQ(cpu.GetAccumulator(), 110);
+    EXPECT_EQ(memory.ReadByte(0x20), 110);
+    EXPECT_EQ(cpu.GetY(), 0);
+    EXPECT_TRUE(cpu.HasStatusFlag(StatusFlag::ZERO));
+    EXPECT_EQ(cpu.GetStackPointer(), 0xFF);
+    EXPECT_EQ(cpu.GetCycles(), cycles);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <cpu_core.h>
+#include <memory.h>
+#include <profiler.h>
+#include "helpers.h"
+
+//The counters add up to what the core ran, opcode by opcode and page by page
+TEST(Profiler, CountsTheRun) {
+    Memory memory;
+    //0200 : LDX #0 ; loop : LDA $F0,X ; STA $0380,X ; ADC #3 ; INX ; BNE loop ; jam
+    Load(memory, 0x0200, { 0xA2, 0x00, 0xB5, 0xF0, 0x9D, 0x80, 0x03, 0x69, 0x03, 0xE8, 0xD0, 0xF6, 0x02 });
+    CPUCore<Memory, Profiler> cpu(memory);
+    cpu.SetRegisters(StartAt(0x0200));
+    const uint64_t cycles = cpu.Run(100000);
+    ASSERT_TRUE(cpu.IsHalted());
+
+    const Profiler& profile = cpu.GetTracer();
+    EXPECT_EQ(profile.GetCycleCount(), cycles);
+    EXPECT_EQ(profile.GetInstructionCount(), 1 + 5 * 256 + 1u);
+
+    EXPECT_EQ(profile.GetOpcode(0xA2).m_Count, 1u);
+    for(const Byte code : { 0xB5, 0x9D, 0x69, 0xE8, 0xD0 }) EXPECT_EQ(profile.GetOpcode(code).m_Count, 256u) << int(code);
+    EXPECT_EQ(profile.GetOpcode(0xD0).m_Penalties, 255u) << "one cycle per branch taken";
+    EXPECT_EQ(profile.GetBranchesTaken(), 255u);
+    EXPECT_EQ(profile.GetBranchPageCrossings(), 0u);
+    //$F0,X wraps around the zero-page from X = $10 on
+    EXPECT_EQ(profile.GetZeroPageWraps(), 240u);
+
+    EXPECT_EQ(profile.GetPage(0x02).m_Instructions, profile.GetInstructionCount());
+    EXPECT_EQ(profile.GetPage(0x02).m_Cycles, cycles);
+    EXPECT_EQ(profile.GetPage(0x00).m_Reads, 256u);
+    EXPECT_EQ(profile.GetPage(0x03).m_Writes + profile.GetPage(0x04).m_Writes, 256u);
+    EXPECT_EQ(profile.GetPage(0x04).m_Writes, 128u);
+
+    ostringstream json;
+    profile.Dump(json);
+    EXPECT_EQ(json.str().front(), '{');
+    EXPECT_NE(json.str().find("LDA"), string::npos);
+}
+
+//A core without the profiler runs the same cycles
+TEST(Profiler, DoesNotChangeTheRun) {
+    Memory a, b;
+    for(Memory* memory : { &a, &b }) Load(*memory, 0x0200, { 0xA2, 0x00, 0xB5, 0xF0, 0x9D, 0x80, 0x03, 0x69, 0x03, 0xE8, 0xD0, 0xF6, 0x02 });
+    CPUCore<Memory, Profiler> profiled(a);
+    CPUCore<Memory> plain(b);
+    profiled.SetRegisters(StartAt(0x0200));
+    plain.SetRegisters(StartAt(0x0200));
+    EXPECT_EQ(profiled.Run(100000), plain.Run(100000));
+    EXPECT_TRUE(profiled.GetRegisters() == plain.GetRegisters());
+
+    profiled.GetTracer().Reset();
+    EXPECT_EQ(profiled.GetTracer().GetInstructionCount(), 0u);
+}
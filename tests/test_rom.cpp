@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <bus.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include <rom.h>
+#include "helpers.h"
+
+namespace {
+
+    string WriteFile(const string& name, const vector<Byte>& bytes) {
+        const string path = ::testing::TempDir() + name;
+        ofstream(path, ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return path;
+    }
+
+    //One 16 KB bank : LDA #$42 ; STA $0200 ; jam at $8000, the RESET vector on it
+    vector<Byte> NesImage() {
+        vector<Byte> image(16 + 0x4000, 0);
+        memcpy(image.data(), "NES\x1A", 4);
+        image[4] = 1;
+        const Byte code[] = { 0xA9, 0x42, 0x8D, 0x00, 0x02, 0x02 };
+        memcpy(&image[16], code, sizeof(code));
+        image[16 + 0x3FFC] = 0x00;
+        image[16 + 0x3FFD] = 0x80;
+        return image;
+    }
+}
+
+//The PRG-ROM bank is mapped copy-free at $8000 and mirrored at $C000
+TEST(Program, MapsAnNesImage) {
+    const Program nes = Program::Nes(WriteFile("emu6502_test.nes", NesImage()));
+    auto bus = Bus::Make();
+    bus->MapMemory(0x00, 8, Memory::Make(0x800));
+    nes.Map(*bus);
+
+    EXPECT_EQ(bus->ReadWord(0xFFFC), 0x8000);
+    EXPECT_EQ(bus->GetPage(0x80).m_Read, nes.m_Rom->GetData() + 16);
+    EXPECT_EQ(bus->GetPage(0xC0).m_Read, nes.m_Rom->GetData() + 16);
+    EXPECT_EQ(bus->GetPage(0x80).m_Write, nullptr);
+
+    CPUCore<Bus> cpu(*bus);
+    cpu.Reset();
+    cpu.Run(10);
+    EXPECT_TRUE(cpu.IsHalted());
+    EXPECT_EQ(bus->ReadByte(0x0200), 0x42);
+
+    //ROM ignores the CPU's writes
+    bus->WriteByte(0x8000, 0x00);
+    EXPECT_EQ(bus->ReadByte(0x8000), 0xA9);
+}
+
+//A .prg not on a page boundary is copied to the RAM at its load address
+TEST(Program, LoadsAPrg) {
+    const Program prg = Program::Prg(WriteFile("emu6502_test.prg", { 0x01, 0x03, 1, 2, 3, 4, 5 }));
+    ASSERT_EQ(prg.m_Segments.size(), 1u);
+    EXPECT_EQ(prg.m_Segments[0].m_Base, 0x0301);
+    EXPECT_EQ(prg.m_Segments[0].m_Size, 5u);
+
+    auto bus = Bus::Make();
+    bus->MapMemory(0x00, 8, Memory::Make(0x800));
+    prg.Map(*bus);
+    vector<Byte> bytes(5);
+    bus->ReadBytes(0x0301, bytes);
+    EXPECT_EQ(bytes, (vector<Byte> { 1, 2, 3, 4, 5 }));
+
+    Memory memory;
+    prg.Load(memory);
+    EXPECT_EQ(memory.ReadByte(0x0301), 1);
+    EXPECT_EQ(memory.ReadByte(0x0305), 5);
+}
+
+TEST(Program, RejectsBadImages) {
+    EXPECT_THROW(Program::Prg(WriteFile("emu6502_short.prg", { 0x01 })), invalid_argument);
+    EXPECT_THROW(Program::Nes(WriteFile("emu6502_bad.nes", vector<Byte>(32, 0))), invalid_argument);
+    EXPECT_THROW(Program::Binary(::testing::TempDir() + "emu6502_missing.bin", 0x8000), runtime_error);
+}
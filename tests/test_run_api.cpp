@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <cpu_core.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //0200 : INX ; BNE $0200 ; jam      (255 iterations of 5 cycles, the last one 4)
+    void LoadCounter(Memory& memory) {
+        Load(memory, 0x0200, { 0xE8, 0xD0, 0xFD, 0x02 });
+    }
+}
+
+//The budget is reached, overshot by the last instruction at most
+TEST(RunApi, RunForStopsOnTheBudget) {
+    Memory memory;
+    LoadCounter(memory);
+    CPUCore<Memory> cpu(memory);
+    cpu.SetRegisters(StartAt(0x0200));
+
+    const uint64_t cycles = cpu.RunFor(50);
+    EXPECT_GE(cycles, 50u);
+    EXPECT_LT(cycles, 53u);
+    EXPECT_EQ(cpu.GetCycles(), cycles);
+
+    cpu.RunFor(100000);
+    EXPECT_TRUE(cpu.IsHalted());
+    EXPECT_EQ(cpu.GetX(), 0);
+}
+
+//The predicate is checked before every instruction
+TEST(RunApi, RunUntilStopsOnThePredicate) {
+    Memory memory;
+    LoadCounter(memory);
+    CPUCore<Memory> cpu(memory);
+    cpu.SetRegisters(StartAt(0x0200));
+
+    cpu.RunUntil([](const auto& core) { return core.GetX() == 200; });
+    EXPECT_EQ(cpu.GetX(), 200);
+    EXPECT_EQ(cpu.GetProgramCounter(), 0x0201);
+
+    //A jam stops it too
+    cpu.RunUntil([](const auto&) { return false; });
+    EXPECT_TRUE(cpu.IsHalted());
+}
+
+//Run, RunFor and Step spend the same cycles on the same instructions
+TEST(RunApi, RunMatchesStepping) {
+    Memory a, b;
+    LoadCounter(a);
+    LoadCounter(b);
+    CPUCore<Memory> run(a), step(b);
+    run.SetRegisters(StartAt(0x0200));
+    step.SetRegisters(StartAt(0x0200));
+
+    uint64_t cycles = 0;
+    for(int i = 0; i < 301; i++) cycles += step.Step();
+    EXPECT_EQ(run.Run(301), cycles);
+    EXPECT_TRUE(run.GetRegisters() == step.GetRegisters());
+}
+
+//Events run once their deadline is reached, in the middle of a RunFor
+TEST(RunApi, EventsRunOnTheirDeadline) {
+    Memory memory;
+    LoadCounter(memory);
+    CPUCore<Memory> cpu(memory);
+    cpu.SetRegisters(StartAt(0x0200));
+
+    uint64_t fired = 0;
+    cpu.Schedule(100, [&]() { fired = cpu.GetCycles(); });
+    cpu.RunFor(1000);
+    EXPECT_GE(fired, 100u);
+    EXPECT_LT(fired, 103u);
+}
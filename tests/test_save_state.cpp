@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <bus.h>
+#include <machine.h>
+#include <save_state.h>
+#include "helpers.h"
+
+namespace {
+
+    //Latches the last byte written, counts the writes
+    struct Latch : IODevice {
+        Byte m_Value = 0;
+        uint32_t m_Writes = 0;
+
+        Byte ReadByte(const address&) const override { return m_Value; }
+        Word ReadWord(const address&) const override { return m_Value; }
+        void WriteByte(const address&, const Byte data) override { m_Value = data; m_Writes++; }
+        void WriteWord(const address& addr, const Word data) override { WriteByte(addr, data); }
+
+        void SaveState(vector<Byte>& state) const override {
+            StateWriter writer(state);
+            writer.Write(m_Value);
+            writer.Write32(m_Writes);
+        }
+
+        void LoadState(span<const Byte> state) override {
+            StateReader reader(state);
+            m_Value = reader.Read();
+            m_Writes = reader.Read32();
+            if(!reader.IsAtEnd()) throw runtime_error("Latch state too long");
+        }
+    };
+
+    bool operator==(const MachineState& a, const MachineState& b) {
+        return a.m_Registers == b.m_Registers && a.m_Halted == b.m_Halted && a.m_Cycles == b.m_Cycles && a.m_IrqLines == b.m_IrqLines
+            && a.m_NmiPending == b.m_NmiPending && a.m_ResetPending == b.m_ResetPending && a.m_Memory == b.m_Memory && a.m_Devices == b.m_Devices;
+    }
+
+    //0400 : LDX #0 ; loop : INC $2000,X ; INX ; BNE loop ; INC $3000 ; JMP $0400
+    unique_ptr<Machine<>> Incrementer() {
+        auto machine = Machine<>::Make();
+        Load(machine->GetBus(), 0x0400, { 0xA2, 0x00, 0xFE, 0x00, 0x20, 0xE8, 0xD0, 0xFA, 0xEE, 0x00, 0x30, 0x4C, 0x00, 0x04 });
+        Load(machine->GetBus(), 0xFFFC, { 0x00, 0x04 });
+        machine->Reset();
+        return machine;
+    }
+
+    //20 states of a running machine, written with a keyframe every 4
+    string Record(Machine<>& machine, vector<MachineState>& states) {
+        ostringstream stream;
+        SaveStateWriter writer(stream, 4);
+        for(int i = 0; i < 20; i++) {
+            machine.RunFor(3000 + i * 7);
+            states.push_back(machine.SaveState());
+            writer.Write(states.back());
+        }
+        return stream.str();
+    }
+}
+
+//Keyframes and page deltas decode back to the states written
+TEST(SaveState, RoundTrips) {
+    auto machine = Incrementer();
+    vector<MachineState> states;
+    const string data = Record(*machine, states);
+    EXPECT_LT(data.size(), states.size() * 0x10000 / 2) << "the deltas only hold the pages written";
+
+    istringstream stream(data);
+    SaveStateReader reader(stream);
+    size_t count = 0;
+    while(reader.Next()) {
+        ASSERT_LT(count, states.size());
+        EXPECT_TRUE(reader.GetState() == states[count]) << count;
+        count++;
+    }
+    EXPECT_EQ(count, states.size());
+}
+
+//A machine loaded from a state runs on as the one it was taken from
+TEST(SaveState, LoadedMachineRunsOn) {
+    auto machine = Incrementer();
+    vector<MachineState> states;
+    const string data = Record(*machine, states);
+
+    istringstream stream(data);
+    SaveStateReader reader(stream);
+    for(int i = 0; i < 3; i++) ASSERT_TRUE(reader.Next());
+    auto loaded = Machine<>::Make();
+    loaded->LoadState(reader.GetState());
+    loaded->RunFor(3000 + 3 * 7);
+    EXPECT_TRUE(loaded->SaveState() == states[3]);
+}
+
+//A torn last frame is dropped, a corrupted one throws
+TEST(SaveState, TornAndCorruptedStreams) {
+    auto machine = Incrementer();
+    vector<MachineState> states;
+    const string data = Record(*machine, states);
+
+    istringstream torn(data.substr(0, data.size() - 3));
+    SaveStateReader reader(torn);
+    ASSERT_TRUE(reader.ReadLast());
+    EXPECT_EQ(reader.GetCount(), 19u);
+    EXPECT_TRUE(reader.GetState() == states[18]);
+
+    string corrupted = data;
+    corrupted[40] ^= 1;
+    istringstream stream(corrupted);
+    SaveStateReader corrupted_reader(stream);
+    EXPECT_THROW(corrupted_reader.ReadLast(), runtime_error);
+}
+
+//A Bus machine saves its RAM pages and the state of its devices, mapped or attached
+TEST(SaveState, BusMachineWithDevices) {
+    auto bus = Bus::Make();
+    bus->MapMemory(0x00, 0xD0, Memory::Make());
+    auto latch = make_shared<Latch>();
+    bus->MapDevice(0xD0, 1, latch);
+    auto machine = Machine<Bus>::Make(bus);
+    machine->Attach(make_shared<Latch>());
+
+    bus->WriteByte(0xD000, 7);
+    bus->WriteByte(0x1234, 9);
+    ostringstream stream;
+    {
+        SaveStateWriter writer(stream);
+        writer.Write(machine->SaveState());
+        bus->WriteByte(0xD000, 8);
+        writer.Write(machine->SaveState());
+    }
+    bus->WriteByte(0x1234, 0);
+    bus->WriteByte(0xD000, 1);
+
+    istringstream in(stream.str());
+    SaveStateReader reader(in);
+    ASSERT_TRUE(reader.Next());
+    EXPECT_EQ(reader.GetState().m_Memory.size(), 0xD0u * Memory::PAGE_SIZE);
+    EXPECT_EQ(reader.GetState().m_Devices.size(), 2u);
+    machine->LoadState(reader.GetState());
+    EXPECT_EQ(bus->ReadByte(0x1234), 9);
+    EXPECT_EQ(latch->m_Value, 7);
+    EXPECT_EQ(latch->m_Writes, 1u);
+
+    ASSERT_TRUE(reader.Next());
+    machine->LoadState(reader.GetState());
+    EXPECT_EQ(latch->m_Value, 8);
+    EXPECT_EQ(latch->m_Writes, 2u);
+
+    //Another device graph
+    auto other = Machine<Bus>::Make(bus);
+    EXPECT_THROW(other->LoadState(reader.GetState()), invalid_argument);
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <cpu_core.h>
+#include <memory.h>
+#include "single_step.h"
+#include "helpers.h"
+
+namespace {
+
+    const char* VECTORS = R"([
+        { "name": "a9 23 6f",
+          "initial": { "pc": 4660, "s": 253, "a": 0, "x": 1, "y": 2, "p": 38, "ram": [[4660, 169], [4661, 35]] },
+          "final": { "pc": 4662, "s": 253, "a": 35, "x": 1, "y": 2, "p": 36, "ram": [[4660, 169], [4661, 35]] },
+          "cycles": [[4660, 169, "read"], [4661, 35, "read"]] },
+        { "name": "85 10", "extra": { "nested": [1, [2, 3], "x"], "flag": true },
+          "initial": { "pc": 768, "s": 253, "a": 66, "x": 0, "y": 0, "p": 36, "ram": [[768, 133], [769, 16], [16, 0]] },
+          "final": { "pc": 770, "s": 253, "a": 66, "x": 0, "y": 0, "p": 36, "ram": [[768, 133], [769, 16], [16, 66]] },
+          "cycles": [[768, 133, "read"], [769, 16, "read"], [16, 66, "write"]] }
+    ])";
+
+    vector<StepTest> ReadAll(const string& json) {
+        istringstream in(json);
+        StepTestReader reader(in);
+        vector<StepTest> tests;
+        StepTest test;
+        while(reader.Next(test)) tests.push_back(test);
+        return tests;
+    }
+}
+
+TEST(StepTestReader, DecodesVectors) {
+    const vector<StepTest> tests = ReadAll(VECTORS);
+    ASSERT_EQ(tests.size(), 2u);
+
+    EXPECT_EQ(tests[0].m_Name, "a9 23 6f");
+    EXPECT_EQ(tests[0].m_Initial.m_PC, 4660);
+    EXPECT_EQ(tests[0].m_Initial.m_Status, 38);
+    EXPECT_EQ(tests[0].m_Final.m_Acc, 35);
+    EXPECT_EQ(tests[0].m_Cycles, 2u);
+
+    //Unknown keys are skipped, whatever they hold
+    EXPECT_EQ(tests[1].m_Name, "85 10");
+    ASSERT_EQ(tests[1].m_Final.m_Ram.size(), 3u);
+    EXPECT_EQ(tests[1].m_Final.m_Ram[2], make_pair(Word(16), Byte(66)));
+    EXPECT_EQ(tests[1].m_Cycles, 3u);
+}
+
+TEST(StepTestReader, EmptyFile) {
+    EXPECT_TRUE(ReadAll(" [ ] ").empty());
+}
+
+TEST(StepTestReader, RejectsMalformedInput) {
+    EXPECT_THROW(ReadAll("{}"), runtime_error);
+    EXPECT_THROW(ReadAll(R"([{ "name": "a9", "initial": { "pc": -1 } }])"), runtime_error);
+    EXPECT_THROW(ReadAll(R"([{ "name": "a9" })"), runtime_error);
+    EXPECT_THROW(ReadAll(R"([{ "name": "a\"9" }])"), runtime_error);
+}
+
+//The vectors run on the core the way the runner does : initial state, one Step(), final state
+TEST(StepTestReader, VectorsPassOnTheCore) {
+    for(const StepTest& test : ReadAll(VECTORS)) {
+        SCOPED_TRACE(test.m_Name);
+        Memory memory;
+        CPUCore<Memory> cpu(memory);
+        for(const auto& [addr, value] : test.m_Initial.m_Ram) memory[addr] = value;
+
+        Registers registers {};
+        registers.m_PC = test.m_Initial.m_PC;
+        registers.m_SP = test.m_Initial.m_SP;
+        registers.m_Acc = test.m_Initial.m_Acc;
+        registers.m_X = test.m_Initial.m_X;
+        registers.m_Y = test.m_Initial.m_Y;
+        registers.m_CpuStatus = test.m_Initial.m_Status;
+        cpu.SetRegisters(registers);
+
+        EXPECT_EQ(cpu.Step(), test.m_Cycles);
+        EXPECT_EQ(cpu.GetProgramCounter(), test.m_Final.m_PC);
+        EXPECT_EQ(cpu.GetAccumulator(), test.m_Final.m_Acc);
+        EXPECT_EQ(cpu.GetStatus().m_Value & 0xCF, test.m_Final.m_Status & 0xCF);
+        for(const auto& [addr, value] : test.m_Final.m_Ram) EXPECT_EQ(memory.ReadByte(addr), value);
+    }
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <machine.h>
+#include <memory.h>
+#include "helpers.h"
+
+namespace {
+
+    //0200 : LDA #$55 ; LDX #0 ; loop : STA $3000,X ; INX ; BNE loop ; jam
+    unique_ptr<Machine<Memory>> Filler() {
+        auto machine = Machine<Memory>::Make();
+        Load(machine->GetBus(), 0x0200, { 0xA9, 0x55, 0xA2, 0x00, 0x9D, 0x00, 0x30, 0xE8, 0xD0, 0xFA, 0x02 });
+        machine->SetRegisters(StartAt(0x0200));
+        return machine;
+    }
+
+    //0200 : CLI ; JMP $0201      NMI and IRQ handlers : INC $40 / INC $41 ; RTI
+    unique_ptr<Machine<Memory>> Spinner() {
+        auto machine = Machine<Memory>::Make();
+        Memory& memory = machine->GetBus();
+        Load(memory, 0x0200, { 0x58, 0x4C, 0x01, 0x02 });
+        Load(memory, 0x0300, { 0xE6, 0x40, 0x40 });
+        Load(memory, 0x0310, { 0xE6, 0x41, 0x40 });
+        Load(memory, 0xFFFA, { 0x00, 0x03 });
+        Load(memory, 0xFFFE, { 0x10, 0x03 });
+        machine->SetRegisters(StartAt(0x0200));
+        return machine;
+    }
+}
+
+//Running from the same snapshot again and again gives the same run
+TEST(MachineSnapshot, RewindsTheRun) {
+    auto machine = Filler();
+    Memory& memory = machine->GetBus();
+    const vector<Byte> initial(memory.GetData(), memory.GetData() + 0x10000);
+    const auto state = machine->Snapshot();
+
+    for(int i = 0; i < 100; i++) {
+        machine->RunQuantum(100000);
+        ASSERT_TRUE(machine->IsHalted());
+        ASSERT_EQ(memory.ReadByte(0x30FF), 0x55);
+        machine->Restore(state);
+    }
+    EXPECT_FALSE(machine->IsHalted());
+    EXPECT_EQ(machine->GetRegisters().m_PC, 0x0200);
+    EXPECT_EQ(machine->GetCycles(), 0u);
+    EXPECT_TRUE(equal(initial.begin(), initial.end(), memory.GetData()));
+
+    //Restoring into another machine of the same size copies the whole memory
+    auto other = Machine<Memory>::Make();
+    other->Restore(state);
+    EXPECT_TRUE(equal(initial.begin(), initial.end(), other->GetBus().GetData()));
+}
+
+//What the discarded run raised or scheduled doesn't carry over, what the snapshot held does
+TEST(MachineSnapshot, RestoresTheInterruptState) {
+    auto machine = Spinner();
+    Memory& memory = machine->GetBus();
+    machine->RunQuantum(100);
+    const auto state = machine->Snapshot();
+
+    machine->TriggerNMI();
+    machine->AssertIRQ();
+    machine->Schedule(machine->GetCycles() + 10, [&memory]() { memory.WriteByte(0x42, 1); });
+    machine->Restore(state);
+    machine->RunQuantum(1000);
+    EXPECT_EQ(memory.ReadByte(0x40), 0);
+    EXPECT_EQ(memory.ReadByte(0x41), 0);
+    EXPECT_EQ(memory.ReadByte(0x42), 0);
+
+    //An IRQ line held at the snapshot is held again after the rewind
+    machine->AssertIRQ();
+    const auto held = machine->Snapshot();
+    machine->ReleaseIRQ();
+    machine->Restore(held);
+    machine->RunQuantum(20);
+    EXPECT_GT(memory.ReadByte(0x41), 0);
+}
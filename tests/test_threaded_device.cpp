@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bus.h>
+#include <cpu_core.h>
+#include <memory.h>
+#include <threaded_device.h>
+#include "helpers.h"
+
+namespace {
+
+    //Every write to a register hashes the byte into a checksum, after spinning for `work` iterations.
+    //Register 1 reads the checksum back, register 2 the number of writes, writes to register $FF throw.
+    struct Slow : IODevice {
+        uint32_t m_Sum = 0;
+        atomic<uint32_t> m_Count { 0 };
+        int m_Work;
+        thread::id m_Thread;
+
+        explicit Slow(const int work) : m_Work(work) {}
+
+        Byte ReadByte(const address& addr) const override {
+            switch (addr.GetRecord()) {
+                case 1: return m_Sum & 0xFF;
+                case 2: return m_Count.load() & 0xFF;
+                default: return 0;
+            }
+        }
+
+        Word ReadWord(const address& addr) const override { return MAKE_WORD(ReadByte(addr.GetValue() + 1), ReadByte(addr)); }
+
+        void WriteByte(const address& addr, const Byte data) override {
+            m_Thread = this_thread::get_id();
+            if(addr.GetRecord() == 0xFF) throw runtime_error("bad register");
+            volatile uint32_t spin = 0;
+            for(int i = 0; i < m_Work; i++) spin = spin + i;
+            m_Sum = m_Sum * 31 + data;
+            m_Count.fetch_add(1);
+        }
+
+        void WriteWord(const address& addr, const Word data) override {
+            WriteByte(addr, data & 0xFF);
+            WriteByte(addr.GetValue() + 1, data >> 8);
+        }
+    };
+
+    //Read once per iteration of the CPU's loop, on the CPU's thread : how many writes the device is behind
+    struct LagProbe : IODevice {
+        const Slow& m_Slow;
+        mutable uint32_t m_Posted = 0;
+        mutable uint32_t m_MaxLag = 0;
+
+        explicit LagProbe(const Slow& slow) : m_Slow(slow) {}
+
+        Byte ReadByte(const address& addr) const override {
+            m_Posted++;
+            m_MaxLag = max(m_MaxLag, m_Posted - m_Slow.m_Count.load());
+            return 0;
+        }
+
+        Word ReadWord(const address& addr) const override { return ReadByte(addr); }
+        void WriteByte(const address& addr, const Byte data) override {}
+        void WriteWord(const address& addr, const Word data) override {}
+    };
+
+    uint32_t Checksum(const uint32_t count) {
+        uint32_t sum = 0;
+        for(uint32_t i = 0; i < count; i++) sum = sum * 31 + static_cast<Byte>(i);
+        return sum;
+    }
+
+    //$0400 : loop : STA $D000 ; LDA $D100 ; JMP loop, 11 cycles an iteration
+    template<typename Timing>
+    uint32_t MaxLag(const uint64_t latency) {
+        const auto bus = Bus::Make();
+        bus->MapMemory(0x00, 0xD0, Memory::Make());
+        const auto slow = make_shared<Slow>(20000);
+        const auto device = ThreadedDevice::Make(slow, latency, 4096);
+        const auto probe = make_shared<LagProbe>(*slow);
+        bus->MapDevice(0xD0, 1, device);
+        bus->MapDevice(0xD1, 1, probe);
+        Load(*bus, 0x0400, { 0x8D, 0x00, 0xD0, 0xAD, 0x00, 0xD1, 0x4C, 0x00, 0x04 });
+
+        CPUCore<Bus, NoTrace, Timing> core(*bus);
+        core.SetRegisters(StartAt(0x0400));
+        device->Attach(core);
+        core.RunFor(2000 * 11);
+        device->Sync();
+        EXPECT_EQ(slow->m_Count.load(), 2000u);
+        return probe->m_MaxLag;
+    }
+}
+
+TEST(ThreadedDevice, AppliesWritesInOrderOnItsThread) {
+    const auto slow = make_shared<Slow>(100);
+    const auto device = ThreadedDevice::Make(slow, 1000, 16);
+    for(uint32_t i = 0; i < 100000; i++) device->WriteByte(0xD000, i);
+
+    //Reads wait for the writes before them
+    EXPECT_EQ(device->ReadByte(0xD001), Checksum(100000) & 0xFF);
+    EXPECT_EQ(slow->m_Count.load(), 100000u);
+    EXPECT_EQ(slow->m_Sum, Checksum(100000));
+    EXPECT_NE(slow->m_Thread, this_thread::get_id());
+
+    //Longer than an event
+    vector<Byte> bulk(200);
+    device->WriteBytes(0xD000, bulk);
+    device->Sync();
+    EXPECT_EQ(slow->m_Count.load(), 100200u);
+}
+
+TEST(ThreadedDevice, RunsBehindACore) {
+    const auto bus = Bus::Make();
+    bus->MapMemory(0x00, 0xD0, Memory::Make());
+    const auto slow = make_shared<Slow>(2000);
+    const auto device = ThreadedDevice::Make(slow, 5000, 1024);
+    bus->MapDevice(0xD0, 1, device);
+    //$0400 : LDX #0 ; loop : TXA ; STA $D000 ; INX ; BNE loop ; LDA $D001 ; STA $10 ; LDA $D002 ; STA $11 ; JMP *
+    Load(*bus, 0x0400, { 0xA2, 0x00, 0x8A, 0x8D, 0x00, 0xD0, 0xE8, 0xD0, 0xF9, 0xAD, 0x01, 0xD0, 0x85, 0x10, 0xAD, 0x02, 0xD0, 0x85, 0x11, 0x4C, 0x13, 0x04 });
+
+    CPUCore<Bus> core(*bus);
+    core.SetRegisters(StartAt(0x0400));
+    device->Attach(core);
+    core.RunFor(5000);
+
+    EXPECT_EQ(bus->ReadByte(0x10), Checksum(256) & 0xFF);
+    EXPECT_EQ(bus->ReadByte(0x11), 0) << "256 writes";
+}
+
+//100 cycles are 9 iterations : the probe's count leads by at most one more, and the write of the ongoing one
+TEST(ThreadedDevice, KeepsTheLatencyWindowOnFastTiming) {
+    EXPECT_LE(MaxLag<FastTiming>(100), 11u);
+}
+
+TEST(ThreadedDevice, KeepsTheLatencyWindowOnCycleExactTiming) {
+    EXPECT_LE(MaxLag<CycleExact>(100), 11u);
+}
+
+TEST(ThreadedDevice, KeepsTheLatencyWindowOnAnyClock) {
+    const auto slow = make_shared<Slow>(20000);
+    const auto device = ThreadedDevice::Make(slow, 100, 4096);
+    struct Clock {
+        uint64_t m_Cycles = 0;
+        uint64_t GetCycles() const { return m_Cycles; }
+    } clock;
+    device->Attach(clock);
+
+    uint32_t lag = 0;
+    for(uint32_t i = 0; i < 2000; i++) {
+        clock.m_Cycles += 10;
+        device->WriteByte(0xD000, i);
+        lag = max(lag, i + 1 - slow->m_Count.load());
+    }
+    device->Sync();
+    EXPECT_LE(lag, 12u);
+}
+
+TEST(ThreadedDevice, ThrowsDeviceErrorsOnTheCpuThread) {
+    const auto slow = make_shared<Slow>(0);
+    const auto device = ThreadedDevice::Make(slow);
+    device->WriteByte(0xD0FF, 1);
+    try {
+        device->ReadByte(0xD001);
+        FAIL() << "the error wasn't thrown again";
+    }
+    catch(const runtime_error& error) {
+        EXPECT_STREQ(error.what(), "bad register");
+    }
+    EXPECT_THROW(device->WriteByte(0xD000, 1), runtime_error) << "the device stays failed";
+}
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include <cpu_core.h>
+#include <machine.h>
+#include <memory.h>
+#include <timing.h>
+#include "helpers.h"
+
+namespace {
+
+    struct Access {
+        uint64_t m_Cycle;
+        Word m_Addr;
+        Byte m_Value;
+        bool m_Write;
+    };
+
+    bool operator==(const Access& a, const Access& b) {
+        return a.m_Cycle == b.m_Cycle && a.m_Addr == b.m_Addr && a.m_Value == b.m_Value && a.m_Write == b.m_Write;
+    }
+
+    //64 KB of RAM logging every byte access, on the cycle `m_Now` tells
+    struct LogBus {
+        Byte m_Data[0x10000];
+        vector<Access> m_Log;
+        function<uint64_t()> m_Now;
+
+        uint64_t Now() const { return m_Now ? m_Now() : 0; }
+
+        Byte ReadByte(const address& addr) {
+            const Byte value = m_Data[addr.GetValue()];
+            m_Log.push_back({ Now(), addr.GetValue(), value, false });
+            return value;
+        }
+
+        Word ReadWord(const address& addr) { return MAKE_WORD(m_Data[static_cast<Word>(addr.GetValue() + 1)], m_Data[addr.GetValue()]); }
+
+        void WriteByte(const address& addr, const Byte value) {
+            m_Data[addr.GetValue()] = value;
+            m_Log.push_back({ Now(), addr.GetValue(), value, true });
+        }
+    };
+
+    template<typename Timing>
+    struct Rig {
+        LogBus m_Bus {};
+        CPUCore<LogBus, NoTrace, Timing> m_Core { m_Bus };
+
+        Rig() { m_Bus.m_Now = [this] { return m_Core.GetCycles(); }; }
+    };
+
+    //An IRQ held for 40 cycles every 777, through whichever core the host drives at the time
+    struct Host {
+        function<void(bool)> m_Line;
+        function<uint64_t()> m_Now;
+        function<void(uint64_t, function<void()>)> m_Schedule;
+
+        template<typename Core>
+        void Bind(Core& core) {
+            m_Line = [&core](const bool on) { if(on) core.AssertIRQ(); else core.ReleaseIRQ(); };
+            m_Now = [&core] { return core.GetCycles(); };
+            m_Schedule = [&core](const uint64_t deadline, function<void()> event) { core.Schedule(deadline, std::move(event)); };
+        }
+
+        template<typename Core>
+        void Start(Core& core) {
+            Bind(core);
+            core.Reset();
+            for(uint64_t deadline = 1000; deadline < 200000; deadline += 777) {
+                core.Schedule(deadline, [this] {
+                    m_Line(true);
+                    m_Schedule(m_Now() + 40, [this] { m_Line(false); });
+                });
+            }
+        }
+    };
+
+    //Steps one instruction at `pc` from cycle 100 on a cycle-exact core : the accesses must come on
+    //consecutive cycles, as listed (their m_Cycle is the offset from the start)
+    void ExpectAccesses(const vector<Byte>& program, const Word pc, const vector<pair<Word, Byte>>& ram, const vector<Access>& expected) {
+        const auto rig = make_unique<Rig<CycleExact>>();
+        for(size_t i = 0; i < program.size(); i++) rig->m_Bus.m_Data[static_cast<Word>(pc + i)] = program[i];
+        for(const auto& [addr, value] : ram) rig->m_Bus.m_Data[addr] = value;
+
+        Registers registers {};
+        registers.m_PC = pc;
+        registers.m_SP = 0xF0;
+        registers.m_X = 0x10;
+        registers.m_Y = 0x20;
+        registers.m_CpuStatus = 0x20;
+        rig->m_Core.SetRegisters(registers);
+        rig->m_Core.SetCycles(100);
+
+        EXPECT_EQ(rig->m_Core.Step(), expected.size());
+        vector<Access> log = rig->m_Bus.m_Log;
+        for(Access& access : log) access.m_Cycle -= 100;
+        vector<Access> cycles = expected;
+        for(size_t i = 0; i < cycles.size(); i++) cycles[i].m_Cycle = i;
+        EXPECT_EQ(log, cycles);
+    }
+}
+
+TEST(Timing, CycleExactMatchesFastTimingOnEveryOpcode) {
+    mt19937 rng(1);
+    vector<Byte> noise(0x10000);
+    const auto fast = make_unique<Rig<FastTiming>>();
+    const auto exact = make_unique<Rig<CycleExact>>();
+
+    for(int code = 0; code < 256; code++) {
+        for(int n = 0; n < 30; n++) {
+            if(n % 10 == 0) for(Byte& byte : noise) byte = rng();
+            memcpy(fast->m_Bus.m_Data, noise.data(), noise.size());
+            memcpy(exact->m_Bus.m_Data, noise.data(), noise.size());
+
+            Registers registers = RandomRegisters(rng);
+            registers.m_CpuStatus = static_cast<Byte>(rng());
+            fast->m_Bus.m_Data[registers.m_PC] = exact->m_Bus.m_Data[registers.m_PC] = code;
+            fast->m_Core.SetRegisters(registers);
+            exact->m_Core.SetRegisters(registers);
+            fast->m_Core.SetCycles(1000);
+            exact->m_Core.SetCycles(1000);
+            fast->m_Bus.m_Log.clear();
+            exact->m_Bus.m_Log.clear();
+
+            const Byte cycles = exact->m_Core.Step();
+            ASSERT_EQ(fast->m_Core.Step(), cycles) << hex << code;
+            ASSERT_EQ(exact->m_Core.GetCycles(), 1000u + cycles) << hex << code;
+            ASSERT_EQ(exact->m_Bus.m_Log.size(), cycles) << "one access per cycle, opcode " << hex << code;
+            for(size_t i = 0; i < cycles; i++) ASSERT_EQ(exact->m_Bus.m_Log[i].m_Cycle, 1000 + i) << hex << code;
+            ASSERT_TRUE(fast->m_Core.GetRegisters() == exact->m_Core.GetRegisters()) << hex << code;
+            ASSERT_EQ(memcmp(fast->m_Bus.m_Data, exact->m_Bus.m_Data, sizeof(LogBus::m_Data)), 0) << hex << code;
+
+            //The fast accesses are the ones carrying data, a subsequence of the exact ones (JSR pushes before its last fetch)
+            if(code == 0x20) continue;
+            size_t matched = 0;
+            for(const Access& access : exact->m_Bus.m_Log) {
+                if(matched == fast->m_Bus.m_Log.size()) break;
+                const Access& next = fast->m_Bus.m_Log[matched];
+                if(access.m_Addr == next.m_Addr && access.m_Write == next.m_Write && access.m_Value == next.m_Value) matched++;
+            }
+            ASSERT_EQ(matched, fast->m_Bus.m_Log.size()) << hex << code;
+        }
+    }
+}
+
+TEST(Timing, PerformsTheDummyAccesses) {
+    //X = $10, Y = $20, SP = $F0
+    ExpectAccesses({ 0xFE, 0xF8, 0x12 }, 0x0300, { { 0x1308, 0x41 } },
+        { { 0, 0x0300, 0xFE, false }, { 0, 0x0301, 0xF8, false }, { 0, 0x0302, 0x12, false }, { 0, 0x1208, 0x00, false }, { 0, 0x1308, 0x41, false }, { 0, 0x1308, 0x41, true }, { 0, 0x1308, 0x42, true } });
+    ExpectAccesses({ 0xBD, 0x00, 0x12 }, 0x0300, { { 0x1210, 0x41 } },
+        { { 0, 0x0300, 0xBD, false }, { 0, 0x0301, 0x00, false }, { 0, 0x0302, 0x12, false }, { 0, 0x1210, 0x41, false } });
+    ExpectAccesses({ 0xB9, 0xF0, 0x12 }, 0x0300, { { 0x1310, 0x41 }, { 0x1210, 0x99 } },
+        { { 0, 0x0300, 0xB9, false }, { 0, 0x0301, 0xF0, false }, { 0, 0x0302, 0x12, false }, { 0, 0x1210, 0x99, false }, { 0, 0x1310, 0x41, false } });
+    ExpectAccesses({ 0x9D, 0x00, 0x12 }, 0x0300, {},
+        { { 0, 0x0300, 0x9D, false }, { 0, 0x0301, 0x00, false }, { 0, 0x0302, 0x12, false }, { 0, 0x1210, 0x00, false }, { 0, 0x1210, 0x00, true } });
+    ExpectAccesses({ 0x91, 0x40 }, 0x0300, { { 0x40, 0xF0 }, { 0x41, 0x12 } },
+        { { 0, 0x0300, 0x91, false }, { 0, 0x0301, 0x40, false }, { 0, 0x0040, 0xF0, false }, { 0, 0x0041, 0x12, false }, { 0, 0x1210, 0x00, false }, { 0, 0x1310, 0x00, true } });
+    ExpectAccesses({ 0xA1, 0x40 }, 0x0300, { { 0x50, 0x34 }, { 0x51, 0x12 }, { 0x1234, 0x07 } },
+        { { 0, 0x0300, 0xA1, false }, { 0, 0x0301, 0x40, false }, { 0, 0x0040, 0x00, false }, { 0, 0x0050, 0x34, false }, { 0, 0x0051, 0x12, false }, { 0, 0x1234, 0x07, false } });
+    ExpectAccesses({ 0xB5, 0x40 }, 0x0300, { { 0x50, 0x09 } },
+        { { 0, 0x0300, 0xB5, false }, { 0, 0x0301, 0x40, false }, { 0, 0x0040, 0x00, false }, { 0, 0x0050, 0x09, false } });
+    ExpectAccesses({ 0x06, 0x40 }, 0x0300, { { 0x40, 0x81 } },
+        { { 0, 0x0300, 0x06, false }, { 0, 0x0301, 0x40, false }, { 0, 0x0040, 0x81, false }, { 0, 0x0040, 0x81, true }, { 0, 0x0040, 0x02, true } });
+}
+
+TEST(Timing, PerformsTheStackAndControlFlowAccesses) {
+    ExpectAccesses({ 0x20, 0x34, 0x12 }, 0x0300, {},
+        { { 0, 0x0300, 0x20, false }, { 0, 0x0301, 0x34, false }, { 0, 0x01F0, 0x00, false }, { 0, 0x01F0, 0x03, true }, { 0, 0x01EF, 0x02, true }, { 0, 0x0302, 0x12, false } });
+    ExpectAccesses({ 0x60 }, 0x0300, { { 0x1F1, 0x02 }, { 0x1F2, 0x05 } },
+        { { 0, 0x0300, 0x60, false }, { 0, 0x0301, 0x00, false }, { 0, 0x01F0, 0x00, false }, { 0, 0x01F1, 0x02, false }, { 0, 0x01F2, 0x05, false }, { 0, 0x0502, 0x00, false } });
+    ExpectAccesses({ 0x68 }, 0x0300, { { 0x1F1, 0x77 } },
+        { { 0, 0x0300, 0x68, false }, { 0, 0x0301, 0x00, false }, { 0, 0x01F0, 0x00, false }, { 0, 0x01F1, 0x77, false } });
+    ExpectAccesses({ 0x48 }, 0x0300, {},
+        { { 0, 0x0300, 0x48, false }, { 0, 0x0301, 0x00, false }, { 0, 0x01F0, 0x00, true } });
+    ExpectAccesses({ 0xD0, 0x10 }, 0x03F0, {},
+        { { 0, 0x03F0, 0xD0, false }, { 0, 0x03F1, 0x10, false }, { 0, 0x03F2, 0x00, false }, { 0, 0x0302, 0x00, false } });
+    ExpectAccesses({ 0xD0, 0x02 }, 0x0300, {},
+        { { 0, 0x0300, 0xD0, false }, { 0, 0x0301, 0x02, false }, { 0, 0x0302, 0x00, false } });
+    ExpectAccesses({ 0xF0, 0x02 }, 0x0300, {},
+        { { 0, 0x0300, 0xF0, false }, { 0, 0x0301, 0x02, false } });
+    ExpectAccesses({ 0x00, 0x00 }, 0x0300, { { 0xFFFE, 0x00 }, { 0xFFFF, 0x80 } },
+        { { 0, 0x0300, 0x00, false }, { 0, 0x0301, 0x00, false }, { 0, 0x01F0, 0x03, true }, { 0, 0x01EF, 0x02, true }, { 0, 0x01EE, 0x30, true }, { 0, 0xFFFE, 0x00, false }, { 0, 0xFFFF, 0x80, false } });
+    ExpectAccesses({ 0x40 }, 0x0300, { { 0x1F1, 0x00 }, { 0x1F2, 0x34 }, { 0x1F3, 0x12 } },
+        { { 0, 0x0300, 0x40, false }, { 0, 0x0301, 0x00, false }, { 0, 0x01F0, 0x00, false }, { 0, 0x01F1, 0x00, false }, { 0, 0x01F2, 0x34, false }, { 0, 0x01F3, 0x12, false } });
+    //The page wrap of JMP ($10FF)
+    ExpectAccesses({ 0x6C, 0xFF, 0x10 }, 0x0300, { { 0x10FF, 0x34 }, { 0x1000, 0x12 } },
+        { { 0, 0x0300, 0x6C, false }, { 0, 0x0301, 0xFF, false }, { 0, 0x0302, 0x10, false }, { 0, 0x10FF, 0x34, false }, { 0, 0x1000, 0x12, false } });
+}
+
+TEST(Timing, EntersInterruptsOnConsecutiveCycles) {
+    const auto rig = make_unique<Rig<CycleExact>>();
+    memset(rig->m_Bus.m_Data, 0xEA, sizeof(LogBus::m_Data));
+    rig->m_Bus.m_Data[0xFFFA] = 0x00;
+    rig->m_Bus.m_Data[0xFFFB] = 0x90;
+    Registers registers = StartAt(0x0400);
+    registers.m_CpuStatus = 0x24;
+    rig->m_Core.SetRegisters(registers);
+    rig->m_Core.SetCycles(50);
+    rig->m_Core.TriggerNMI();
+
+    //The NMI, then the NOP of its handler
+    EXPECT_EQ(rig->m_Core.Step(), 9);
+    const vector<Access>& log = rig->m_Bus.m_Log;
+    ASSERT_EQ(log.size(), 9u);
+    EXPECT_EQ(log[0].m_Addr, 0x0400);
+    EXPECT_EQ(log[1].m_Addr, 0x0400);
+    EXPECT_TRUE(log[2].m_Write);
+    EXPECT_EQ(log[5].m_Addr, 0xFFFA);
+    EXPECT_EQ(log[7].m_Addr, 0x9000);
+    EXPECT_EQ(log[8].m_Cycle, 58u);
+}
+
+TEST(Timing, RunsAgreeAcrossPoliciesAndTakeOver) {
+    //$0400 : CLI ; loop : INC $10 ; LDA $10 ; STA $1234,X ; INX ; JSR $0500 ; JMP loop
+    //$0500 : PHA ; PLA ; ROL $20,X ; RTS    IRQ : INC $11 ; RTI
+    const auto boot = [](LogBus& bus) {
+        Load(bus, 0x0400, { 0x58, 0xE6, 0x10, 0xA5, 0x10, 0x9D, 0x34, 0x12, 0xE8, 0x20, 0x00, 0x05, 0x4C, 0x01, 0x04 });
+        Load(bus, 0x0500, { 0x48, 0x68, 0x36, 0x20, 0x60 });
+        Load(bus, 0x0600, { 0xE6, 0x11, 0x40 });
+        Load(bus, 0xFFFC, { 0x00, 0x04, 0x00, 0x06 });
+        bus.m_Log.clear();
+    };
+    const auto fast = make_unique<Rig<FastTiming>>();
+    const auto exact = make_unique<Rig<CycleExact>>();
+    boot(fast->m_Bus);
+    boot(exact->m_Bus);
+    Host fastHost;
+    Host exactHost;
+    fastHost.Start(fast->m_Core);
+    exactHost.Start(exact->m_Core);
+    fast->m_Core.RunFor(100000);
+    fast->m_Core.Run(5000);
+    fast->m_Core.RunFor(50000);
+    exact->m_Core.RunFor(100000);
+    exact->m_Core.Run(5000);
+    exact->m_Core.RunFor(50000);
+
+    EXPECT_EQ(fast->m_Core.GetCycles(), exact->m_Core.GetCycles());
+    EXPECT_EQ(memcmp(fast->m_Bus.m_Data, exact->m_Bus.m_Data, sizeof(LogBus::m_Data)), 0);
+    EXPECT_GT(exact->m_Bus.m_Data[0x11], 100) << "the IRQs were taken";
+    for(size_t i = 1; i < exact->m_Bus.m_Log.size(); i++) ASSERT_GT(exact->m_Bus.m_Log[i].m_Cycle, exact->m_Bus.m_Log[i - 1].m_Cycle);
+
+    //Fast, cycle-exact through TakeOver for a while, fast again : the same run. The events move over with the core.
+    const auto switched = make_unique<Rig<FastTiming>>();
+    boot(switched->m_Bus);
+    CPUCore<LogBus, NoTrace, FastTiming>& first = switched->m_Core;
+    Host host;
+    host.Start(first);
+    first.RunFor(100000);
+
+    CPUCore<LogBus, NoTrace, CycleExact> second(switched->m_Bus);
+    second.TakeOver(first);
+    host.Bind(second);
+    switched->m_Bus.m_Now = [&second] { return second.GetCycles(); };
+    second.Run(5000);
+    first.TakeOver(second);
+    host.Bind(first);
+    switched->m_Bus.m_Now = nullptr;
+    first.RunFor(50000);
+
+    EXPECT_EQ(first.GetCycles(), fast->m_Core.GetCycles());
+    EXPECT_EQ(memcmp(switched->m_Bus.m_Data, fast->m_Bus.m_Data, sizeof(LogBus::m_Data)), 0);
+}
+
+TEST(Timing, MachinesSwitchThroughSaveStates) {
+    const auto memory = make_shared<Memory>();
+    Machine<Memory> fast(memory);
+    Machine<Memory, NoTrace, CycleExact> exact(memory);
+    fast.SetRegisters(StartAt(0x1234));
+    exact.LoadState(fast.SaveState());
+    EXPECT_EQ(exact.GetProgramCounter(), 0x1234);
+}
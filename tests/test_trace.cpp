@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <cpu_core.h>
+#include <memory.h>
+#include <trace.h>
+#include "helpers.h"
+
+namespace {
+
+    //Keeps every record in memory, and feeds a RingTracer as well
+    struct Recorder {
+        static constexpr bool ENABLED = true;
+        RingTracer m_Ring;
+        vector<TraceRecord>* m_Records = nullptr;
+
+        void Record(const TraceRecord& record) {
+            m_Records->push_back(record);
+            m_Ring.Record(record);
+        }
+    };
+
+    bool operator==(const TraceRecord& a, const TraceRecord& b) {
+        return a.m_PC == b.m_PC && a.m_Addr == b.m_Addr && a.m_Opcode == b.m_Opcode && a.m_Acc == b.m_Acc && a.m_X == b.m_X
+            && a.m_Y == b.m_Y && a.m_SP == b.m_SP && a.m_Status == b.m_Status && a.m_Cycles == b.m_Cycles;
+    }
+}
+
+//Tracing doesn't change the run, and the trace file reads back every record, in order
+TEST(Trace, WritesAndReadsBackEveryInstruction) {
+    mt19937 rng(15);
+    const string path = ::testing::TempDir() + "emu6502_test.trace";
+    for(int round = 0; round < 3; round++) {
+        SCOPED_TRACE(round);
+        const vector<Byte> image = RandomImage(rng);
+        const Registers start = RandomRegisters(rng);
+        Memory traced_memory, memory;
+        copy(image.begin(), image.end(), traced_memory.GetData());
+        copy(image.begin(), image.end(), memory.GetData());
+
+        vector<TraceRecord> expected;
+        {
+            TraceWriter writer(path, 256);
+            CPUCore<Memory, Recorder> traced(traced_memory);
+            Recorder recorder;
+            recorder.m_Ring = writer.GetTracer();
+            recorder.m_Records = &expected;
+            traced.SetTracer(recorder);
+            CPUCore<Memory> reference(memory);
+            traced.SetRegisters(start);
+            reference.SetRegisters(start);
+
+            const uint64_t cycles = traced.Run(50000);
+            EXPECT_EQ(cycles, reference.Run(50000));
+            EXPECT_TRUE(equal(traced_memory.GetData(), traced_memory.GetData() + 0x10000, memory.GetData()));
+
+            uint64_t sum = 0;
+            for(const TraceRecord& record : expected) sum += record.m_Cycles;
+            EXPECT_EQ(sum, cycles);
+
+            writer.Close();
+            EXPECT_EQ(writer.GetRecordCount(), expected.size());
+        }
+
+        TraceReader reader(path);
+        TraceRecord record;
+        size_t count = 0;
+        while(reader.Next(record)) {
+            ASSERT_LT(count, expected.size());
+            ASSERT_TRUE(record == expected[count]) << "record " << count;
+            count++;
+        }
+        EXPECT_EQ(count, expected.size());
+    }
+}
+
+//The ring holds a power of 2 of records, refuses pushes once full and hands them back in order
+TEST(Trace, RingKeepsTheOrder) {
+    TraceRing ring(5);
+    ASSERT_EQ(ring.GetCapacity(), 8u);
+    EXPECT_TRUE(ring.IsEmpty());
+
+    TraceRecord record {};
+    for(Word pc = 0; pc < 8; pc++) {
+        record.m_PC = pc;
+        EXPECT_TRUE(ring.TryPush(record));
+    }
+    EXPECT_FALSE(ring.TryPush(record));
+
+    TraceRecord records[8];
+    ASSERT_EQ(ring.Pop(records, 3), 3u);
+    EXPECT_EQ(records[2].m_PC, 2);
+    record.m_PC = 8;
+    EXPECT_TRUE(ring.TryPush(record));
+    ASSERT_EQ(ring.Pop(records, 8), 6u);
+    for(size_t i = 0; i < 6; i++) EXPECT_EQ(records[i].m_PC, i + 3);
+    EXPECT_TRUE(ring.IsEmpty());
+}
+
+//Not a trace file
+TEST(Trace, ReaderRejectsOtherFiles) {
+    const string path = ::testing::TempDir() + "emu6502_not.trace";
+    ofstream(path) << "not a trace";
+    EXPECT_THROW(TraceReader reader(path), runtime_error);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+#include "hosts.h"
+#include "workloads.h"
+
+//The guest programs of emu6502_bench compute what they claim, on every benchmarked core,
+//and Run() retires the cycles stepping the interpreter does
+template<typename Host>
+class Workloads : public ::testing::Test {};
+
+using Hosts = ::testing::Types<InterpreterHost, CycleExactHost, AdapterHost, JitHost>;
+TYPED_TEST_SUITE(Workloads, Hosts);
+
+TYPED_TEST(Workloads, SieveCountsThePrimes) {
+    const auto host = make_unique<TypeParam>();
+    host->Load(SIEVE.m_Origin, SIEVE.m_Image);
+    Start(*host, SIEVE.m_Origin);
+    host->m_Core.Run(2000000);
+    EXPECT_EQ(MAKE_WORD(host->Peek(0x0201), host->Peek(0x0200)), PRIME_COUNT);
+}
+
+TYPED_TEST(Workloads, MemcpyCopiesThePages) {
+    const auto host = make_unique<TypeParam>();
+    vector<Byte> pattern(0x1000);
+    for(size_t i = 0; i < pattern.size(); i++) pattern[i] = i * 7 + (i >> 8);
+    host->Load(0x4000, pattern);
+    host->Load(MEMCPY.m_Origin, MEMCPY.m_Image);
+    Start(*host, MEMCPY.m_Origin);
+    host->m_Core.Run(100000);
+    for(size_t i = 0; i < pattern.size(); i++) ASSERT_EQ(host->Peek(0x6000 + i), pattern[i]) << i;
+}
+
+TYPED_TEST(Workloads, RunCountsLikeStepping) {
+    for(const Workload* workload : { &SIEVE, &MEMCPY, &OPCODE_MIX }) {
+        SCOPED_TRACE(workload->m_Name);
+        const auto host = make_unique<TypeParam>();
+        const auto reference = make_unique<InterpreterHost>();
+        host->Load(workload->m_Origin, workload->m_Image);
+        reference->Load(workload->m_Origin, workload->m_Image);
+        Start(*host, workload->m_Origin);
+        Start(*reference, workload->m_Origin);
+
+        uint64_t cycles = 0, expected = 0;
+        for(int slice = 0; slice < 4; slice++) {
+            cycles += host->m_Core.Run(50000);
+            for(int i = 0; i < 50000; i++) expected += reference->m_Core.Step();
+        }
+        EXPECT_EQ(cycles, expected);
+        EXPECT_EQ(host->m_Core.GetProgramCounter(), reference->m_Core.GetProgramCounter());
+    }
+}
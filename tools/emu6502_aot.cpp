@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <recompiler.h>
+
+using namespace std;
+
+//emu6502-aot : recompiles a ROM image into C++ (see Recompiler and AotCPU)
+//
+//  emu6502-aot <image> --base <addr> [--entry <addr>]... [--name <symbol>] [--bus <type>] [-o <file>]
+//
+//Addresses are hexadecimal ($C000, 0xC000 or C000). Without --entry, the NMI / RESET / IRQ vectors
+//found in the image are used.
+
+static void Usage() {
+    cerr << "usage : emu6502-aot <image> --base <addr> [--entry <addr>]... [--name <symbol>] [--bus <type>] [-o <file>]" << endl;
+}
+
+static Word ParseAddress(string text) {
+    if(!text.empty() && text[0] == '$') text.erase(0, 1);
+    size_t end = 0;
+    const unsigned long value = stoul(text, &end, 16);
+    if(end != text.size() || value > 0xFFFF) throw invalid_argument("Invalid address : " + text);
+    return static_cast<Word>(value);
+}
+
+int main(int argc, char** argv) {
+
+    string input, output, name = "program", bus = "Bus";
+    long base = -1;
+    vector<Word> entries;
+
+    try {
+        for(int i = 1; i < argc; i++) {
+            const string arg = argv[i];
+            auto value = [&]() -> string {
+                if(i + 1 >= argc) throw invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if(arg == "--base") base = ParseAddress(value());
+            else if(arg == "--entry") entries.push_back(ParseAddress(value()));
+            else if(arg == "--name") name = value();
+            else if(arg == "--bus") bus = value();
+            else if(arg == "-o") output = value();
+            else if(input.empty() && arg[0] != '-') input = arg;
+            else throw invalid_argument("Unknown argument : " + arg);
+        }
+        if(input.empty() || base < 0) {
+            Usage();
+            return EXIT_FAILURE;
+        }
+
+        ifstream file(input, ios::binary);
+        if(!file) throw runtime_error("Can't open " + input);
+        vector<Byte> image((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        Recompiler recompiler(std::move(image), static_cast<Word>(base));
+        for(const Word entry : entries) recompiler.AddEntryPoint(entry);
+        if(entries.empty()) recompiler.AddVectors();
+        if(recompiler.GetEntryPoints().empty()) throw runtime_error("No entry point given, and no vector points into the image");
+
+        recompiler.Analyze();
+
+        if(output.empty()) {
+            recompiler.Emit(cout, name, bus);
+        }
+        else {
+            ofstream out(output);
+            if(!out) throw runtime_error("Can't write " + output);
+            recompiler.Emit(out, name, bus);
+        }
+
+        cerr << input << " : " << recompiler.GetBlocks().size() << " blocks recompiled" << endl;
+    }
+    catch(const exception& e) {
+        cerr << "emu6502-aot : " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <opcodes.h>
+#include <trace.h>
+
+using namespace std;
+
+//emu6502-trace : converts a trace file (see TraceWriter) to text, one instruction per line
+//
+//  emu6502-trace <trace> [-o <file>]
+//
+//  CYCLE           PC    OP  INS   A  X  Y  SP P         ADDR  +CYC
+
+static void Usage() {
+    cerr << "usage : emu6502-trace <trace> [-o <file>]" << endl;
+}
+
+//NV-BDIZC, lowercase when clear
+static string Flags(const Byte status) {
+    static constexpr char NAMES[] = "CZIDBUVN";
+    string flags(8, ' ');
+    for(int bit = 0; bit < 8; bit++) {
+        const char name = bit == 5 ? '-' : NAMES[bit];
+        flags[7 - bit] = status & (1 << bit) ? name : static_cast<char>(tolower(name));
+    }
+    return flags;
+}
+
+int main(int argc, char** argv) {
+
+    string input, output;
+
+    try {
+        for(int i = 1; i < argc; i++) {
+            const string arg = argv[i];
+            if(arg == "-o") {
+                if(i + 1 >= argc) throw invalid_argument("Missing value for " + arg);
+                output = argv[++i];
+            }
+            else if(input.empty() && arg[0] != '-') input = arg;
+            else throw invalid_argument("Unknown argument : " + arg);
+        }
+        if(input.empty()) {
+            Usage();
+            return EXIT_FAILURE;
+        }
+
+        FILE* out = output.empty() ? stdout : fopen(output.c_str(), "w");
+        if(!out) throw runtime_error("Can't write " + output);
+
+        TraceReader reader(input);
+        TraceRecord record;
+        uint64_t cycle = 0;
+        uint64_t count = 0;
+
+        while(reader.Next(record)) {
+            const string_view name = INSTRUCTION_NAMES[static_cast<size_t>(OPCODES[record.m_Opcode].m_Instruction)];
+            fprintf(out, "%-15llu %04X  %02X  %.*s  %02X %02X %02X %02X %s  %04X  +%u\n",
+                    static_cast<unsigned long long>(cycle), record.m_PC, record.m_Opcode, static_cast<int>(name.size()), name.data(),
+                    record.m_Acc, record.m_X, record.m_Y, record.m_SP, Flags(record.m_Status).c_str(), record.m_Addr, record.m_Cycles);
+            cycle += record.m_Cycles;
+            count++;
+        }
+
+        if(out != stdout) fclose(out);
+        cerr << input << " : " << count << " instructions, " << cycle << " cycles" << endl;
+    }
+    catch(const exception& e) {
+        cerr << "emu6502-trace : " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}